@@ -0,0 +1,51 @@
+#pragma once
+
+#include <bx/engine/core/byte_types.hpp>
+#include <bx/engine/core/math.hpp>
+#include <bx/engine/containers/list.hpp>
+
+class Mesh;
+
+constexpr u32 MESH_OPTIMIZER_CACHE_SIZE = 16;
+constexpr u32 MESH_OPTIMIZER_UNUSED = 0xFFFFFFFF;
+
+struct MeshCacheStats
+{
+	// Average cache miss ratio, transformed vertices per triangle (0.5 is the ideal for large grids)
+	f32 acmr = 0.0f;
+	// Average transform to vertex ratio, transformed vertices per unique vertex (1.0 is ideal)
+	f32 atvr = 0.0f;
+};
+
+class MeshOptimizer
+{
+public:
+	// Runs every stage below on the mesh and logs the cache statistics before and after
+	static void Optimize(Mesh& mesh);
+
+	// Reorders triangles for the post-transform vertex cache using Tipsify.
+	// Writes the cluster start offsets (in triangles) that the overdraw pass can reorder.
+	static void OptimizeVertexCache(List<u32>& indices, u32 vertexCount, u32 cacheSize, List<u32>& clusters);
+
+	// Reorders clusters front to back along their average normal so early depth rejection does more work.
+	// threshold limits how much ACMR may degrade (e.g. 1.05) when clusters are split further.
+	static void OptimizeOverdraw(List<u32>& indices, const List<Vec3>& positions, const List<u32>& clusters, u32 cacheSize, f32 threshold);
+
+	// Renumbers vertices in order of first use so fetches stream linearly, unused vertices are dropped.
+	// Returns the new vertex count, remap[old] is the new index or MESH_OPTIMIZER_UNUSED.
+	static u32 OptimizeVertexFetch(List<u32>& indices, u32 vertexCount, List<u32>& remap);
+
+	static MeshCacheStats AnalyzeVertexCache(const List<u32>& indices, u32 vertexCount, u32 cacheSize);
+
+	template <typename T>
+	static List<T> RemapVertices(const List<T>& vertices, const List<u32>& remap, u32 newCount)
+	{
+		List<T> result(newCount);
+		for (SizeType i = 0; i < vertices.size(); ++i)
+		{
+			if (remap[i] != MESH_OPTIMIZER_UNUSED)
+				result[remap[i]] = vertices[i];
+		}
+		return result;
+	}
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <bx/engine/core/byte_types.hpp>
+#include <bx/engine/containers/string.hpp>
+#include <bx/engine/modules/graphics.hpp>
+
+class Texture;
+
+// Texels per block side of the BC formats
+constexpr u32 TEXTURE_COMPRESSOR_BLOCK_SIZE = 4;
+
+class TextureCompressor
+{
+public:
+	// Generates mips and block compresses an imported RGBA8 texture, in the format ChooseFormat picks
+	static void Compress(Texture& texture, const String& filename);
+
+	// BC5 for normal maps, BC7 when any texel is translucent and BC1 otherwise. Sizes that are not
+	// a multiple of the block size stay RGBA8 since not every driver accepts partial blocks.
+	static TextureFormat ChooseFormat(const Texture& texture, bool isNormalMap);
+
+	// Guesses from the name, e.g. "brick_n.png", "brick_normal.png" or "brick_nrm.png"
+	static bool IsNormalMap(const String& filename);
+
+	// Replaces the RGBA8 base level with the full chain down to 1x1, returns the level count.
+	// Color is filtered in sRGB space, linear textures (normal maps) are filtered as is and renormalized.
+	static u32 GenerateMips(Texture& texture, bool isLinear);
+
+	// Encodes every RGBA8 level of the texture, returns false for formats without an encoder
+	static bool Encode(Texture& texture, TextureFormat format);
+
+	// Block encoders, pBlock is 4x4 RGBA8 texels in rows
+	static void EncodeBC1(const u8* pBlock, u8* pDst);
+	static void EncodeBC3(const u8* pBlock, u8* pDst);
+	static void EncodeBC5(const u8* pBlock, u8* pDst);
+	static void EncodeBC7(const u8* pBlock, u8* pDst);
+};
\ No newline at end of file
@@ -1,96 +1,466 @@
 #pragma once
 
-/*
-#include "Engine/Core/Math.hpp"
-#include "Engine/Containers/List.hpp"
+#include "bx/engine/core/byte_types.hpp"
+#include "bx/engine/core/macros.hpp"
+#include "bx/engine/core/math.hpp"
+#include "bx/engine/containers/array.hpp"
+#include "bx/engine/containers/list.hpp"
 
-#include <unordered_set>
+#include <cmath>
+#include <unordered_map>
 
-struct GridCell
+using GridMapHandle = u32;
+constexpr GridMapHandle INVALID_GRIDMAP_HANDLE = 0xFFFFFFFF;
+
+// Cell coordinates are packed 21 bits per axis into a single 64 bit key
+constexpr i32 GRIDMAP_COORD_BITS = 21;
+constexpr i32 GRIDMAP_COORD_BIAS = 1 << (GRIDMAP_COORD_BITS - 1);
+constexpr u64 GRIDMAP_COORD_MASK = (u64(1) << GRIDMAP_COORD_BITS) - 1;
+
+struct GridCoord
+{
+	i32 x = 0;
+	i32 y = 0;
+	i32 z = 0;
+};
+
+struct GridRange
 {
-    std::unordered_set<SizeType> indices;
+	GridCoord min;
+	GridCoord max;
+
+	inline bool Contains(i32 x, i32 y, i32 z) const
+	{
+		return x >= min.x && x <= max.x
+			&& y >= min.y && y <= max.y
+			&& z >= min.z && z <= max.z;
+	}
+
+	inline u64 Volume() const
+	{
+		return u64(max.x - min.x + 1) * u64(max.y - min.y + 1) * u64(max.z - min.z + 1);
+	}
+
+	inline bool operator==(const GridRange& other) const
+	{
+		return min.x == other.min.x && min.y == other.min.y && min.z == other.min.z
+			&& max.x == other.max.x && max.y == other.max.y && max.z == other.max.z;
+	}
+
+	inline bool operator!=(const GridRange& other) const
+	{
+		return !(*this == other);
+	}
 };
 
-template <typename T>
+// Packed cell coordinates are mostly sequential, mix them so buckets spread evenly
+struct GridCellKeyHash
+{
+	inline SizeType operator()(u64 key) const
+	{
+		key ^= key >> 30;
+		key *= 0xBF58476D1CE4E5B9ull;
+		key ^= key >> 27;
+		key *= 0x94D049BB133111EBull;
+		key ^= key >> 31;
+		return static_cast<SizeType>(key);
+	}
+};
+
+// Unbounded spatial hash over a uniform 3D grid. Entries are boxes that are
+// registered in every cell they touch. Cells are allocated on demand and kept
+// in SoA form: the first InlineCount handles of a cell live in a fixed array,
+// anything beyond spills into a per-cell overflow list.
+template <typename T, SizeType InlineCount = 8>
 class GridMap
 {
 public:
-    GridMap(f32 width, f32 height, f32 cellSize)
-        : m_width(width)
-        , m_height(height)
-        , m_cellSize(cellSize)
-    {
-        m_numCols = static_cast<i32>(width / cellSize);
-        m_numRows = static_cast<i32>(height / cellSize);
-        m_cells.resize(numRows * numCols);
-    }
-
-    inline void Insert(const T& data, const Vec3& pos, const Box3& box)
-    {
-        i32 minX = static_cast<i32>(pos.x + box.min.x / m_cellSize);
-        i32 maxX = static_cast<i32>(pos.x + box.max.x / m_cellSize);
-        i32 minY = static_cast<i32>(pos.y + box.min.y / m_cellSize);
-        i32 maxY = static_cast<i32>(pos.y + box.max.y / m_cellSize);
-        i32 minZ = static_cast<i32>(pos.z + box.min.z / m_cellSize);
-        i32 maxZ = static_cast<i32>(pos.z + box.max.z / m_cellSize);
-
-        for (i32 z = minZ; z <= maxZ; ++z)
-        {
-            for (i32 y = minY; y <= maxY; ++y)
-            {
-                for (i32 x = minX; x <= maxX; ++x)
-                {
-                    m_data.emplace_back(data);
-                    auto& cell = m_cells[GetCellIndex(x, y, z)];
-                    cell.indices.insert(m_data.size() - 1);
-                }
-            }
-        }
-    }
-
-    inline const List<T>& Query(const Box3& box) const
-    {
-        std::unordered_set<SizeType> result;
-
-        i32 minX = static_cast<i32>(pos.x + box.min.x / m_cellSize);
-        i32 maxX = static_cast<i32>(pos.x + box.max.x / m_cellSize);
-        i32 minY = static_cast<i32>(pos.y + box.min.y / m_cellSize);
-        i32 maxY = static_cast<i32>(pos.y + box.max.y / m_cellSize);
-        i32 minZ = static_cast<i32>(pos.z + box.min.z / m_cellSize);
-        i32 maxZ = static_cast<i32>(pos.z + box.max.z / m_cellSize);
-
-        for (i32 z = minZ; z <= maxZ; ++z)
-        {
-            for (i32 y = minY; y <= maxY; ++y)
-            {
-                for (i32 x = minX; x <= maxX; ++x)
-                {
-                    const GridCell& cell = m_cells[GetCellIndex(x, y, z)];
-                    for (SizeType index : cell.indices)
-                    {
-                        uniqueResults.insert(index);
-                    }
-                }
-            }
-        }
-
-        m_query.assign(result.begin(), result.end());
-        return m_query;
-    }
+	explicit GridMap(f32 cellSize = 1.0f)
+	{
+		SetCellSize(cellSize);
+	}
+
+	inline f32 GetCellSize() const { return m_cellSize; }
+	inline SizeType GetCount() const { return m_data.size() - m_freeSlots.size(); }
+	inline SizeType GetCellCount() const { return m_cellLookup.size(); }
+
+	// Changing the cell size re-buckets every live entry
+	inline void SetCellSize(f32 cellSize)
+	{
+		BX_ASSERT(cellSize > 0.0f, "Grid cell size must be positive!");
+
+		m_cellSize = cellSize;
+		m_invCellSize = 1.0f / cellSize;
+
+		ClearCells();
+		for (SizeType i = 0; i < m_data.size(); ++i)
+		{
+			if (!m_alive[i])
+				continue;
+
+			m_ranges[i] = GetRange(m_bounds[i]);
+			AddToRange(static_cast<GridMapHandle>(i), m_ranges[i]);
+		}
+	}
+
+	inline void Clear()
+	{
+		m_data.clear();
+		m_bounds.clear();
+		m_ranges.clear();
+		m_alive.clear();
+		m_stamps.clear();
+		m_freeSlots.clear();
+		ClearCells();
+	}
+
+	inline bool IsValid(GridMapHandle handle) const
+	{
+		return handle < m_alive.size() && m_alive[handle];
+	}
+
+	inline T& Get(GridMapHandle handle)
+	{
+		BX_ASSERT(IsValid(handle), "Invalid grid map handle!");
+		return m_data[handle];
+	}
+
+	inline const T& Get(GridMapHandle handle) const
+	{
+		BX_ASSERT(IsValid(handle), "Invalid grid map handle!");
+		return m_data[handle];
+	}
+
+	inline const Box3& GetBounds(GridMapHandle handle) const
+	{
+		BX_ASSERT(IsValid(handle), "Invalid grid map handle!");
+		return m_bounds[handle];
+	}
+
+	inline GridMapHandle Insert(const T& data, const Box3& bounds)
+	{
+		GridMapHandle handle;
+		if (!m_freeSlots.empty())
+		{
+			handle = m_freeSlots.back();
+			m_freeSlots.pop_back();
+
+			m_data[handle] = data;
+			m_bounds[handle] = bounds;
+			m_ranges[handle] = GetRange(bounds);
+			m_alive[handle] = 1;
+		}
+		else
+		{
+			handle = static_cast<GridMapHandle>(m_data.size());
+
+			m_data.emplace_back(data);
+			m_bounds.emplace_back(bounds);
+			m_ranges.emplace_back(GetRange(bounds));
+			m_alive.emplace_back(1);
+			m_stamps.emplace_back(0);
+		}
+
+		AddToRange(handle, m_ranges[handle]);
+		return handle;
+	}
+
+	inline void Remove(GridMapHandle handle)
+	{
+		BX_ASSERT(IsValid(handle), "Invalid grid map handle!");
+
+		RemoveFromRange(handle, m_ranges[handle]);
+
+		m_data[handle] = T{};
+		m_alive[handle] = 0;
+		m_freeSlots.emplace_back(handle);
+	}
+
+	// Only the cells entered or left are touched, an entry moving within
+	// its current cells costs a single bounds write
+	inline void Move(GridMapHandle handle, const Box3& bounds)
+	{
+		BX_ASSERT(IsValid(handle), "Invalid grid map handle!");
+
+		m_bounds[handle] = bounds;
+
+		const GridRange oldRange = m_ranges[handle];
+		const GridRange newRange = GetRange(bounds);
+		if (oldRange == newRange)
+			return;
+
+		for (i32 z = oldRange.min.z; z <= oldRange.max.z; ++z)
+			for (i32 y = oldRange.min.y; y <= oldRange.max.y; ++y)
+				for (i32 x = oldRange.min.x; x <= oldRange.max.x; ++x)
+					if (!newRange.Contains(x, y, z))
+						CellRemove(MakeKey(x, y, z), handle);
+
+		for (i32 z = newRange.min.z; z <= newRange.max.z; ++z)
+			for (i32 y = newRange.min.y; y <= newRange.max.y; ++y)
+				for (i32 x = newRange.min.x; x <= newRange.max.x; ++x)
+					if (!oldRange.Contains(x, y, z))
+						CellAdd(MakeKey(x, y, z), handle);
+
+		m_ranges[handle] = newRange;
+	}
+
+	// Calls fn(handle, data) once for every entry whose bounds overlap box
+	template <typename TFn>
+	inline void ForEach(const Box3& box, TFn&& fn) const
+	{
+		const u32 stamp = NextStamp();
+		ForEachCandidate(GetRange(box), [&](GridMapHandle handle)
+			{
+				if (m_stamps[handle] == stamp)
+					return;
+				m_stamps[handle] = stamp;
+
+				if (m_bounds[handle].Overlaps(box))
+					fn(handle, m_data[handle]);
+			});
+	}
+
+	inline void Query(const Box3& box, List<GridMapHandle>& result) const
+	{
+		result.clear();
+		ForEach(box, [&](GridMapHandle handle, const T&)
+			{
+				result.emplace_back(handle);
+			});
+	}
+
+	// Batched neighbor lookup. Results are written in compressed rows:
+	// the neighbors of handles[i] are results[offsets[i]] .. results[offsets[i + 1] - 1].
+	// An entry is never reported as its own neighbor.
+	inline void QueryNeighbors(const List<GridMapHandle>& handles, f32 radius, List<u32>& offsets, List<GridMapHandle>& results) const
+	{
+		offsets.resize(handles.size() + 1);
+		results.clear();
+
+		const Vec3 extent(radius, radius, radius);
+		for (SizeType i = 0; i < handles.size(); ++i)
+		{
+			offsets[i] = static_cast<u32>(results.size());
+
+			const GridMapHandle self = handles[i];
+			BX_ASSERT(IsValid(self), "Invalid grid map handle!");
+
+			const Box3& bounds = m_bounds[self];
+			const Box3 box(bounds.min - extent, bounds.max + extent);
+			ForEach(box, [&](GridMapHandle handle, const T&)
+				{
+					if (handle != self)
+						results.emplace_back(handle);
+				});
+		}
+		offsets[handles.size()] = static_cast<u32>(results.size());
+	}
 
 private:
-    f32 m_width = 0;
-    f32 m_height = 0;
-    f32 m_cellSize = 0;
-    i32 m_numCols = 0;
-    i32 m_numRows = 0;
-    List<GridCell> m_cells;
-    List<T> m_data;
-    List<T> m_query;
-
-    SizeType GetCellIndex(i32 x, i32 y, i32 z)
-    {
-        return m_cells[z * m_numCols * m_numRows + y * m_numCols + x];
-    }
+	inline i32 ToCoord(f32 v) const
+	{
+		const f32 c = std::floor(v * m_invCellSize);
+		return static_cast<i32>(Math::Clamp(c, f32(-GRIDMAP_COORD_BIAS), f32(GRIDMAP_COORD_BIAS - 1)));
+	}
+
+	inline GridRange GetRange(const Box3& box) const
+	{
+		GridRange range;
+		range.min.x = ToCoord(box.min.x);
+		range.min.y = ToCoord(box.min.y);
+		range.min.z = ToCoord(box.min.z);
+		range.max.x = ToCoord(box.max.x);
+		range.max.y = ToCoord(box.max.y);
+		range.max.z = ToCoord(box.max.z);
+		return range;
+	}
+
+	static inline u64 MakeKey(i32 x, i32 y, i32 z)
+	{
+		return (u64(x + GRIDMAP_COORD_BIAS) & GRIDMAP_COORD_MASK)
+			| ((u64(y + GRIDMAP_COORD_BIAS) & GRIDMAP_COORD_MASK) << GRIDMAP_COORD_BITS)
+			| ((u64(z + GRIDMAP_COORD_BIAS) & GRIDMAP_COORD_MASK) << (GRIDMAP_COORD_BITS * 2));
+	}
+
+	static inline GridCoord GetKeyCoord(u64 key)
+	{
+		GridCoord coord;
+		coord.x = static_cast<i32>(key & GRIDMAP_COORD_MASK) - GRIDMAP_COORD_BIAS;
+		coord.y = static_cast<i32>((key >> GRIDMAP_COORD_BITS) & GRIDMAP_COORD_MASK) - GRIDMAP_COORD_BIAS;
+		coord.z = static_cast<i32>((key >> (GRIDMAP_COORD_BITS * 2)) & GRIDMAP_COORD_MASK) - GRIDMAP_COORD_BIAS;
+		return coord;
+	}
+
+	inline u32 NextStamp() const
+	{
+		if (++m_stamp == 0)
+		{
+			std::fill(m_stamps.begin(), m_stamps.end(), 0);
+			m_stamp = 1;
+		}
+		return m_stamp;
+	}
+
+	template <typename TFn>
+	inline void ForEachInCell(u32 cell, TFn&& fn) const
+	{
+		const u32 count = m_cellCounts[cell];
+		const u32 numInline = count < InlineCount ? count : static_cast<u32>(InlineCount);
+
+		const auto& inl = m_cellInline[cell];
+		for (u32 i = 0; i < numInline; ++i)
+			fn(inl[i]);
+
+		const auto& overflow = m_cellOverflow[cell];
+		for (u32 i = numInline; i < count; ++i)
+			fn(overflow[i - InlineCount]);
+	}
+
+	template <typename TFn>
+	inline void ForEachCandidate(const GridRange& range, TFn&& fn) const
+	{
+		// Large query volumes over a sparse grid are cheaper to answer by
+		// scanning the allocated cells than by probing every coordinate
+		if (range.Volume() > m_cellLookup.size())
+		{
+			for (u32 cell = 0; cell < m_cellKeys.size(); ++cell)
+			{
+				if (m_cellCounts[cell] == 0)
+					continue;
+
+				const GridCoord c = GetKeyCoord(m_cellKeys[cell]);
+				if (range.Contains(c.x, c.y, c.z))
+					ForEachInCell(cell, fn);
+			}
+			return;
+		}
+
+		for (i32 z = range.min.z; z <= range.max.z; ++z)
+		{
+			for (i32 y = range.min.y; y <= range.max.y; ++y)
+			{
+				for (i32 x = range.min.x; x <= range.max.x; ++x)
+				{
+					auto it = m_cellLookup.find(MakeKey(x, y, z));
+					if (it != m_cellLookup.end())
+						ForEachInCell(it->second, fn);
+				}
+			}
+		}
+	}
+
+	inline void AddToRange(GridMapHandle handle, const GridRange& range)
+	{
+		for (i32 z = range.min.z; z <= range.max.z; ++z)
+			for (i32 y = range.min.y; y <= range.max.y; ++y)
+				for (i32 x = range.min.x; x <= range.max.x; ++x)
+					CellAdd(MakeKey(x, y, z), handle);
+	}
+
+	inline void RemoveFromRange(GridMapHandle handle, const GridRange& range)
+	{
+		for (i32 z = range.min.z; z <= range.max.z; ++z)
+			for (i32 y = range.min.y; y <= range.max.y; ++y)
+				for (i32 x = range.min.x; x <= range.max.x; ++x)
+					CellRemove(MakeKey(x, y, z), handle);
+	}
+
+	inline void CellAdd(u64 key, GridMapHandle handle)
+	{
+		u32 cell;
+		auto it = m_cellLookup.find(key);
+		if (it != m_cellLookup.end())
+		{
+			cell = it->second;
+		}
+		else if (!m_freeCells.empty())
+		{
+			cell = m_freeCells.back();
+			m_freeCells.pop_back();
+			m_cellKeys[cell] = key;
+			m_cellLookup.insert(std::make_pair(key, cell));
+		}
+		else
+		{
+			cell = static_cast<u32>(m_cellKeys.size());
+			m_cellKeys.emplace_back(key);
+			m_cellCounts.emplace_back(0);
+			m_cellInline.emplace_back();
+			m_cellOverflow.emplace_back();
+			m_cellLookup.insert(std::make_pair(key, cell));
+		}
+
+		u32& count = m_cellCounts[cell];
+		if (count < InlineCount)
+			m_cellInline[cell][count] = handle;
+		else
+			m_cellOverflow[cell].emplace_back(handle);
+		++count;
+	}
+
+	inline GridMapHandle& CellAt(u32 cell, u32 index)
+	{
+		return index < InlineCount ? m_cellInline[cell][index] : m_cellOverflow[cell][index - InlineCount];
+	}
+
+	inline void CellRemove(u64 key, GridMapHandle handle)
+	{
+		auto it = m_cellLookup.find(key);
+		BX_ASSERT(it != m_cellLookup.end(), "Grid cell not found!");
+
+		const u32 cell = it->second;
+		u32& count = m_cellCounts[cell];
+		for (u32 i = 0; i < count; ++i)
+		{
+			if (CellAt(cell, i) != handle)
+				continue;
+
+			// Order within a cell is irrelevant, swap with the last one
+			CellAt(cell, i) = CellAt(cell, count - 1);
+			if (count > InlineCount)
+				m_cellOverflow[cell].pop_back();
+			--count;
+			break;
+		}
+
+		if (count == 0)
+		{
+			m_cellOverflow[cell].clear();
+			m_cellLookup.erase(it);
+			m_freeCells.emplace_back(cell);
+		}
+	}
+
+	inline void ClearCells()
+	{
+		m_cellKeys.clear();
+		m_cellCounts.clear();
+		m_cellInline.clear();
+		m_cellOverflow.clear();
+		m_freeCells.clear();
+		m_cellLookup.clear();
+	}
+
+private:
+	f32 m_cellSize = 1.0f;
+	f32 m_invCellSize = 1.0f;
+
+	// Entries
+	List<T> m_data;
+	List<Box3> m_bounds;
+	List<GridRange> m_ranges;
+	List<u8> m_alive;
+	List<GridMapHandle> m_freeSlots;
+
+	// Query deduplication, an entry is visited once per stamp
+	mutable List<u32> m_stamps;
+	mutable u32 m_stamp = 0;
+
+	// Cells
+	List<u64> m_cellKeys;
+	List<u32> m_cellCounts;
+	List<Array<GridMapHandle, InlineCount>> m_cellInline;
+	List<List<GridMapHandle>> m_cellOverflow;
+	List<u32> m_freeCells;
+	std::unordered_map<u64, u32, GridCellKeyHash> m_cellLookup;
 };
-*/
\ No newline at end of file
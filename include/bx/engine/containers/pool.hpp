@@ -4,6 +4,8 @@
 #include "bx/engine/core/macros.hpp"
 #include "bx/engine/containers/list.hpp"
 
+#include <algorithm>
+
 // TODO: THIS WAS MADE FOR THE ECS IT'S OLD
 // DON'T USE FOR OTHER STUFF UNTIL IT'S READY!
 
@@ -55,15 +57,14 @@ public:
 
     inline TData& New()
     {
-        SizeType idx = GetFreeIndex();
-        m_used[idx] = true;
-        return Get(idx);
+        return New(GetFreeIndex());
     }
 
     inline TData& New(SizeType idx)
     {
         BX_ASSERT(m_used[idx] == false, "New called on used index!");
         m_used[idx] = true;
+        m_count++;
         return Get(idx);
     }
 
@@ -85,10 +86,14 @@ public:
 
     virtual inline SizeType GetFreeIndex() override
     {
-        for (SizeType idx = 0; idx < GetSize(); ++idx)
+        // Every slot below the hint is used, so filling the pool in order doesn't rescan it
+        for (SizeType idx = m_freeHint; idx < GetSize(); ++idx)
         {
             if (!m_used[idx])
+            {
+                m_freeHint = idx;
                 return idx;
+            }
         }
 
         Resize((GetSize() + 1) * 2);
@@ -133,6 +138,8 @@ public:
         BX_ASSERT(IsUsed(idx), "Index is not used!");
 
         m_used[idx] = false;
+        m_count--;
+        m_freeHint = std::min(m_freeHint, idx);
 
         // Reset memory
         TData& data = m_data[idx];
@@ -155,6 +162,23 @@ public:
         return m_data.size();
     }
 
+    // Number of used slots
+    inline SizeType GetCount() const
+    {
+        return m_count;
+    }
+
+    // Grows the pool to hold at least size slots. This moves the data, so only
+    // do it while nothing holds on to a reference into the pool.
+    inline void Reserve(SizeType size)
+    {
+        if (size <= GetSize())
+            return;
+
+        m_used.resize(size, false);
+        m_data.resize(size, m_initializer);
+    }
+
     virtual inline void* GetPtr(SizeType idx) const override
     {
         return (void*)&m_data[idx];
@@ -181,4 +205,6 @@ private:
     TData m_initializer;
     List<bool> m_used;
     List<TData> m_data;
+    SizeType m_count = 0;
+    SizeType m_freeHint = 0;
 };
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "bx/engine/core/byte_types.hpp"
+
+// Byte oriented LZ77 codec using the LZ4 block format: sequences of literals followed by a
+// match (16 bit offset, minimum length of 4). Decoding needs no state besides the output.
+class Compression
+{
+public:
+	// Worst case size of the compressed data for incompressible input
+	static SizeType GetMaxCompressedSize(SizeType size);
+
+	// Returns the compressed size, or 0 if the destination is too small
+	static SizeType Compress(const u8* pSrc, SizeType srcSize, u8* pDst, SizeType dstCapacity);
+
+	// The destination size must be the exact decompressed size, returns false for malformed input
+	static bool Decompress(const u8* pSrc, SizeType srcSize, u8* pDst, SizeType dstSize);
+};
\ No newline at end of file
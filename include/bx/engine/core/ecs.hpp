@@ -20,6 +20,7 @@
 #include <functional>
 #include <memory>
 #include <algorithm>
+#include <type_traits>
 
 #ifndef ECS_POOL_SIZE
 #define ECS_POOL_SIZE 1000
@@ -267,7 +268,17 @@ public:
         *reinterpret_cast<TCmp*>(this) = (const TCmp&)cmp;
         m_entity = entity;
 
-        OnPostCopy();
+        if (HasPostCopy())
+            OnPostCopy();
+    }
+
+    /// <summary>
+    /// Whether the component type overrides OnPostCopy, copies skip the call otherwise.
+    /// </summary>
+    /// <returns>True if the type has a post copy step.</returns>
+    static constexpr bool HasPostCopy()
+    {
+        return !std::is_same<decltype(&TCmp::OnPostCopy), void (Component<TCmp>::*)()>::value;
     }
 
     virtual void OnPostCopy() override {}
@@ -436,7 +447,8 @@ public:
         BX_ENSURE(!IsValid(Entity(id)));
 
         // Setup entity
-        Entity& entity = GetEntities().New();
+        const SizeType slot = GetEntities().GetFreeIndex();
+        Entity& entity = GetEntities().New(slot);
 
         BX_ENSURE(entity.m_id == INVALID_ENTITY_ID);
         entity.m_id = id;
@@ -448,11 +460,50 @@ public:
         if (GetCmpHandles().find(entity.GetId()) == GetCmpHandles().end())
             GetCmpHandles().insert(std::make_pair(entity.GetId(), Pool<ComponentHandle>(ComponentHandle(), ECS_MAX_COMPONENTS)));
 
+        GetEntitySlots()[entity.GetId()] = slot;
+
         // Broadcast event
         Event::Broadcast<EntityCreated>(entity);
         return entity;
     }
 
+    /// <summary>
+    /// Grows the entity registries to hold a number of additional entities.
+    /// </summary>
+    /// <param name="count">Number of entities about to be created.</param>
+    static void ReserveEntities(SizeType count)
+    {
+        auto& entities = GetEntities();
+        const SizeType size = entities.GetCount() + count;
+
+        entities.Reserve(size);
+        GetCmpMaskMap().reserve(size);
+        GetCmpHandles().reserve(size);
+        GetEntitySlots().reserve(size);
+    }
+
+    /// <summary>
+    /// Grows the pool of a component type to hold a number of additional components.
+    /// Components are referenced by pointer, so a pool that is in use can't grow.
+    /// </summary>
+    /// <typeparam name="TCmp">Component type.</typeparam>
+    /// <param name="count">Number of components about to be added.</param>
+    /// <returns>True if the pool has room for all of them.</returns>
+    template <typename TCmp>
+    static bool ReserveComponents(SizeType count)
+    {
+        Pool<TCmp>& cmpPool = GetPool<TCmp>();
+        const SizeType size = cmpPool.GetCount() + count;
+        if (size <= cmpPool.GetSize())
+            return true;
+
+        if (cmpPool.GetCount() > 0)
+            return false;
+
+        cmpPool.Reserve(size);
+        return true;
+    }
+
     using ForAllCallback = std::function<void(const Entity& e)>;
 
     template <typename ... TCmps>
@@ -506,7 +557,8 @@ private:
     /// <returns>True if entity is valid.</returns>
     static bool IsValid(const Entity& entity)
     {
-        return GetEntities().IsUsed(entity);
+        // Only live entities are registered, which saves searching the entity pool
+        return GetCmpMaskMap().find(entity.GetId()) != GetCmpMaskMap().end();
     }
 
     /// <summary>
@@ -720,10 +772,15 @@ private:
         cmpHandles.Clear();
         entityMask.reset();
 
-        // Update registries
+        // Update registries, the slot saves searching the entity pool
+        auto slotIt = GetEntitySlots().find(entity.GetId());
+        BX_ENSURE(slotIt != GetEntitySlots().end());
+        const SizeType slot = slotIt->second;
+
+        GetEntitySlots().erase(slotIt);
         GetCmpHandles().erase(entity.GetId());
         GetCmpMaskMap().erase(entity.GetId());
-        GetEntities().Remove(entity);
+        GetEntities().Remove(slot);
 
         entity.m_id = INVALID_ENTITY_ID;
     }
@@ -841,6 +898,12 @@ private:
         static HashMap<ComponentMask, IPool*> s_cmpPoolMap;
         return s_cmpPoolMap;
     }
+
+    static HashMap<EntityId, SizeType>& GetEntitySlots()
+    {
+        static HashMap<EntityId, SizeType> s_entitySlots;
+        return s_entitySlots;
+    }
 };
 
 /// <summary>
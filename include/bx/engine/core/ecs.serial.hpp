@@ -4,6 +4,9 @@
 
 #include "bx/engine/core/serial.serial.hpp"
 #include "bx/engine/containers/list.serial.hpp"
+#include "bx/engine/containers/hash_map.hpp"
+
+#include <memory>
 
 template <>
 class Serial<Entity>
@@ -21,4 +24,123 @@ public:
 		ar(cereal::make_nvp("id", data.m_id));
 	}
 };
-REGISTER_SERIAL(Entity);
\ No newline at end of file
+REGISTER_SERIAL(Entity);
+
+// Reads and writes the components of one type straight from and to the pools,
+// used for the per type blocks of binary scenes
+class IComponentSerializer
+{
+public:
+	virtual ~IComponentSerializer() {}
+
+	virtual const String& GetName() const = 0;
+	virtual bool Reserve(SizeType count) const = 0;
+
+	virtual void Save(cereal::PortableBinaryOutputArchive& ar, const ComponentBase& cmp) const = 0;
+
+	// Loads into the component of the entity, or skips the data if the entity doesn't have one
+	virtual void Load(cereal::PortableBinaryInputArchive& ar, const Entity& entity) const = 0;
+	virtual std::shared_ptr<ComponentBase> Load(cereal::PortableBinaryInputArchive& ar) const = 0;
+
+	// Copies one component into many, without a virtual call per component
+	virtual void Copy(const ComponentBase& src, ComponentBase* const* pDsts, SizeType count) const = 0;
+};
+
+template <typename TCmp>
+class ComponentSerializer : public IComponentSerializer
+{
+public:
+	ComponentSerializer()
+		: m_name(Type<TCmp>::ClassName())
+	{}
+
+	const String& GetName() const override
+	{
+		return m_name;
+	}
+
+	bool Reserve(SizeType count) const override
+	{
+		return EntityManager::ReserveComponents<TCmp>(count);
+	}
+
+	void Save(cereal::PortableBinaryOutputArchive& ar, const ComponentBase& cmp) const override
+	{
+		Serial<TCmp>::Save(ar, static_cast<const TCmp&>(cmp));
+	}
+
+	void Load(cereal::PortableBinaryInputArchive& ar, const Entity& entity) const override
+	{
+		if (!entity.HasComponent<TCmp>())
+		{
+			TCmp cmp;
+			Serial<TCmp>::Load(ar, cmp);
+			return;
+		}
+
+		TCmp& cmp = entity.GetComponent<TCmp>();
+		Serial<TCmp>::Load(ar, cmp);
+		if (TCmp::HasPostCopy())
+			cmp.OnPostCopy();
+	}
+
+	std::shared_ptr<ComponentBase> Load(cereal::PortableBinaryInputArchive& ar) const override
+	{
+		auto cmp = std::make_shared<TCmp>();
+		Serial<TCmp>::Load(ar, *cmp);
+		return cmp;
+	}
+
+	void Copy(const ComponentBase& src, ComponentBase* const* pDsts, SizeType count) const override
+	{
+		const TCmp& srcCmp = static_cast<const TCmp&>(src);
+		for (SizeType i = 0; i < count; ++i)
+			static_cast<TCmp*>(pDsts[i])->Component<TCmp>::Copy(srcCmp);
+	}
+
+private:
+	String m_name;
+};
+
+class ComponentSerializerRegistry
+{
+public:
+	template <typename TCmp>
+	static bool Register()
+	{
+		static const ComponentSerializer<TCmp> s_serializer;
+		GetTypeMap()[Type<TCmp>::Id()] = &s_serializer;
+		GetNameMap()[s_serializer.GetName()] = &s_serializer;
+		return true;
+	}
+
+	static const IComponentSerializer* Find(TypeId typeId)
+	{
+		auto it = GetTypeMap().find(typeId);
+		return it != GetTypeMap().end() ? it->second : nullptr;
+	}
+
+	static const IComponentSerializer* Find(const String& name)
+	{
+		auto it = GetNameMap().find(name);
+		return it != GetNameMap().end() ? it->second : nullptr;
+	}
+
+private:
+	static HashMap<TypeId, const IComponentSerializer*>& GetTypeMap()
+	{
+		static HashMap<TypeId, const IComponentSerializer*> s_typeMap;
+		return s_typeMap;
+	}
+
+	static HashMap<String, const IComponentSerializer*>& GetNameMap()
+	{
+		static HashMap<String, const IComponentSerializer*> s_nameMap;
+		return s_nameMap;
+	}
+};
+
+// Registers the component for polymorphic serialization and for the binary scene blocks
+#define REGISTER_COMPONENT_SERIAL(TType) \
+REGISTER_POLYMORPHIC_SERIAL(ComponentBase, TType) \
+static const bool s_register##TType##Serializer = ComponentSerializerRegistry::Register<TType>();
\ No newline at end of file
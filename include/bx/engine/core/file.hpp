@@ -5,6 +5,8 @@
 #include "bx/engine/containers/string.hpp"
 
 #include <functional>
+#include <istream>
+#include <streambuf>
 
 // TODO: Clean up the whole file handle way of working with files
 // Would also be nice to implement a watch system to detect changes and re-load them.
@@ -23,11 +25,105 @@ struct FileHandle
 
 using FindEachCallback = std::function<void(const String& path, const String& name)>;
 
+// Non-owning span over file contents, valid for as long as the MappedFile it came from stays open
+class FileView
+{
+public:
+	FileView() {}
+	FileView(const u8* pData, SizeType size)
+		: m_pData(pData), m_size(size) {}
+
+	inline const u8* GetData() const { return m_pData; }
+	inline SizeType GetSize() const { return m_size; }
+	inline bool IsEmpty() const { return m_size == 0; }
+
+	inline const u8* begin() const { return m_pData; }
+	inline const u8* end() const { return m_pData + m_size; }
+	inline const u8& operator[](SizeType i) const { return m_pData[i]; }
+
+private:
+	const u8* m_pData = nullptr;
+	SizeType m_size = 0;
+};
+
+// Read-only view of a whole file mapped into memory, unmapped on destruction.
+// Platforms without memory mapping fall back to reading the file into a buffer.
+// Files inside a mounted pak point into the pak's mapping, or a buffer if compressed.
+// Text files are followed by a null terminator so GetText can be handed to C string APIs,
+// the mapping provides it for free unless the file ends exactly on a page boundary.
+// An empty file opens fine, with a size of zero and data that is only a null terminator.
+class MappedFile
+{
+public:
+	MappedFile() {}
+	explicit MappedFile(const String& filename, bool isText = false);
+	~MappedFile();
+
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool Open(const String& filename, bool isText = false);
+	void Close();
+
+	inline bool IsOpen() const { return m_pData != nullptr; }
+	inline const u8* GetData() const { return m_pData; }
+	inline SizeType GetSize() const { return m_size; }
+	inline FileView GetView() const { return FileView(m_pData, m_size); }
+
+	// Only null terminated when opened as text
+	inline const char* GetText() const { return reinterpret_cast<const char*>(m_pData); }
+
+private:
+	const u8* m_pData = nullptr;
+	SizeType m_size = 0;
+
+	// Only set when the data is a mapping owned by this file
+	bool m_isMapped = false;
+	List<u8> m_buffer;
+
+	bool OpenBuffered(const String& filename, const String& path, bool isText);
+	bool OpenEmpty();
+
+#if defined(BX_PLATFORM_PC)
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
+
+// Read-only std::istream over memory, lets stream based readers (e.g. cereal) consume a MappedFile without copying
+class MemoryStream : public std::istream
+{
+public:
+	MemoryStream(const u8* pData, SizeType size);
+
+private:
+	class Buffer : public std::streambuf
+	{
+	public:
+		Buffer(const u8* pData, SizeType size);
+
+	protected:
+		pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+	};
+
+	Buffer m_buffer;
+};
+
 class File
 {
 public:
 	static void AddWildcard(const String& wildcard, const String& value);
 
+	// Serves every path below the wildcard from a pak archive instead of the directory it maps to.
+	// Mapped files of a pak point into its mapping, so unmount only when none are open.
+	static bool Mount(const String& wildcard, const String& pakFilename);
+	static void Unmount(const String& wildcard);
+	static bool IsMounted(const String& filename);
+
 	static bool Exists(const String& path);
 	static u64 LastWrite(const String& filename);
 	static String GetPath(const String& filename);
@@ -44,6 +140,12 @@ public:
 	static bool Find(const String& root, const String& filename, String& filepath);
 	static void FindEach(const String& root, const String& ext, const FindEachCallback& callback);
 
+	// Reads the whole tree below the root once, ListFiles, Find and FindEach then answer from memory.
+	// Find and FindEach index their root on first use. Invalidate marks the indexes containing the
+	// path for a rebuild on their next lookup, File's own modifications and the resource watcher call it.
+	static void BuildIndex(const String& root);
+	static void Invalidate(const String& path);
+
 	static List<char> ReadBinaryFile(const String& filename);
 	static String ReadTextFile(const String& filename);
 	static bool WriteTextFile(const String& filename, const String& text);
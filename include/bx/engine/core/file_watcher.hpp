@@ -0,0 +1,49 @@
+#pragma once
+
+#include "bx/engine/core/byte_types.hpp"
+#include "bx/engine/core/time.hpp"
+#include "bx/engine/containers/string.hpp"
+#include "bx/engine/containers/list.hpp"
+#include "bx/engine/containers/hash_map.hpp"
+
+// Reports files below a root directory that were written or moved in.
+// With inotify, removed files and created or removed directories are reported too.
+// Uses inotify where available and otherwise polls the last write times.
+class FileWatcher
+{
+public:
+	FileWatcher() {}
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher& other) = delete;
+	FileWatcher& operator=(const FileWatcher& other) = delete;
+
+	// The root may contain wildcards, changed files are reported in the same form (e.g. [assets]/a.shader).
+	// The poll interval (in seconds) only applies to the polling fallback.
+	bool Watch(const String& root, f32 pollInterval = 1.0f);
+	void Stop();
+
+	inline bool IsWatching() const { return m_isWatching; }
+	inline bool IsPolling() const { return m_isWatching && !m_isNotifying; }
+
+	// Appends the files that changed since the last call without blocking, each file is reported once
+	void Poll(List<String>& changed);
+
+private:
+	void AddDirectory(const String& directory, List<String>* pChanged);
+	void Scan(const String& directory, List<String>* pChanged);
+
+private:
+	String m_root;
+	bool m_isWatching = false;
+	bool m_isNotifying = false;
+
+#if defined(BX_PLATFORM_LINUX)
+	int m_inotify = -1;
+	HashMap<int, String> m_directories;
+#endif
+
+	f32 m_pollInterval = 1.0f;
+	Timer m_timer;
+	HashMap<String, u64> m_lastWrites;
+};
\ No newline at end of file
@@ -36,6 +36,7 @@ public:
 	static void Print(LogLevel level, const String& message);
 	static void Print(const char* file, i32 line, const char* func, LogLevel level, const String& message);
 
+	// Printing is thread safe, the entries are only valid on the thread showing them until the next call
 	static LogEntry* GetLogs(SizeType& count);
 	static void Clear();
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "bx/engine/core/byte_types.hpp"
+#include "bx/engine/core/file.hpp"
+#include "bx/engine/containers/string.hpp"
+#include "bx/engine/containers/list.hpp"
+
+// Read-only archive of files: [header][entry data...][index][names].
+// The index is sorted by name hash so a lookup is a binary search plus one name compare.
+constexpr u32 PAK_MAGIC = 0x4B415042; // "BPAK"
+constexpr u32 PAK_VERSION = 1;
+constexpr u64 PAK_ALIGNMENT = 16;
+
+enum struct PakCompression : u32 { NONE = 0, LZ4 = 1 };
+
+struct PakHeader
+{
+	u32 magic = PAK_MAGIC;
+	u32 version = PAK_VERSION;
+	u32 entryCount = 0;
+	u32 padding = 0;
+	u64 indexOffset = 0;
+	u64 namesOffset = 0;
+	u64 namesSize = 0;
+};
+
+struct PakEntry
+{
+	u64 hash = 0;
+	u64 offset = 0;
+	// Size in the archive, equals the uncompressed size for stored entries
+	u64 size = 0;
+	u64 uncompressedSize = 0;
+	u32 nameOffset = 0;
+	u32 nameSize = 0;
+	PakCompression compression = PakCompression::NONE;
+	u32 padding = 0;
+};
+
+class PakArchive
+{
+public:
+	PakArchive() {}
+	explicit PakArchive(const String& filename);
+
+	bool Open(const String& filename);
+	void Close();
+
+	inline bool IsOpen() const { return m_file.IsOpen(); }
+
+	// Names are relative to the archive root with forward slashes (e.g. textures/wall.texture)
+	const PakEntry* Find(const String& name) const;
+	bool IsDirectory(const String& name) const;
+	String GetName(const PakEntry& entry) const;
+
+	inline SizeType GetEntryCount() const { return m_entryCount; }
+	inline const PakEntry& GetEntry(SizeType index) const { return m_pEntries[index]; }
+
+	// Stored entries point straight into the mapping, compressed entries are decoded into the buffer.
+	// Returns nullptr if the entry could not be decoded.
+	const u8* Read(const PakEntry& entry, List<u8>& buffer) const;
+
+	static u64 HashName(const String& name);
+
+private:
+	MappedFile m_file;
+	const PakEntry* m_pEntries = nullptr;
+	const char* m_pNames = nullptr;
+	SizeType m_entryCount = 0;
+};
+
+class PakBuilder
+{
+public:
+	// Entries are read from disk while writing, compressed ones are stored as-is if that is smaller
+	void AddFile(const String& name, const String& filename, bool compress);
+	bool Write(const String& filename) const;
+
+	inline SizeType GetFileCount() const { return m_files.size(); }
+
+private:
+	struct Source
+	{
+		String name;
+		String filename;
+		bool compress = false;
+	};
+
+	List<Source> m_files;
+};
\ No newline at end of file
@@ -56,4 +56,8 @@ public:
 	static void EndSection(const String& name);
 
 	static const HashMap<String, ProfilerData>& GetData();
+
+	// Counters are plain values (e.g. memory usage) that are reported next to the timings
+	static void SetCounter(const String& name, f64 value);
+	static const HashMap<String, f64>& GetCounters();
 };
\ No newline at end of file
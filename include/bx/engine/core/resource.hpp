@@ -7,22 +7,88 @@
 #include "bx/engine/containers/list.hpp"
 #include "bx/engine/containers/hash_map.hpp"
 
-using ResourceHandle = SizeType;
+#include <deque>
+#include <memory>
+
+// Hash of the filename (or a user key) combined with the type, only used to find the slot of a resource by name
+using ResourceKey = SizeType;
+
+// Slot index in the low 32 bits and the slot generation in the high 32 bits, the
+// generation changes whenever the slot is freed so stale handles are detected
+using ResourceHandle = u64;
 constexpr ResourceHandle RESOURCE_HANDLE_INVALID = 0;
 
+inline u32 GetResourceSlot(ResourceHandle handle) { return static_cast<u32>(handle & 0xFFFFFFFF); }
+inline u32 GetResourceGeneration(ResourceHandle handle) { return static_cast<u32>(handle >> 32); }
+inline ResourceHandle MakeResourceHandle(u32 slot, u32 generation) { return (static_cast<u64>(generation) << 32) | slot; }
+
+constexpr u32 RESOURCE_SLOT_NONE = 0xFFFFFFFF;
+
 enum struct ResourceStorage { NONE, DISK, MEMORY };
+enum struct ResourceState { PENDING, LOADED, FAILED };
+
+// Estimated memory held by a resource, in bytes
+struct ResourceMemory
+{
+	SizeType cpu = 0;
+	SizeType gpu = 0;
+
+	inline SizeType Total() const { return cpu + gpu; }
+
+	inline ResourceMemory& operator+=(const ResourceMemory& other) { cpu += other.cpu; gpu += other.gpu; return *this; }
+	inline ResourceMemory& operator-=(const ResourceMemory& other) { cpu -= other.cpu; gpu -= other.gpu; return *this; }
+};
 
 //class IResource;
 
 template <typename TData>
 class Resource;
 
+template <typename TData>
+class ResourceLoadJob;
+
+// An asynchronous load split in two halves. Decode runs on a worker thread and may only
+// touch files and the job's own data, Finalize runs on the main thread and publishes it.
+class IResourceJob
+{
+public:
+	virtual ~IResourceJob() {}
+
+	virtual void Decode() = 0;
+	virtual void Finalize() = 0;
+
+	virtual const String& GetFilename() const = 0;
+};
+
 class ResourceManager
 {
 public:
 	static void Initialize();
 	static void Shutdown();
 
+	// Finalizes decoded asynchronous loads until the budget (in milliseconds) is spent,
+	// at least one load is finalized per call so the queue always drains
+	static void Update(f32 budget = 2.0f);
+	// Blocks until every queued asynchronous load has been finalized
+	static void Flush();
+
+	static SizeType GetPendingCount();
+	static bool IsPending(const String& filename);
+	static bool IsIdle();
+
+	// Unreferenced resources stay cached until their type uses more than the budget (in bytes).
+	// Applies to every resource type, zero unloads resources as soon as they are released.
+	static void SetBudget(SizeType budget);
+	static SizeType GetBudget();
+
+	// Reloads the resources loaded from the file in place, so handles stay valid, followed by the
+	// resources that loaded them while loading themselves (e.g. materials using a texture or shader)
+	static void Reload(const String& filename);
+
+	// Decodes the job on a worker thread, Update finalizes it on the main thread. Resources queue their own
+	// loads, other jobs (e.g. streaming more data into a loaded resource) count as pending for their filename.
+	static void QueueJob(const std::shared_ptr<IResourceJob>& job);
+
 private:
 	//friend class IResource;
 
@@ -33,8 +99,16 @@ private:
 	template <typename T>
 	friend class Resource;
 
+	template <typename T>
+	friend class ResourceDatabase;
+
 	static HashMap<ResourceHandle, SizeType>& GetRefCountMap();
 
+	// Everything requested between BeginLoad and EndLoad becomes a dependency of the resource being loaded
+	static void BeginLoad(const String& filename);
+	static void EndLoad();
+	static void RecordDependency(const String& filename);
+
 };
 
 template <typename TData>
@@ -49,6 +123,8 @@ struct ResourceData
 
 	SizeType refCount = 0;
 	ResourceStorage storage = ResourceStorage::NONE;
+	ResourceState state = ResourceState::LOADED;
+	ResourceMemory memory;
 	String filename;
 	TData data;
 };
@@ -56,7 +132,9 @@ struct ResourceData
 class IResourceDatabase
 {
 public:
-	IResourceDatabase()
+	IResourceDatabase(const String& name)
+		: m_name(name)
+		, m_budget(ResourceManager::GetBudget())
 	{
 		GetDatabaseRecord().emplace_back(this);
 	}
@@ -64,6 +142,23 @@ public:
 	virtual ~IResourceDatabase() {}
 
 	virtual void Shutdown() = 0;
+	virtual void SetBudget(SizeType budget) = 0;
+	// Returns false if no resource of this type is loaded from the file, a failed one is tried again
+	virtual bool Reload(const String& filename) = 0;
+
+	inline const String& GetName() const { return m_name; }
+	inline SizeType GetBudget() const { return m_budget; }
+
+	// Everything loaded, including the cached resources
+	inline const ResourceMemory& GetResident() const { return m_resident; }
+	// Only the unreferenced resources that are kept for reuse
+	inline const ResourceMemory& GetCached() const { return m_cached; }
+
+protected:
+	String m_name;
+	SizeType m_budget = 0;
+	ResourceMemory m_resident;
+	ResourceMemory m_cached;
 
 private:
 	friend class ResourceManager;
@@ -80,143 +175,459 @@ class ResourceDatabase : public IResourceDatabase
 {
 public:
 	using LoadFn = bool(*)(const String&, TData&);
+	using FinalizeFn = bool(*)(const String&, TData&);
 	using SaveFn = bool(*)(const String&, const TData&);
 	using UnloadFn = void(*)(const TData&);
+	using MeasureFn = ResourceMemory(*)(const TData&);
+
+	ResourceDatabase(LoadFn loadFn, UnloadFn unloadFn, MeasureFn measureFn)
+		: IResourceDatabase(Type<TData>::ClassName())
+		, m_loadFn(loadFn)
+		, m_unloadFn(unloadFn)
+		, m_measureFn(measureFn)
+	{}
 
 	inline void Shutdown() override
 	{
-		m_database.clear();
+		m_slots.clear();
+		m_freeSlots.clear();
+		m_lookup.clear();
+
+		m_lruHead = RESOURCE_SLOT_NONE;
+		m_lruTail = RESOURCE_SLOT_NONE;
+		m_resident = ResourceMemory();
+		m_cached = ResourceMemory();
+	}
+
+	inline void SetBudget(SizeType budget) override
+	{
+		m_budget = budget;
+		Trim();
 	}
 
 	inline TData& GetData(ResourceHandle handle)
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
-		auto it = m_database.find(handle);
-		BX_ENSURE(it != m_database.end());
-		return it->second.data;
+		auto& resource = GetEntry(handle);
+		BX_ASSERT(resource.state == ResourceState::LOADED, "Resource is not loaded yet!");
+		return resource.data;
 	}
 
 	inline TData* GetDataPtr(ResourceHandle handle)
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
-		auto it = m_database.find(handle);
-		BX_ENSURE(it != m_database.end());
-		return &it->second.data;
+		auto& resource = GetEntry(handle);
+		BX_ASSERT(resource.state == ResourceState::LOADED, "Resource is not loaded yet!");
+		return &resource.data;
 	}
 
 	inline const ResourceData<TData>& GetResourceData(ResourceHandle handle)
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
-		auto it = m_database.find(handle);
-		BX_ENSURE(it != m_database.end());
-		return it->second;
+		return GetEntry(handle);
 	}
 
 	inline bool IsLoaded(ResourceHandle handle)
 	{
-		return handle != RESOURCE_HANDLE_INVALID
-			&& m_database.find(handle) != m_database.end();
+		const auto* pResource = Find(handle);
+		return pResource != nullptr && pResource->state == ResourceState::LOADED;
 	}
 
-	inline bool Load(ResourceHandle handle, const String& filename, LoadFn loadFn)
+	inline bool IsPending(ResourceHandle handle)
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
+		const auto* pResource = Find(handle);
+		return pResource != nullptr && pResource->state == ResourceState::PENDING;
+	}
+
+	inline ResourceHandle Load(ResourceKey key, const String& filename)
+	{
+		ResourceManager::RecordDependency(filename);
+
+		// Pending loads are completed and failed ones tried again, the error may have been transient
+		ResourceHandle handle = FindHandle(key);
+		if (handle != RESOURCE_HANDLE_INVALID && GetEntry(handle).state == ResourceState::LOADED)
+			return handle;
+
 		TData data{};
-		
-		auto it = m_database.find(handle);
-		if (it != m_database.end())
-			return true;
 
-		if (!loadFn(filename, data))
+		ResourceManager::BeginLoad(filename);
+		const bool loaded = m_loadFn(filename, data);
+		ResourceManager::EndLoad();
+
+		if (!loaded)
 		{
-			BX_LOGE("Failed to load resource ({} | {})", handle, filename);
-			return false;
+			BX_LOGE("Failed to load resource ({} | {})", key, filename);
+			return RESOURCE_HANDLE_INVALID;
 		}
 
-		auto entry = ResourceData<TData>(ResourceStorage::DISK, filename, data);
-		m_database.insert(std::make_pair(handle, entry));
+		// A pending asynchronous load is completed right away, its result gets dropped later
+		handle = FindHandle(key);
+		if (handle == RESOURCE_HANDLE_INVALID)
+			handle = Allocate(key, ResourceData<TData>(ResourceStorage::DISK, filename, data));
+		else
+			GetEntry(handle).data = data;
+
+		MarkLoaded(GetEntry(handle));
 
 		BX_LOGD("Loaded resource ({} | {})", handle, filename);
-		return true;
+		return handle;
 	}
 
-	inline void LoadData(ResourceHandle handle, const TData& data)
+	// Returns the handle of a new pending entry, queued is false if the resource was already known
+	inline ResourceHandle LoadAsync(ResourceKey key, const String& filename, bool& queued)
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
+		ResourceManager::RecordDependency(filename);
 
-		auto it = m_database.find(handle);
-		if (it != m_database.end())
+		ResourceHandle handle = FindHandle(key);
+		queued = handle == RESOURCE_HANDLE_INVALID;
+		if (!queued)
+		{
+			// A failed entry is queued again
+			auto& resource = GetEntry(handle);
+			if (resource.state == ResourceState::FAILED)
+			{
+				resource.state = ResourceState::PENDING;
+				queued = true;
+			}
+			return handle;
+		}
+
+		auto entry = ResourceData<TData>(ResourceStorage::DISK, filename, TData{});
+		entry.state = ResourceState::PENDING;
+		handle = Allocate(key, entry);
+
+		BX_LOGD("Queued resource ({} | {})", handle, filename);
+		return handle;
+	}
+
+	// Publishes a decoded asynchronous load. The result is dropped if the entry was
+	// unloaded or loaded synchronously in the meantime.
+	inline void FinishAsync(ResourceHandle handle, bool decoded, TData& data, FinalizeFn finalizeFn)
+	{
+		auto* pResource = Find(handle);
+		if (pResource == nullptr || pResource->state != ResourceState::PENDING)
+			return;
+
+		const String filename = pResource->filename;
+
+		ResourceManager::BeginLoad(filename);
+		const bool loaded = decoded && finalizeFn(filename, data);
+		ResourceManager::EndLoad();
+
+		// Finalizing may load dependencies, so look the entry up again
+		pResource = Find(handle);
+		if (pResource == nullptr)
 			return;
 
-		auto entry = ResourceData<TData>(ResourceStorage::MEMORY, "", data);
-		m_database.insert(std::make_pair(handle, entry));
+		if (!loaded)
+		{
+			pResource->state = ResourceState::FAILED;
+			BX_LOGE("Failed to load resource ({} | {})", handle, filename);
+			return;
+		}
+
+		pResource->data = std::move(data);
+		MarkLoaded(*pResource);
+
+		BX_LOGD("Loaded resource ({} | {})", handle, filename);
+	}
+
+	// Measures a loaded resource again after its data changed in place, e.g. streamed in levels
+	inline void Remeasure(ResourceHandle handle)
+	{
+		auto* pResource = Find(handle);
+		if (pResource == nullptr || pResource->state != ResourceState::LOADED)
+			return;
+
+		const bool isCached = m_slots[GetResourceSlot(handle)].isCached;
+		m_resident -= pResource->memory;
+		if (isCached)
+			m_cached -= pResource->memory;
+
+		pResource->memory = m_measureFn(pResource->data);
+
+		m_resident += pResource->memory;
+		if (isCached)
+			m_cached += pResource->memory;
+
+		Trim();
+	}
+
+	inline ResourceHandle LoadData(ResourceKey key, const TData& data)
+	{
+		ResourceHandle handle = FindHandle(key);
+		if (handle != RESOURCE_HANDLE_INVALID)
+			return handle;
+
+		handle = Allocate(key, ResourceData<TData>(ResourceStorage::MEMORY, "", data));
+		MarkLoaded(GetEntry(handle));
 
 		BX_LOGD("Loaded resource ({})", handle);
+		return handle;
 	}
 
-	inline void Save(ResourceHandle handle, const String& filename, SaveFn saveFn)
+	inline bool Reload(const String& filename) override
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
+		const ResourceHandle handle = FindHandle(Resource<TData>::MakeKey(filename));
+		auto* pResource = Find(handle);
+		if (pResource == nullptr || pResource->state == ResourceState::PENDING || pResource->storage != ResourceStorage::DISK)
+			return false;
+
+		// Nothing uses a cached resource, loading it again later is enough
+		if (m_slots[GetResourceSlot(handle)].isCached)
+		{
+			Unload(handle);
+			return true;
+		}
+
+		TData data{};
+
+		ResourceManager::BeginLoad(filename);
+		const bool loaded = m_loadFn(filename, data);
+		ResourceManager::EndLoad();
+
+		pResource = Find(handle);
+		const bool wasLoaded = pResource->state == ResourceState::LOADED;
+		if (!loaded)
+		{
+			if (wasLoaded)
+				BX_LOGE("Failed to reload resource ({} | {}), keeping the previous version", handle, filename);
+			else
+				BX_LOGE("Failed to reload resource ({} | {})", handle, filename);
+			return true;
+		}
 
-		auto it = m_database.find(handle);
-		BX_ASSERT(it != m_database.end(), "Data for handle not found!");
+		// A failed resource has nothing to release, reloading it is a retry
+		if (wasLoaded)
+		{
+			m_unloadFn(pResource->data);
+			m_resident -= pResource->memory;
+		}
 
-		if (!saveFn(filename, it->second.data))
+		pResource->data = std::move(data);
+		MarkLoaded(*pResource);
+
+		BX_LOGD("Reloaded resource ({} | {})", handle, filename);
+		return true;
+	}
+
+	inline void Save(ResourceHandle handle, const String& filename, SaveFn saveFn)
+	{
+		auto* pResource = Find(handle);
+		BX_ASSERT(pResource != nullptr, "Data for handle not found!");
+
+		if (!saveFn(filename, pResource->data))
 		{
 			BX_LOGE("Failed to save resource ({} | {})", handle, filename);
 			return;
 		}
 
-		it->second.storage = ResourceStorage::DISK;
-		it->second.filename = filename;
+		pResource->storage = ResourceStorage::DISK;
+		pResource->filename = filename;
 
 		BX_LOGD("Saved resource ({} | {})", handle, filename);
 	}
 
-	inline void Unload(ResourceHandle handle, UnloadFn unloadFn)
+	inline void Unload(ResourceHandle handle)
 	{
-		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
-
-		auto it = m_database.find(handle);
-		if (it == m_database.end())
+		auto* pResource = Find(handle);
+		if (pResource == nullptr)
 			return;
 
-		unloadFn(it->second.data);
+		if (pResource->state == ResourceState::LOADED)
+			m_unloadFn(pResource->data);
 
-		m_database.erase(it);
+		Free(handle);
 		BX_LOGD("Unloaded resource ({})", handle);
 	}
 
 	inline void IncreaseRefCount(ResourceHandle handle)
 	{
-		BX_ENSURE(handle != RESOURCE_HANDLE_INVALID);
+		auto& resource = GetEntry(handle);
 
-		auto it = m_database.find(handle);
-		BX_ENSURE(it != m_database.end());
+		// Revived from the cache
+		if (resource.refCount == 0 && m_slots[GetResourceSlot(handle)].isCached)
+			Uncache(GetResourceSlot(handle));
 
-		it->second.refCount++;
-		BX_LOGD("Resource ({}) increment ref count {}", handle, it->second.refCount);
+		resource.refCount++;
+		BX_LOGD("Resource ({}) increment ref count {}", handle, resource.refCount);
 	}
 
-	inline void DecreaseRefCount(ResourceHandle handle, UnloadFn unloadFn)
+	inline void DecreaseRefCount(ResourceHandle handle)
 	{
-		BX_ENSURE(handle != RESOURCE_HANDLE_INVALID);
+		// Resources can outlive the database when released after shutdown
+		auto* pResource = Find(handle);
+		if (pResource == nullptr)
+			return;
+
+		BX_ENSURE(pResource->refCount > 0);
+		pResource->refCount--;
+		BX_LOGD("Resource ({}) decrement ref count {}", handle, pResource->refCount);
+
+		if (pResource->refCount == 0)
+		{
+			// Loaded resources are kept around until the budget is exceeded, pending and failed ones are not worth it.
+			// Memory resources are not cached, they can't be reloaded and would shadow the file under the same key.
+			if (m_budget > 0 && pResource->state == ResourceState::LOADED && pResource->storage == ResourceStorage::DISK)
+			{
+				Cache(GetResourceSlot(handle));
+				Trim();
+			}
+			else
+			{
+				Unload(handle);
+			}
+		}
+	}
+
+private:
+	struct Slot
+	{
+		ResourceKey key = 0;
+		u32 generation = 1;
+
+		// Least recently released first
+		bool isCached = false;
+		u32 prev = RESOURCE_SLOT_NONE;
+		u32 next = RESOURCE_SLOT_NONE;
+
+		ResourceData<TData> resource;
+	};
+
+	inline void MarkLoaded(ResourceData<TData>& resource)
+	{
+		resource.state = ResourceState::LOADED;
+		resource.memory = m_measureFn(resource.data);
+		m_resident += resource.memory;
+
+		Trim();
+	}
+
+	inline void Cache(u32 slot)
+	{
+		auto& entry = m_slots[slot];
+		entry.isCached = true;
+		entry.prev = m_lruTail;
+		entry.next = RESOURCE_SLOT_NONE;
+
+		if (m_lruTail != RESOURCE_SLOT_NONE)
+			m_slots[m_lruTail].next = slot;
+		else
+			m_lruHead = slot;
+		m_lruTail = slot;
+
+		m_cached += entry.resource.memory;
+	}
+
+	inline void Uncache(u32 slot)
+	{
+		auto& entry = m_slots[slot];
+		BX_ASSERT(entry.isCached, "Resource is not cached!");
+
+		if (entry.prev != RESOURCE_SLOT_NONE)
+			m_slots[entry.prev].next = entry.next;
+		else
+			m_lruHead = entry.next;
 
-		auto it = m_database.find(handle);
-		BX_ENSURE(it != m_database.end());
+		if (entry.next != RESOURCE_SLOT_NONE)
+			m_slots[entry.next].prev = entry.prev;
+		else
+			m_lruTail = entry.prev;
 
-		BX_ENSURE(it->second.refCount > 0);
-		it->second.refCount--;
-		BX_LOGD("Resource ({}) decrement ref count {}", handle, it->second.refCount);
+		entry.isCached = false;
+		entry.prev = RESOURCE_SLOT_NONE;
+		entry.next = RESOURCE_SLOT_NONE;
 
-		if (it->second.refCount == 0)
+		m_cached -= entry.resource.memory;
+	}
+
+	// Evicts the least recently released resources until the type fits in its budget again
+	inline void Trim()
+	{
+		while (m_lruHead != RESOURCE_SLOT_NONE && m_resident.Total() > m_budget)
+		{
+			const u32 slot = m_lruHead;
+			Unload(MakeResourceHandle(slot, m_slots[slot].generation));
+		}
+	}
+
+	inline ResourceData<TData>* Find(ResourceHandle handle)
+	{
+		const u32 slot = GetResourceSlot(handle);
+		if (handle == RESOURCE_HANDLE_INVALID || slot >= m_slots.size())
+			return nullptr;
+
+		auto& entry = m_slots[slot];
+		return entry.generation == GetResourceGeneration(handle) ? &entry.resource : nullptr;
+	}
+
+	inline ResourceData<TData>& GetEntry(ResourceHandle handle)
+	{
+		BX_ASSERT(handle != RESOURCE_HANDLE_INVALID, "Resource handle is invalid!");
+		auto* pResource = Find(handle);
+		BX_ENSURE(pResource != nullptr);
+		return *pResource;
+	}
+
+	inline ResourceHandle FindHandle(ResourceKey key) const
+	{
+		auto it = m_lookup.find(key);
+		return it != m_lookup.end() ? it->second : RESOURCE_HANDLE_INVALID;
+	}
+
+	inline ResourceHandle Allocate(ResourceKey key, const ResourceData<TData>& resource)
+	{
+		u32 slot;
+		if (!m_freeSlots.empty())
 		{
-			Unload(handle, unloadFn);
+			slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
 		}
+		else
+		{
+			slot = static_cast<u32>(m_slots.size());
+			m_slots.emplace_back();
+		}
+
+		auto& entry = m_slots[slot];
+		entry.key = key;
+		entry.resource = resource;
+
+		const ResourceHandle handle = MakeResourceHandle(slot, entry.generation);
+		m_lookup.insert(std::make_pair(key, handle));
+		return handle;
+	}
+
+	inline void Free(ResourceHandle handle)
+	{
+		const u32 slot = GetResourceSlot(handle);
+		auto& entry = m_slots[slot];
+
+		if (entry.isCached)
+			Uncache(slot);
+
+		if (entry.resource.state == ResourceState::LOADED)
+			m_resident -= entry.resource.memory;
+
+		m_lookup.erase(entry.key);
+		entry.resource = ResourceData<TData>();
+
+		// Zero is reserved so that no handle equals RESOURCE_HANDLE_INVALID
+		if (++entry.generation == 0)
+			entry.generation = 1;
+
+		m_freeSlots.emplace_back(slot);
 	}
 
 private:
-	HashMap<ResourceHandle, ResourceData<TData>> m_database;
+	// A deque never moves its elements when growing, so references to resource data stay valid
+	std::deque<Slot> m_slots;
+	List<u32> m_freeSlots;
+	HashMap<ResourceKey, ResourceHandle> m_lookup;
+
+	u32 m_lruHead = RESOURCE_SLOT_NONE;
+	u32 m_lruTail = RESOURCE_SLOT_NONE;
+
+	LoadFn m_loadFn = nullptr;
+	UnloadFn m_unloadFn = nullptr;
+	MeasureFn m_measureFn = nullptr;
 };
 
 template <typename TData>
@@ -226,28 +637,17 @@ public:
 	Resource() {}
 
 	Resource(const String& filename)
-		: m_handle(MakeHandle(filename))
+		: m_handle(GetDatabase().Load(MakeKey(filename), filename))
 	{
 		if (IsValid())
-		{
-			if (!Load(filename))
-			{
-				m_handle = RESOURCE_HANDLE_INVALID;
-				return;
-			}
-
 			IncreaseRefCount();
-		}
 	}
 
-	Resource(ResourceHandle handle, const TData& data)
-		: m_handle(handle)
+	Resource(ResourceKey key, const TData& data)
+		: m_handle(GetDatabase().LoadData(key, data))
 	{
 		if (IsValid())
-		{
-			LoadData(data);
 			IncreaseRefCount();
-		}
 	}
 
 	~Resource()
@@ -327,25 +727,25 @@ public:
 		return GetDatabase().IsLoaded(m_handle);
 	}
 
-	inline void Save(const String& filename) const
+	inline bool IsPending() const
 	{
-		GetDatabase().Save(m_handle, filename, &Resource::Save);
+		return GetDatabase().IsPending(m_handle);
 	}
 
-private:
-	inline bool Load(const String& filename) const
+	inline void Save(const String& filename) const
 	{
-		return GetDatabase().Load(m_handle, filename, &Resource::Load);
+		GetDatabase().Save(m_handle, filename, &Resource::Save);
 	}
 
-	inline void LoadData(const TData& data) const
+	inline void Remeasure() const
 	{
-		return GetDatabase().LoadData(m_handle, data);
+		GetDatabase().Remeasure(m_handle);
 	}
 
+private:
 	inline void Unload() const
 	{
-		GetDatabase().Unload(m_handle, &Resource::Unload);
+		GetDatabase().Unload(m_handle);
 	}
 
 	inline void IncreaseRefCount() const
@@ -355,30 +755,93 @@ private:
 
 	inline void DecreaseRefCount() const
 	{
-		GetDatabase().DecreaseRefCount(m_handle, &Resource::Unload);
+		GetDatabase().DecreaseRefCount(m_handle);
 	}
 
 public:
-	static ResourceHandle MakeHandle(const String& filename)
+	static ResourceKey MakeKey(const String& filename)
 	{
 		static const Hash<String> s_stringHashFn;
 		return Type<TData>::Id() ^ s_stringHashFn(filename);
 	}
 
+	// Reads and decodes the file on a worker thread. The resource stays pending (not loaded)
+	// until ResourceManager::Update finalizes it on the main thread.
+	static Resource LoadAsync(const String& filename)
+	{
+		bool queued = false;
+
+		Resource resource;
+		resource.m_handle = GetDatabase().LoadAsync(MakeKey(filename), filename, queued);
+
+		if (queued)
+			ResourceManager::QueueJob(std::make_shared<ResourceLoadJob<TData>>(resource.m_handle, filename));
+
+		resource.IncreaseRefCount();
+		return resource;
+	}
+
+	static bool Load(const String& filename, TData& data)
+	{
+		return Decode(filename, data) && Finalize(filename, data);
+	}
+
+	// Keeps unreferenced resources of this type cached up to the budget (in bytes)
+	static void SetBudget(SizeType budget)
+	{
+		GetDatabase().SetBudget(budget);
+	}
+
 	static bool Save(const String& filename, const TData& data);
-	static bool Load(const String& filename, TData& data);
 	static void Unload(const TData& data);
+	static ResourceMemory Measure(const TData& data);
+
+	// Loading is split so it can run asynchronously, Decode must be thread safe
+	// and Finalize creates whatever needs the main thread (e.g. GPU objects)
+	static bool Decode(const String& filename, TData& data);
+	static bool Finalize(const String& filename, TData& data);
 
 private:
 	template <typename T>
 	friend class Serial;
 
+	template <typename T>
+	friend class ResourceLoadJob;
+
 	static ResourceDatabase<TData>& GetDatabase()
 	{
-		static ResourceDatabase<TData> database;
+		static ResourceDatabase<TData> database(&Resource::Load, &Resource::Unload, &Resource::Measure);
 		return database;
 	}
 
 private:
 	ResourceHandle m_handle = RESOURCE_HANDLE_INVALID;
+};
+
+template <typename TData>
+class ResourceLoadJob : public IResourceJob
+{
+public:
+	ResourceLoadJob(ResourceHandle handle, const String& filename)
+		: m_handle(handle)
+		, m_filename(filename)
+	{}
+
+	void Decode() override
+	{
+		m_decoded = Resource<TData>::Decode(m_filename, m_data);
+	}
+
+	void Finalize() override
+	{
+		Resource<TData>::GetDatabase().FinishAsync(m_handle, m_decoded, m_data, &Resource<TData>::Finalize);
+	}
+
+	const String& GetFilename() const override { return m_filename; }
+
+private:
+	ResourceHandle m_handle = RESOURCE_HANDLE_INVALID;
+	String m_filename;
+	TData m_data{};
+	bool m_decoded = false;
 };
\ No newline at end of file
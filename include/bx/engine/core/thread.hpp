@@ -6,6 +6,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <vector>
 #include <cassert>
 
 class Worker
@@ -25,4 +26,28 @@ private:
 	std::atomic<bool> m_running;
 
 	std::thread m_thread;
+};
+
+// Fixed set of threads sharing one queue, tasks run in the order they were queued
+// but may finish in any order
+class WorkerPool
+{
+public:
+	// A thread count of zero uses one thread less than the hardware has (at least one)
+	explicit WorkerPool(unsigned int threadCount = 0);
+	~WorkerPool();
+	void Queue(std::function<void()> func);
+
+	inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+private:
+	void Loop();
+
+private:
+	std::mutex m_queueLock;
+	std::queue<std::function<void()>> m_queue;
+	std::condition_variable m_queueCondition;
+	std::atomic<bool> m_running;
+
+	std::vector<std::thread> m_threads;
 };
\ No newline at end of file
@@ -8,7 +8,8 @@ using GraphicsHandle = u64;
 constexpr GraphicsHandle INVALID_GRAPHICS_HANDLE = -1;
 
 ENUM(GraphicsClearFlags, NONE, DEPTH, STENCIL);
-ENUM(GraphicsValueType, UNDEFINED, INT8, INT16, INT32, UINT8, UINT16, UINT32, FLOAT16, FLOAT32);
+// INT10_10_10_2 is a packed type, all four components share a single 32 bit value
+ENUM(GraphicsValueType, UNDEFINED, INT8, INT16, INT32, UINT8, UINT16, UINT32, FLOAT16, FLOAT32, INT10_10_10_2);
 
 ENUM(ShaderType, UNKNOWN, VERTEX, PIXEL, GEOMETRY, COMPUTE);
 
@@ -16,7 +17,8 @@ ENUM(BufferType, VERTEX_BUFFER, INDEX_BUFFER, UNIFORM_BUFFER, STORAGE_BUFFER);
 ENUM(BufferUsage, IMMUTABLE, DEFAULT, DYNAMIC);
 ENUM(BufferAccess, NONE, READ, WRITE);
 
-ENUM(TextureFormat, UNKNOWN, RGB8_UNORM, RGBA8_UNORM, RG32_UINT, D24_UNORM_S8_UINT);
+// BC formats store 4x4 texel blocks: BC1 (RGB, 8 bytes), BC3 (RGBA, 16 bytes), BC5 (RG, 16 bytes), BC7 (RGBA, 16 bytes)
+ENUM(TextureFormat, UNKNOWN, RGB8_UNORM, RGBA8_UNORM, RG32_UINT, D24_UNORM_S8_UINT, BC1_UNORM, BC3_UNORM, BC5_UNORM, BC7_UNORM);
 ENUM(TextureFlags, NONE = BX_BIT(0), SHADER_RESOURCE = BX_BIT(1), RENDER_TARGET = BX_BIT(2), DEPTH_STENCIL = BX_BIT(3));
 
 ENUM(ResourceBindingType, UNKNOWN, TEXTURE, UNIFORM_BUFFER, STORAGE_BUFFER);
@@ -44,9 +46,57 @@ struct TextureInfo
 	TextureFormat format = TextureFormat::UNKNOWN;
 	u32 width = 0;
 	u32 height = 0;
+	// Levels in the initial data, tightly packed with the base level first
+	u32 mipCount = 1;
 	TextureFlags flags = TextureFlags::SHADER_RESOURCE;
 };
 
+inline bool IsBlockCompressed(TextureFormat format)
+{
+	return format == TextureFormat::BC1_UNORM || format == TextureFormat::BC3_UNORM
+		|| format == TextureFormat::BC5_UNORM || format == TextureFormat::BC7_UNORM;
+}
+
+// Bytes per texel, or per 4x4 block for block compressed formats
+inline u32 GetTextureFormatSize(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::RGB8_UNORM: return 3;
+	case TextureFormat::RGBA8_UNORM: return 4;
+	case TextureFormat::RG32_UINT: return 8;
+	case TextureFormat::D24_UNORM_S8_UINT: return 4;
+	case TextureFormat::BC1_UNORM: return 8;
+	case TextureFormat::BC3_UNORM: return 16;
+	case TextureFormat::BC5_UNORM: return 16;
+	case TextureFormat::BC7_UNORM: return 16;
+	default: return 0;
+	}
+}
+
+inline u32 GetTextureLevelExtent(u32 extent, u32 level)
+{
+	const u32 result = extent >> level;
+	return result > 0 ? result : 1;
+}
+
+inline SizeType GetTextureLevelSize(TextureFormat format, u32 width, u32 height, u32 level)
+{
+	const SizeType w = GetTextureLevelExtent(width, level);
+	const SizeType h = GetTextureLevelExtent(height, level);
+	if (IsBlockCompressed(format))
+		return ((w + 3) / 4) * ((h + 3) / 4) * GetTextureFormatSize(format);
+	return w * h * GetTextureFormatSize(format);
+}
+
+inline SizeType GetTextureSize(TextureFormat format, u32 width, u32 height, u32 mipCount)
+{
+	SizeType size = 0;
+	for (u32 level = 0; level < mipCount; ++level)
+		size += GetTextureLevelSize(format, width, height, level);
+	return size;
+}
+
 struct BufferData
 {
 	BufferData() {}
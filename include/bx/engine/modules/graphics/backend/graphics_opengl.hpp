@@ -28,6 +28,10 @@
 #define TEXTURE_FREE_MEMORY_ATI                         0x87FC
 #define RENDERBUFFER_FREE_MEMORY_ATI                    0x87FD
 
+// EXT_texture_compression_s3tc is not part of core, BC5 and BC7 are (RGTC and BPTC)
+#define COMPRESSED_RGBA_S3TC_DXT1_EXT                   0x83F1
+#define COMPRESSED_RGBA_S3TC_DXT5_EXT                   0x83F3
+
 #define MAX_BOUND_VERTEX_BUFFERS                        16
 
 struct ShaderImpl
@@ -8,6 +8,9 @@
 #include "bx/engine/containers/string.hpp"
 #include "bx/engine/containers/array.hpp"
 #include "bx/engine/containers/list.hpp"
+#include "bx/engine/containers/hash_map.hpp"
+
+#include <functional>
 
 using BindApiFn = void(*)();
 
@@ -33,6 +36,8 @@ struct ScriptClassInfo
 //	GetDataFn getDataFn = nullptr;
 //};
 
+struct ScriptObj;
+
 struct ComponentClassWrapper
 {
 	using HasComponentFn = void(*)(WrenVM*, Entity);
@@ -40,10 +45,34 @@ struct ComponentClassWrapper
 	using GetComponentFn = void(*)(WrenVM*, Entity);
 	using RemoveComponentFn = void(*)(WrenVM*, Entity);
 
+	// Component objects that queries create once and point at another entity on every step
+	using NewComponentRefFn = ScriptObj*(*)(WrenVM*, i32);
+	using SetComponentRefFn = void(*)(ScriptObj*, Entity);
+
 	HasComponentFn hasComponentFn = nullptr;
 	AddComponentFn addComponentFn = nullptr;
 	GetComponentFn getComponentFn = nullptr;
 	RemoveComponentFn removeComponentFn = nullptr;
+
+	ComponentMask mask;
+	NewComponentRefFn newComponentRefFn = nullptr;
+	SetComponentRefFn setComponentRefFn = nullptr;
+};
+
+// Sampled only profiles one frame in every interval, which keeps the cost out of the frames in between
+enum struct ScriptProfileMode { OFF, SAMPLED, FULL };
+
+struct ScriptProfileData
+{
+	u64 calls = 0;
+
+	// Milliseconds, exclusive leaves out the calls into scripts made from within
+	f64 inclusive = 0.0;
+	f64 exclusive = 0.0;
+
+	// Growth of the script heap, calls that a collection happened in only count towards collections
+	i64 allocated = 0;
+	u64 collections = 0;
 };
 
 class Script
@@ -54,6 +83,28 @@ public:
 	static bool HasError();
 	static void ClearError();
 
+	// Profiles the calls the host makes into scripts by name, e.g. "Player.update()" for the update of a game object class.
+	// The functions scripts call among themselves are not broken down, the calls on worker VMs are merged in.
+	static void SetProfileMode(ScriptProfileMode mode, u32 interval = 30);
+	static ScriptProfileMode GetProfileMode();
+	static const HashMap<String, ScriptProfileData>& GetProfile();
+	static void ResetProfile();
+
+	// Only pair these while IsProfiling, which doesn't change within a frame.
+	// The allocations are measured on the heap of the VM being called.
+	static bool IsProfiling();
+	static void BeginProfile(WrenVM* vm, const String& name);
+	static void EndProfile();
+
+	// Game objects of job safe classes live on worker VMs, one per thread, when "Script Workers" in the
+	// system data is above zero. Every worker VM compiles the same modules and shares the foreign bindings.
+	static u32 GetWorkerCount();
+	static bool IsOnWorker();
+
+	// Runs fn once per worker on its own thread and waits for all of them. The commands deferred
+	// meanwhile, structural changes such as destroying a game object, run afterwards on this thread.
+	static void RunWorkers(const std::function<void(u32)>& fn);
+
 	static void BeginModule(const char* moduleName);
 	static void EndModule();
 
@@ -98,7 +149,10 @@ private:
 	static void Update();
 	static void Render();
 
-	static void CollectGarbage();
+	// Collects between frames only when the heap nears the point where Wren would collect on its own.
+	// Collections are started earlier while the last one took less than the budget (in milliseconds).
+	// The worker VMs are collected here too, with what is left of the budget.
+	static void CollectGarbage(f32 budget = 1.0f);
 
 	template<typename T>
 	friend struct ScriptArg;
@@ -761,6 +815,17 @@ void Script::BeginComponentClass(const char* className)
 		e.RemoveComponent<TCmp>();
 	};
 
+	wrapper.mask = ComponentId<TCmp>::Mask();
+	wrapper.newComponentRefFn = [](WrenVM* vm, i32 slot) -> ScriptObj*
+	{
+		Script::SetClass<TCmp>(vm, slot);
+		return new (ScriptArg<void*>::Set(vm, slot, slot, sizeof(ScriptObjPtr<TCmp>))) ScriptObjPtr<TCmp>(nullptr);
+	};
+	wrapper.setComponentRefFn = [](ScriptObj* obj, Entity e)
+	{
+		static_cast<ScriptObjPtr<TCmp>*>(obj)->obj = &e.GetComponent<TCmp>();
+	};
+
 	RegisterComponentClass(Type<TCmp>::Id(), wrapper);
 }
 
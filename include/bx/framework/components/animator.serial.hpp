@@ -6,6 +6,7 @@
 #include "bx/framework/resources/animation.serial.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/math.serial.hpp>
 
 template <>
@@ -26,4 +27,4 @@ struct Serial<Animator>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, Animator)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(Animator)
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "bx/framework/components/audio_source.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/math.serial.hpp>
 
 template <>
@@ -19,4 +20,4 @@ struct Serial<AudioSource>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, AudioSource)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(AudioSource)
\ No newline at end of file
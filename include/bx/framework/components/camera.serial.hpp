@@ -3,6 +3,7 @@
 #include "bx/framework/components/camera.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 
 template <>
 struct Serial<Camera>
@@ -28,4 +29,4 @@ struct Serial<Camera>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, Camera)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(Camera)
\ No newline at end of file
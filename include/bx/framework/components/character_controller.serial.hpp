@@ -3,6 +3,7 @@
 #include "bx/framework/components/character_controller.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/math.serial.hpp>
 
 template <>
@@ -27,4 +28,4 @@ struct Serial<CharacterController>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, CharacterController)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(CharacterController)
\ No newline at end of file
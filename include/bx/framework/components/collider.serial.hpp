@@ -5,6 +5,7 @@
 #include "bx/framework/resources/mesh.serial.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/type.serial.hpp>
 #include <bx/engine/core/math.serial.hpp>
 #include <bx/engine/core/resource.serial.hpp>
@@ -41,4 +42,4 @@ struct Serial<Collider>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, Collider)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(Collider)
\ No newline at end of file
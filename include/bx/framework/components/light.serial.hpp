@@ -3,6 +3,7 @@
 #include "bx/framework/components/light.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/math.serial.hpp>
 
 template <>
@@ -33,4 +34,4 @@ struct Serial<Light>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, Light)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(Light)
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "bx/framework/resources/mesh.serial.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/resource.serial.hpp>
 #include <bx/engine/containers/list.serial.hpp>
 
@@ -24,4 +25,4 @@ struct Serial<MeshFilter>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, MeshFilter)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(MeshFilter)
\ No newline at end of file
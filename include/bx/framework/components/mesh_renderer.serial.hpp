@@ -5,6 +5,7 @@
 #include "bx/framework/resources/material.serial.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/resource.serial.hpp>
 #include <bx/engine/containers/list.serial.hpp>
 
@@ -34,4 +35,4 @@ struct Serial<MeshRenderer>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, MeshRenderer)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(MeshRenderer)
\ No newline at end of file
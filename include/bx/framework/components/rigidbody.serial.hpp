@@ -3,6 +3,7 @@
 #include "bx/framework/components/rigidbody.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 
 template <>
 struct Serial<RigidBody>
@@ -32,4 +33,4 @@ struct Serial<RigidBody>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, RigidBody)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(RigidBody)
\ No newline at end of file
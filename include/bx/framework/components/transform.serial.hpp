@@ -3,6 +3,7 @@
 #include "bx/framework/components/transform.hpp"
 
 #include <bx/engine/core/serial.serial.hpp>
+#include <bx/engine/core/ecs.serial.hpp>
 #include <bx/engine/core/math.serial.hpp>
 #include <bx/engine/containers/string.serial.hpp>
 
@@ -27,4 +28,4 @@ struct Serial<Transform>
 	}
 };
 
-REGISTER_POLYMORPHIC_SERIAL(ComponentBase, Transform)
\ No newline at end of file
+REGISTER_COMPONENT_SERIAL(Transform)
\ No newline at end of file
@@ -7,11 +7,18 @@
 #include <bx/engine/containers/hash_map.hpp>
 
 #include <functional>
+#include <memory>
 
 struct GameObjectData;
 class GameObjectBase;
 class GameObject;
 class Scene;
+class Prefab;
+
+class IComponentSerializer;
+class MemoryStream;
+
+namespace cereal { class PortableBinaryInputArchive; }
 
 using GameObjectBindClassFn = std::function<void()>;
 using GameObjectConstructFn = std::function<bool(const GameObjectData&)>;
@@ -37,6 +44,28 @@ struct GameObjectData
 	static void Save(const String& filepath, const GameObjectData& data);
 };
 
+// A game object file parsed once and kept as templates to copy instances from.
+// The serializer of each component is looked up up front, so instances copy one component type at a time.
+class Prefab
+{
+public:
+	// Cached by filename until the file changes
+	static std::shared_ptr<Prefab> Load(const String& filename);
+	static void ClearCache();
+
+	inline const GameObjectData& GetData() const { return m_data; }
+
+private:
+	friend class GameObject;
+
+	GameObjectData m_data;
+	u64 m_lastWrite = 0;
+
+	// Per component of m_data, the serializer is null for types without one
+	List<TypeId> m_typeIds;
+	List<const IComponentSerializer*> m_serializers;
+};
+
 class GameObjectBase
 {
 public:
@@ -53,6 +82,10 @@ public:
 
 	inline Entity GetEntity() const { return m_entity; }
 
+	// Zero updates on the main thread, the others in parallel with one job per group
+	inline u32 GetUpdateGroup() const { return m_updateGroup; }
+	inline void SetUpdateGroup(u32 group) { m_updateGroup = group; }
+
 	inline void Bind() const
 	{
 		BX_ASSERT(m_bindObjFn, "No bind function bound!");
@@ -87,7 +120,10 @@ private:
 	template <typename T>
 	friend class Inspector;
 
+	friend class SceneSnapshot;
+
 	bool m_started = false;
+	u32 m_updateGroup = 0;
 
 	Scene& m_scene;
 	Entity m_entity;
@@ -116,9 +152,14 @@ public:
 	static GameObjectBase& NewFromData(Scene& scene, const GameObjectData& data);
 
 	static GameObjectBase& Load(Scene& scene, const String& filepath);
+
+	// Creates count instances of the prefab, placed by the transforms when given (one per instance)
+	static List<GameObjectBase*> Instantiate(Scene& scene, const Prefab& prefab, SizeType count, const Mat4* pTransforms = nullptr);
 	static void Save(const GameObjectBase& gameObj, const String& filepath);
 
 	static GameObjectBase& Find(Scene& scene, EntityId entityId);
+	// Null when the entity has no game object in the scene, such as one that is already destroyed
+	static GameObjectBase* TryFind(Scene& scene, EntityId entityId);
 	static GameObjectBase& Duplicate(const GameObjectBase& gameObj);
 };
 
@@ -130,6 +171,15 @@ public:
 	static void Load(const String& filename);
 	static void Save(const String& filename);
 
+	// Converts a JSON scene to a binary one and back, the format of the source is detected.
+	// The editor saves JSON, binary scenes load in a fraction of the time.
+	static bool Convert(const String& srcFilename, const String& dstFilename);
+	static String GetBinaryFilename(const String& filename);
+
+	// Reads a JSON or binary scene without creating its game objects
+	static bool Read(const String& filename, List<GameObjectData>& gameObjs);
+	static bool WriteBinary(const String& filename, const List<GameObjectData>& gameObjs);
+
 	static Scene& GetCurrent();
 
 	void Update();
@@ -142,32 +192,112 @@ public:
 	inline const List<GameObjectBase*>& GetGameObjects() const { return m_gameObjects; }
 
 private:
-	inline void Add(GameObjectBase* gameObj)
-	{
-		m_pendingAdded.emplace_back(gameObj);
-		m_gameObjects.emplace_back(gameObj);
-	}
-
-	inline void Remove(GameObjectBase* gameObj)
-	{
-		m_pendingRemoved.emplace_back(gameObj);
-		auto it = std::find_if(m_gameObjects.begin(), m_gameObjects.end(),
-			[gameObj](const GameObjectBase* i)
-			{
-				return i->GetEntity() == gameObj->GetEntity();
-			});
-		m_gameObjects.erase(it);
-	}
+	void Add(GameObjectBase* gameObj);
+	// Queues the entity for destruction at the end of the update
+	void Remove(GameObjectBase* gameObj);
+	// Drops the game object of the entity from the scene
+	void Erase(EntityId entityId);
+	void FillHoles();
+	void Clear();
 
 private:
 	friend class GameObject;
 	friend class GameObjectBase;
 	friend class GameObjectReceiver;
+	friend class SceneSnapshot;
 
 	template <typename T>
 	friend class Serial;
 
-	List<GameObjectBase*> m_pendingAdded;
-	List<GameObjectBase*> m_pendingRemoved;
+	List<EntityId> m_pendingAdded;
+	List<Entity> m_pendingRemoved;
 	List<GameObjectBase*> m_gameObjects;
+
+	// Position of each game object in m_gameObjects, removal swaps the last one into its place
+	HashMap<EntityId, SizeType> m_indices;
+
+	// Removal during the update loop leaves a hole instead, so every game object is visited once
+	bool m_isUpdating = false;
+	List<SizeType> m_holes;
+
+	// Game objects of each parallel update group, gathered every update
+	List<List<GameObjectBase*>> m_updateGroups;
+};
+
+// The components of one type in a binary scene
+struct SceneBlock
+{
+	const IComponentSerializer* pSerializer = nullptr;
+	u32 count = 0;
+};
+
+// Loads a binary scene in steps, so a large one can be spread over several frames.
+// Read only touches the file and may run on a worker thread, the rest runs on the main thread.
+class SceneReader
+{
+public:
+	SceneReader();
+	~SceneReader();
+
+	bool Read(const String& filename);
+	// Reads an uncompressed archive, such as the one of a snapshot, the name is only for the log
+	bool Read(const String& name, const u8* pArchive, SizeType archiveSize);
+
+	inline const String& GetFilename() const { return m_filename; }
+	inline SizeType GetObjectCount() const { return m_gameObjs.size(); }
+	inline const List<SceneBlock>& GetBlocks() const { return m_blocks; }
+
+	// Sizes the entity registries and component pools for every object in the scene
+	void Reserve() const;
+
+	// Creates up to count game objects and returns the number created. Creating all of them at once loads
+	// the components straight into the pools, a smaller batch decodes them first so that every game object
+	// already has its components when it starts.
+	SizeType Instantiate(Scene& scene, SizeType count);
+	inline bool IsFinished() const { return m_isFinished; }
+
+	// Entities of the game objects created so far
+	inline const List<Entity>& GetEntities() const { return m_entities; }
+
+private:
+	bool ReadTables();
+	void DecodeBlocks();
+	void LoadBlocks();
+	void ReleaseArchive();
+
+	String m_filename;
+	List<u8> m_buffer;
+	std::unique_ptr<MemoryStream> m_stream;
+	std::unique_ptr<cereal::PortableBinaryInputArchive> m_archive;
+
+	List<GameObjectData> m_gameObjs;
+	List<SceneBlock> m_blocks;
+	List<GameObjectBase*> m_objects;
+	List<Entity> m_entities;
+	bool m_isDecoded = false;
+	bool m_isFinished = false;
+};
+
+// An in memory copy of a scene in the binary scene layout, so leaving play mode doesn't go through
+// JSON on disk and the world can be rolled back to an earlier frame
+class SceneSnapshot
+{
+public:
+	// Copies the game objects of the scene and the components of their entities
+	void Capture(const Scene& scene);
+
+	// Destroys the game objects of the scene and creates the ones of the snapshot again, script objects included.
+	// The old script objects are left without an entity, script state outside of game objects isn't reset.
+	bool Restore(Scene& scene) const;
+
+	// Loads the components back into the entities that still exist, without recreating any game object.
+	// Game objects created since the capture stay and destroyed ones don't come back, scripts keep their state.
+	bool Rollback() const;
+
+	inline bool IsEmpty() const { return m_archive.empty(); }
+	inline SizeType GetSize() const { return m_archive.size(); }
+	inline void Clear() { m_archive = List<u8>(); }
+
+private:
+	List<u8> m_archive;
 };
\ No newline at end of file
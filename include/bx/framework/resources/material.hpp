@@ -1,10 +1,12 @@
 #pragma once
 
+#include "bx/framework/resources/mesh.hpp"
 #include "bx/framework/resources/shader.hpp"
 #include "bx/framework/resources/texture.hpp"
 
 #include <bx/engine/core/math.hpp>
 #include <bx/engine/core/resource.hpp>
+#include <bx/engine/containers/array.hpp>
 #include <bx/engine/containers/string.hpp>
 #include <bx/engine/containers/list.hpp>
 #include <bx/engine/modules/graphics.hpp>
@@ -22,11 +24,13 @@ public:
 	inline void RemoveTexture(const String& name) { m_textures.erase(m_textures.find(name)); }
 	inline const HashMap<String, Resource<Texture>>& GetTextures() const { return m_textures; }
 
-	inline GraphicsHandle GetPipeline() const { return m_pipeline; }
+	// Pipelines are created on first use for each mesh vertex layout
+	GraphicsHandle GetPipeline(MeshVertexLayout layout = MeshVertexLayout::STANDARD) const;
 	inline GraphicsHandle GetResources() const { return m_resources; }
 
 private:
 	void BuildPipeline();
+	void DestroyPipelines() const;
 
 private:
 	template <typename T>
@@ -39,7 +43,7 @@ private:
 	friend class Inspector;
 
 private:
-	GraphicsHandle m_pipeline = INVALID_GRAPHICS_HANDLE;
+	mutable Array<GraphicsHandle, MESH_VERTEX_LAYOUT_COUNT> m_pipelines = {{ INVALID_GRAPHICS_HANDLE, INVALID_GRAPHICS_HANDLE, INVALID_GRAPHICS_HANDLE }};
 	GraphicsHandle m_resources = INVALID_GRAPHICS_HANDLE;
 
 	Resource<Shader> m_shader;
@@ -2,8 +2,16 @@
 
 #include <bx/engine/core/math.hpp>
 #include <bx/engine/containers/list.hpp>
+#include <bx/engine/containers/string.hpp>
 #include <bx/engine/modules/graphics.hpp>
 
+// STANDARD keeps every attribute at full precision.
+// COMPACT quantizes color to unorm8, normal and tangent to snorm 10-10-10-2
+// and uvs to half floats, and drops the skinning streams.
+// COMPACT_SKINNED adds bone indices as i8 and weights as unorm8.
+ENUM(MeshVertexLayout, STANDARD, COMPACT, COMPACT_SKINNED);
+constexpr u32 MESH_VERTEX_LAYOUT_COUNT = 3;
+
 class Mesh
 {
 public:
@@ -18,6 +26,33 @@ public:
 		Vec4 weights;
 	};
 
+	struct CompactVertex
+	{
+		Vec3 position;
+		u32 color;
+		u32 normal;
+		u32 tangent;
+		u16 uv[2];
+	};
+
+	struct CompactSkinnedVertex
+	{
+		Vec3 position;
+		u32 color;
+		u32 normal;
+		u32 tangent;
+		u16 uv[2];
+		i8 bones[4];
+		u8 weights[4];
+	};
+
+	// A mesh without submeshes is drawn as a single range
+	struct Submesh
+	{
+		u32 indexOffset = 0;
+		u32 indexCount = 0;
+	};
+
 public:
 	Mesh() {}
 	Mesh(
@@ -39,34 +74,53 @@ public:
 		, m_bones(bones)
 		, m_weights(weights)
 		, m_triangles(triangles)
-	{}
+		, m_vertexCount(static_cast<u32>(vertices.size()))
+		, m_indexCount(static_cast<u32>(triangles.size()))
+	{
+		RecalculateBounds();
+	}
 
 	inline const Mat4& GetMatrix() const { return m_transform; }
 	inline void SetMatrix(const Mat4& matrix) { m_transform = matrix; }
 
-	inline const List<Vec3>& GetVertices() const { return m_vertices; }
-	inline void SetVertices(const List<Vec3>& vertices) { m_vertices = vertices; }
+	inline const List<Vec3>& GetVertices() const { Materialize(); return m_vertices; }
+	inline void SetVertices(const List<Vec3>& vertices) { Materialize(); m_vertices = vertices; m_vertexCount = static_cast<u32>(vertices.size()); }
+
+	inline const List<Vec4>& GetColors() const { Materialize(); return m_colors; }
+	inline void SetColors(const List<Vec4>& colors) { Materialize(); m_colors = colors; }
+
+	inline const List<Vec3>& GetNormals() const { Materialize(); return m_normals; }
+	inline void SetNormals(const List<Vec3>& normals) { Materialize(); m_normals = normals; }
 
-	inline const List<Vec4>& GetColors() const { return m_colors; }
-	inline void SetColors(const List<Vec4>& colors) { m_colors = colors; }
+	inline const List<Vec3>& GetTangents() const { Materialize(); return m_tangents; }
+	inline void SetTangents(const List<Vec3>& tangents) { Materialize(); m_tangents = tangents; }
 
-	inline const List<Vec3>& GetNormals() const { return m_normals; }
-	inline void SetNormals(const List<Vec3>& normals) { m_normals = normals; }
+	inline const List<Vec2>& GetUvs() const { Materialize(); return m_uvs; }
+	inline void SetUvs(const List<Vec2>& uvs) { Materialize(); m_uvs = uvs; }
 
-	inline const List<Vec3>& GetTangents() const { return m_tangents; }
-	inline void SetTangents(const List<Vec3>& tangents) { m_tangents = tangents; }
+	inline const List<Vec4i>& GetBones() const { Materialize(); return m_bones; }
+	inline void SetBoneIds(const List<Vec4i>& bones) { Materialize(); m_bones = bones; }
 
-	inline const List<Vec2>& GetUvs() const { return m_uvs; }
-	inline void SetUvs(const List<Vec2>& uvs) { m_uvs = uvs; }
+	inline const List<Vec4>& GetWeights() const { Materialize(); return m_weights; }
+	inline void SetWeights(const List<Vec4>& weights) { Materialize(); m_weights = weights; }
 
-	inline const List<Vec4i>& GetBones() const { return m_bones; }
-	inline void SetBoneIds(const List<Vec4i>& bones) { m_bones = bones; }
+	inline const List<u32>& GetTriangles() const { Materialize(); return m_triangles; }
+	inline void SetTriangles(const List<u32>& triangles) { Materialize(); m_triangles = triangles; m_indexCount = static_cast<u32>(triangles.size()); }
 
-	inline const List<Vec4>& GetWeights() const { return m_weights; }
-	inline void SetWeights(const List<Vec4>& weights) { m_weights = weights; }
+	inline MeshVertexLayout GetLayout() const { return m_layout; }
+	inline void SetLayout(MeshVertexLayout layout) { m_layout = layout; }
 
-	inline const List<u32>& GetTriangles() const { return m_triangles; }
-	inline void SetTriangles(const List<u32>& triangles) { m_triangles = triangles; }
+	static u32 GetVertexStride(MeshVertexLayout layout);
+	static const List<LayoutElement>& GetLayoutElements(MeshVertexLayout layout);
+
+	inline u32 GetVertexCount() const { return m_vertexCount; }
+	inline u32 GetIndexCount() const { return m_indexCount; }
+
+	inline const Box3& GetBounds() const { return m_bounds; }
+	void RecalculateBounds();
+
+	inline const List<Submesh>& GetSubmeshes() const { return m_submeshes; }
+	inline void SetSubmeshes(const List<Submesh>& submeshes) { m_submeshes = submeshes; }
 
 	inline GraphicsHandle GetVertexBuffers() const { return m_vbuffers; }
 	inline GraphicsHandle GetIndexBuffer() const { return m_ibuffer; }
@@ -78,15 +132,31 @@ private:
 	template <typename T>
 	friend class Resource;
 
+	// Meshes loaded from a mesh blob only keep the GPU buffers around,
+	// the per-attribute lists are read back from the file on first access.
+	inline void Materialize() const { if (!m_isMaterialized) LoadAttributes(); }
+	void LoadAttributes() const;
+
 	Mat4 m_transform;
-	List<Vec3> m_vertices;
-	List<Vec4> m_colors;
-	List<Vec3> m_normals;
-	List<Vec3> m_tangents;
-	List<Vec2> m_uvs;
-	List<Vec4i> m_bones;
-	List<Vec4> m_weights;
-	List<u32> m_triangles;
+	mutable List<Vec3> m_vertices;
+	mutable List<Vec4> m_colors;
+	mutable List<Vec3> m_normals;
+	mutable List<Vec3> m_tangents;
+	mutable List<Vec2> m_uvs;
+	mutable List<Vec4i> m_bones;
+	mutable List<Vec4> m_weights;
+	mutable List<u32> m_triangles;
+
+	MeshVertexLayout m_layout = MeshVertexLayout::STANDARD;
+	u32 m_vertexCount = 0;
+	u32 m_indexCount = 0;
+	Box3 m_bounds;
+	List<Submesh> m_submeshes;
+
+	String m_filename;
+	mutable bool m_isMaterialized = true;
+	// Decompressed blob between Decode and Finalize
+	List<u8> m_blob;
 
 	GraphicsHandle m_vbuffers = INVALID_GRAPHICS_HANDLE;
 	GraphicsHandle m_ibuffer = INVALID_GRAPHICS_HANDLE;
@@ -17,6 +17,8 @@ public:
 	template<class Archive>
 	static void Save(Archive& ar, const Mesh& data)
 	{
+		data.Materialize();
+
 		ar(cereal::make_nvp("transform", data.m_transform));
 		ar(cereal::make_nvp("vertices", data.m_vertices));
 		ar(cereal::make_nvp("colors", data.m_colors));
@@ -40,6 +42,11 @@ public:
 		ar(cereal::make_nvp("bones", data.m_bones));
 		ar(cereal::make_nvp("weights", data.m_weights));
 		ar(cereal::make_nvp("triangles", data.m_triangles));
+
+		data.m_vertexCount = static_cast<u32>(data.m_vertices.size());
+		data.m_indexCount = static_cast<u32>(data.m_triangles.size());
+		data.m_isMaterialized = true;
+		data.RecalculateBounds();
 	}
 };
 REGISTER_SERIAL(Mesh);
\ No newline at end of file
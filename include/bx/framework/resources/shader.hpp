@@ -1,10 +1,13 @@
 #pragma once
 
 #include <bx/engine/core/math.hpp>
+#include <bx/engine/core/file.hpp>
 #include <bx/engine/containers/string.hpp>
 #include <bx/engine/containers/list.hpp>
 #include <bx/engine/modules/graphics.hpp>
 
+#include <memory>
+
 class Shader
 {
 public:
@@ -24,6 +27,8 @@ private:
 	List<String> m_includes;
 	List<String> m_macros;
 	String m_source;
+	// Source file mapped by Decode, compiled from directly and released in Finalize
+	std::shared_ptr<MappedFile> m_file;
 	GraphicsHandle m_vertex = INVALID_GRAPHICS_HANDLE;
 	GraphicsHandle m_pixel = INVALID_GRAPHICS_HANDLE;
 };
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <bx/engine/core/math.hpp>
+#include <bx/engine/core/file.hpp>
+#include <bx/engine/core/resource.hpp>
 #include <bx/engine/modules/graphics.hpp>
 
+#include <memory>
+
 class Texture
 {
 public:
@@ -10,10 +14,17 @@ public:
 	i32 width = 0;
 	i32 height = 0;
 	i32 depth = 0;
+	// Format of pixels, which holds mipCount levels tightly packed with the base level first
+	TextureFormat format = TextureFormat::RGBA8_UNORM;
+	i32 mipCount = 1;
 	List<u8> pixels;
 
 	inline GraphicsHandle GetTexture() const { return m_texture; }
 
+	// Finest level on the GPU, streamed textures start at their base level and page in finer ones on demand
+	inline u32 GetResidentMip() const { return m_residentMip; }
+	inline bool IsStreamed() const { return m_baseMip > 0; }
+
 private:
 	template <typename T>
 	friend class Serial;
@@ -21,5 +32,49 @@ private:
 	template <typename T>
 	friend class Resource;
 
+	friend class TextureStreamer;
+
 	GraphicsHandle m_texture = INVALID_GRAPHICS_HANDLE;
+	u32 m_residentMip = 0;
+	u32 m_baseMip = 0;
+
+	// Pixels still in the mapped file, uploaded from directly by Finalize instead of copying into pixels
+	std::shared_ptr<MappedFile> m_file;
+	FileView m_fileView;
+	// Pixels decompressed by Decode, released by Finalize after the upload
+	List<u8> m_staging;
+};
+
+// Levels up to this size are uploaded when a streamed texture loads
+constexpr u32 TEXTURE_STREAMING_MIN_SIZE = 64;
+// Textures that were not requested for this many frames fall back to their base level
+constexpr u32 TEXTURE_STREAMING_GRACE_FRAMES = 120;
+constexpr u32 TEXTURE_STREAMING_MAX_JOBS = 4;
+
+// Pages the finer mips of streamed textures in and out, driven by the levels the renderer requests each frame
+class TextureStreamer
+{
+public:
+	static void Shutdown();
+
+	// Only applies to textures loaded afterwards, the others keep every level resident
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled();
+
+	// GPU memory (in bytes) of the requested textures. When the requests do not fit, every texture
+	// gets the same number of levels coarser than it asked for.
+	static void SetBudget(SizeType budget);
+	static SizeType GetBudget();
+	static SizeType GetResidentSize();
+
+	// The finest level requested within a frame wins, fractions are rounded towards the finer level
+	static void Request(const Resource<Texture>& texture, f32 mip);
+
+	// Once per frame after the requests, queues the level changes that fit in the budget
+	static void Update();
+
+private:
+	friend class TextureStreamJob;
+
+	static void FinishLoad(const Resource<Texture>& texture, GraphicsHandle previous, u32 mip, const u8* pLevels, SizeType size);
 };
\ No newline at end of file
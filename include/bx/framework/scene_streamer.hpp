@@ -0,0 +1,53 @@
+#pragma once
+
+#include <bx/engine/core/byte_types.hpp>
+#include <bx/engine/core/math.hpp>
+#include <bx/engine/containers/string.hpp>
+
+#include <memory>
+
+class SceneReader;
+
+constexpr f32 SCENE_STREAMING_CELL_SIZE = 128.0f;
+constexpr f32 SCENE_STREAMING_RADIUS = 256.0f;
+// Cells stay loaded until every anchor is this fraction of the radius further away, so walking
+// along a cell border doesn't load and unload it every other frame
+constexpr f32 SCENE_STREAMING_UNLOAD_MARGIN = 0.25f;
+constexpr u32 SCENE_STREAMING_BUDGET = 64;
+constexpr u32 SCENE_STREAMING_MAX_JOBS = 4;
+
+// Streams the cells of a partitioned scene in and out around anchors, such as the camera or the player.
+// Cells are read on worker threads and their game objects are created a budgeted number per frame.
+class SceneStreamer
+{
+public:
+	// Splits a scene into cubic cells by the position of each game object and writes every cell as a binary
+	// sub-scene next to it, along with an index. Objects without a transform go to the global sub-scene.
+	static bool Partition(const String& filename, f32 cellSize);
+	static String GetIndexFilename(const String& filename);
+
+	// Loads the global sub-scene of a partitioned scene, the cells follow as anchors come near
+	static bool Open(const String& filename);
+	// Stops streaming, game objects of the loaded cells stay in the scene
+	static void Close();
+	static bool IsOpen();
+
+	static void SetRadius(f32 radius);
+	static f32 GetRadius();
+
+	// Maximum number of game objects created per frame
+	static void SetBudget(u32 budget);
+	static u32 GetBudget();
+
+	// Anchors only last for the current frame, without any the cameras are used
+	static void AddAnchor(const Vec3& position);
+
+	static SizeType GetCellCount();
+	static SizeType GetLoadedCount();
+
+	static void Update();
+
+private:
+	friend class SceneCellLoadJob;
+	static void FinishLoad(u32 session, u32 cell, u32 generation, const std::shared_ptr<SceneReader>& reader);
+};
\ No newline at end of file
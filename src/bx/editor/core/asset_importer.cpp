@@ -1,4 +1,6 @@
 #include "bx/editor/core/asset_importer.hpp"
+#include "bx/editor/core/mesh_optimizer.hpp"
+#include "bx/editor/core/texture_compressor.hpp"
 
 #include <bx/engine/core/file.hpp>
 #include <bx/engine/core/resource.hpp>
@@ -24,12 +26,16 @@
 #include <fstream>
 #include <sstream>
 
+// Writes the imported data without registering it, a resource loaded from the file goes through Decode/Finalize
 template <typename T>
-static Resource<T> ImportResource(const String& filename, const T& data)
+static bool ImportResource(const String& filename, const T& data)
 {
-    auto res = Resource<T>(Resource<T>::MakeHandle(filename), data);
-    res.Save(filename);
-    return res;
+    if (!Resource<T>::Save(filename, data))
+    {
+        BX_LOGE("Failed to save imported resource ({})", filename);
+        return false;
+    }
+    return true;
 }
 
 bool AssetImporter::ImportTexture(const String& filename)
@@ -48,8 +54,9 @@ bool AssetImporter::ImportTexture(const String& filename)
     memcpy(texture.pixels.data(), pData, texture.pixels.size());
     stbi_image_free(pData);
 
-    auto res = ImportResource(File::RemoveExt(filename) + ".texture", texture);
-    return res.IsValid();
+    TextureCompressor::Compress(texture, filename);
+
+    return ImportResource(File::RemoveExt(filename) + ".texture", texture);
 }
 
 template <typename TData>
@@ -101,6 +108,8 @@ static void AssimpLoadTexture(const aiTexture* pTexture, ModelData& data)
     memcpy(tex.pixels.data(), pData, tex.pixels.size());
     stbi_image_free(pData);
 
+    TextureCompressor::Compress(tex, pTexture->mFilename.C_Str());
+
     ModelDataWrapper<Texture> entry;
     entry.name = String("_") + pTexture->mFilename.C_Str();
     entry.data = tex;
@@ -334,6 +343,8 @@ static void AssimpLoadMesh(const aiScene* pScene, const aiNode* pNode, ModelData
 
         Mat4 transform = AssimpMat4(pNode->mTransformation);
         Mesh mesh(transform, vertices, colors, normals, tangents, uvs, bones, weights, triangles);
+        mesh.SetLayout(pMesh->HasBones() ? MeshVertexLayout::COMPACT_SKINNED : MeshVertexLayout::COMPACT);
+        MeshOptimizer::Optimize(mesh);
 
         ModelDataWrapper<Mesh> entry;
         entry.name = String("_") + pNode->mName.C_Str();
@@ -417,7 +428,7 @@ bool AssetImporter::ImportModel(const String& filename)
         aiProcess_GenSmoothNormals |
         aiProcess_SplitLargeMeshes |
         //aiProcess_ValidateDataStructure |
-        aiProcess_ImproveCacheLocality |
+        //aiProcess_ImproveCacheLocality | // Done by MeshOptimizer
         aiProcess_RemoveRedundantMaterials |
         aiProcess_OptimizeMeshes |
         //aiProcess_PopulateArmatureData |
@@ -446,7 +457,7 @@ bool AssetImporter::ImportModel(const String& filename)
         for (SizeType i = 0; i < data.textures.size(); ++i)
         {
             String name = File::RemoveExt(filename) + data.textures[i].name + "_" + std::to_string(i) + ".texture";
-            auto res = ImportResource(name, data.textures[i].data);
+            ImportResource(name, data.textures[i].data);
         }
     }
 
@@ -463,7 +474,7 @@ bool AssetImporter::ImportModel(const String& filename)
         for (SizeType i = 0; i < data.materials.size(); ++i)
         {
             String name = File::RemoveExt(filename) + data.materials[i].name + "_" + std::to_string(i) + ".material";
-            auto res = ImportResource(name, data.materials[i].data);
+            ImportResource(name, data.materials[i].data);
         }
     }
 
@@ -480,7 +491,7 @@ bool AssetImporter::ImportModel(const String& filename)
         for (SizeType i = 0; i < data.skeletons.size(); ++i)
         {
             String name = File::RemoveExt(filename) + data.skeletons[i].name + "_" + std::to_string(i) + ".skeleton";
-            auto res = ImportResource(name, data.skeletons[i].data);
+            ImportResource(name, data.skeletons[i].data);
         }
     }
 
@@ -497,7 +508,7 @@ bool AssetImporter::ImportModel(const String& filename)
         for (SizeType i = 0; i < data.meshes.size(); ++i)
         {
             String name = File::RemoveExt(filename) + data.meshes[i].name + "_" + std::to_string(i) + ".mesh";
-            auto res = ImportResource(name, data.meshes[i].data);
+            ImportResource(name, data.meshes[i].data);
         }
     }
 
@@ -514,7 +525,7 @@ bool AssetImporter::ImportModel(const String& filename)
         for (SizeType i = 0; i < data.animations.size(); ++i)
         {
             String name = File::RemoveExt(filename) + data.animations[i].name + "_" + std::to_string(i) + ".animation";
-            auto res = ImportResource(name, data.animations[i].data);
+            ImportResource(name, data.animations[i].data);
         }
     }
 
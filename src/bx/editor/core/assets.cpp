@@ -80,6 +80,9 @@ void AssetManager::Initialize()
     root.extension = "";
     root.isDirectory = true;
 
+    // The refresh thread below lists the whole tree continuously, serve it from memory
+    File::BuildIndex("[assets]");
+
     g_assetRoot = g_assetTree.CreateNode(root);
     CacheDirectory(g_assetTree, g_assetRoot);
 
@@ -0,0 +1,362 @@
+#include "bx/editor/core/mesh_optimizer.hpp"
+
+#include <bx/engine/core/macros.hpp>
+#include <bx/framework/resources/mesh.hpp>
+
+#include <algorithm>
+
+// Simulates a FIFO post-transform cache, returns the number of misses for a triangle
+class FifoCacheSim
+{
+public:
+	FifoCacheSim(u32 vertexCount, u32 cacheSize)
+		: m_timestamps(vertexCount, 0)
+		, m_cacheSize(cacheSize)
+		, m_time(cacheSize + 1)
+	{}
+
+	inline void Reset()
+	{
+		m_time += m_cacheSize + 1;
+	}
+
+	inline u32 Access(const u32* pTriangle)
+	{
+		u32 misses = 0;
+		for (u32 k = 0; k < 3; ++k)
+		{
+			const u32 v = pTriangle[k];
+			if (m_time - m_timestamps[v] > m_cacheSize)
+			{
+				m_timestamps[v] = m_time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+private:
+	List<u32> m_timestamps;
+	u32 m_cacheSize = 0;
+	u32 m_time = 0;
+};
+
+MeshCacheStats MeshOptimizer::AnalyzeVertexCache(const List<u32>& indices, u32 vertexCount, u32 cacheSize)
+{
+	MeshCacheStats stats;
+
+	const SizeType triCount = indices.size() / 3;
+	if (triCount == 0)
+		return stats;
+
+	FifoCacheSim cache(vertexCount, cacheSize);
+	List<u8> used(vertexCount, 0);
+
+	u32 misses = 0;
+	u32 uniqueCount = 0;
+	for (SizeType t = 0; t < triCount; ++t)
+	{
+		misses += cache.Access(&indices[t * 3]);
+
+		for (u32 k = 0; k < 3; ++k)
+		{
+			const u32 v = indices[t * 3 + k];
+			uniqueCount += used[v] ? 0 : 1;
+			used[v] = 1;
+		}
+	}
+
+	stats.acmr = static_cast<f32>(misses) / static_cast<f32>(triCount);
+	stats.atvr = static_cast<f32>(misses) / static_cast<f32>(uniqueCount);
+	return stats;
+}
+
+// See: Sander, Nehab, Barczak - Fast Triangle Reordering for Vertex Locality and Reduced Overdraw (2007)
+void MeshOptimizer::OptimizeVertexCache(List<u32>& indices, u32 vertexCount, u32 cacheSize, List<u32>& clusters)
+{
+	clusters.clear();
+
+	const u32 triCount = static_cast<u32>(indices.size() / 3);
+	if (triCount == 0)
+		return;
+
+	// Vertex to triangle adjacency in compressed rows
+	List<u32> live(vertexCount, 0);
+	for (u32 v : indices)
+		live[v]++;
+
+	List<u32> offsets(vertexCount + 1, 0);
+	for (u32 v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + live[v];
+
+	List<u32> adjacency(indices.size());
+	{
+		List<u32> cursors(offsets.begin(), offsets.end() - 1);
+		for (u32 t = 0; t < triCount; ++t)
+		{
+			for (u32 k = 0; k < 3; ++k)
+				adjacency[cursors[indices[t * 3 + k]]++] = t;
+		}
+	}
+
+	List<u32> timestamps(vertexCount, 0);
+	List<u8> emitted(triCount, 0);
+	List<u32> deadEnd;
+	List<u32> candidates;
+	List<u32> result;
+
+	deadEnd.reserve(indices.size());
+	result.reserve(indices.size());
+
+	u32 time = cacheSize + 1;
+	u32 cursor = 0;
+
+	// Pops the dead end stack, when it runs dry the next vertex is found by scanning
+	// in input order. Such a jump starts a new cluster since the cache is cold by then.
+	auto skipDeadEnd = [&](bool& isJump) -> u32
+	{
+		isJump = false;
+		while (!deadEnd.empty())
+		{
+			const u32 v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				return v;
+		}
+
+		isJump = true;
+		while (cursor < vertexCount)
+		{
+			if (live[cursor] > 0)
+				return cursor;
+			cursor++;
+		}
+
+		return MESH_OPTIMIZER_UNUSED;
+	};
+
+	bool isJump = false;
+	u32 fan = skipDeadEnd(isJump);
+	while (fan != MESH_OPTIMIZER_UNUSED)
+	{
+		if (isJump)
+			clusters.emplace_back(static_cast<u32>(result.size() / 3));
+
+		// Emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for (u32 a = offsets[fan]; a < offsets[fan + 1]; ++a)
+		{
+			const u32 t = adjacency[a];
+			if (emitted[t])
+				continue;
+
+			for (u32 k = 0; k < 3; ++k)
+			{
+				const u32 v = indices[t * 3 + k];
+				result.emplace_back(v);
+				deadEnd.emplace_back(v);
+				candidates.emplace_back(v);
+				live[v]--;
+
+				if (time - timestamps[v] > cacheSize)
+					timestamps[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		// Prefer the candidate that is oldest in the cache while still
+		// being resident after emitting all of its own triangles
+		u32 next = MESH_OPTIMIZER_UNUSED;
+		u32 bestPriority = 0;
+		for (u32 v : candidates)
+		{
+			if (live[v] == 0)
+				continue;
+
+			u32 priority = 0;
+			if (time - timestamps[v] + 2 * live[v] <= cacheSize)
+				priority = time - timestamps[v];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		isJump = false;
+		if (next == MESH_OPTIMIZER_UNUSED)
+			next = skipDeadEnd(isJump);
+
+		fan = next;
+	}
+
+	BX_ASSERT(result.size() == indices.size(), "Vertex cache optimization lost triangles!");
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(List<u32>& indices, const List<Vec3>& positions, const List<u32>& clusters, u32 cacheSize, f32 threshold)
+{
+	const u32 triCount = static_cast<u32>(indices.size() / 3);
+	if (triCount == 0)
+		return;
+
+	const u32 vertexCount = static_cast<u32>(positions.size());
+	const f32 targetAcmr = AnalyzeVertexCache(indices, vertexCount, cacheSize).acmr * threshold;
+
+	// Split the hard clusters further wherever the local cache efficiency is good enough,
+	// smaller clusters sort better but every split costs a cold cache
+	List<u32> starts;
+	{
+		FifoCacheSim cache(vertexCount, cacheSize);
+
+		u32 hard = 0;
+		u32 start = 0;
+		u32 misses = 0;
+		for (u32 t = 0; t < triCount; ++t)
+		{
+			const bool isHard = hard < clusters.size() && clusters[hard] == t;
+			if (t == 0 || isHard)
+			{
+				if (isHard)
+					hard++;
+
+				starts.emplace_back(t);
+				cache.Reset();
+				start = t;
+				misses = 0;
+			}
+
+			misses += cache.Access(&indices[t * 3]);
+
+			const u32 count = t - start + 1;
+			const bool isLast = t + 1 == triCount || (hard < clusters.size() && clusters[hard] == t + 1);
+			if (!isLast && count >= 8 && static_cast<f32>(misses) / static_cast<f32>(count) <= targetAcmr)
+			{
+				starts.emplace_back(t + 1);
+				cache.Reset();
+				start = t + 1;
+				misses = 0;
+			}
+		}
+	}
+
+	auto triangleNormal = [&](u32 t, Vec3& centroid) -> Vec3
+	{
+		const Vec3& a = positions[indices[t * 3 + 0]];
+		const Vec3& b = positions[indices[t * 3 + 1]];
+		const Vec3& c = positions[indices[t * 3 + 2]];
+		centroid = (a + b + c) / 3.0f;
+		// Length is twice the area, which weighs the averages below
+		return Vec3::Cross(b - a, c - a);
+	};
+
+	// Area weighted mesh centroid
+	Vec3 meshCentroid;
+	f32 meshArea = 0.0f;
+	for (u32 t = 0; t < triCount; ++t)
+	{
+		Vec3 centroid;
+		const f32 area = triangleNormal(t, centroid).Magnitude();
+		meshCentroid += centroid * area;
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCentroid = meshCentroid / meshArea;
+
+	// Clusters facing away from the center are the most likely occluders, draw them first
+	struct ClusterKey
+	{
+		u32 start;
+		u32 end;
+		f32 key;
+	};
+
+	List<ClusterKey> keys(starts.size());
+	for (SizeType i = 0; i < starts.size(); ++i)
+	{
+		auto& cluster = keys[i];
+		cluster.start = starts[i];
+		cluster.end = i + 1 < starts.size() ? starts[i + 1] : triCount;
+
+		Vec3 centroid;
+		Vec3 normal;
+		f32 area = 0.0f;
+		for (u32 t = cluster.start; t < cluster.end; ++t)
+		{
+			Vec3 triCentroid;
+			const Vec3 triNormal = triangleNormal(t, triCentroid);
+			const f32 triArea = Vec3(triNormal).Magnitude();
+
+			centroid += triCentroid * triArea;
+			normal += triNormal;
+			area += triArea;
+		}
+
+		if (area > 0.0f)
+			centroid = centroid / area;
+
+		const f32 length = normal.Magnitude();
+		if (length > 0.0f)
+			normal = normal / length;
+
+		cluster.key = Vec3::Dot(centroid - meshCentroid, normal);
+	}
+
+	std::stable_sort(keys.begin(), keys.end(),
+		[](const ClusterKey& a, const ClusterKey& b) { return a.key > b.key; });
+
+	List<u32> result;
+	result.reserve(indices.size());
+	for (const auto& cluster : keys)
+		result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+
+	indices.swap(result);
+}
+
+u32 MeshOptimizer::OptimizeVertexFetch(List<u32>& indices, u32 vertexCount, List<u32>& remap)
+{
+	remap.assign(vertexCount, MESH_OPTIMIZER_UNUSED);
+
+	u32 next = 0;
+	for (auto& index : indices)
+	{
+		if (remap[index] == MESH_OPTIMIZER_UNUSED)
+			remap[index] = next++;
+
+		index = remap[index];
+	}
+
+	return next;
+}
+
+void MeshOptimizer::Optimize(Mesh& mesh)
+{
+	List<u32> indices = mesh.GetTriangles();
+	const u32 vertexCount = mesh.GetVertexCount();
+	if (indices.empty() || vertexCount == 0)
+		return;
+
+	const auto before = AnalyzeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+	List<u32> clusters;
+	OptimizeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE, clusters);
+	OptimizeOverdraw(indices, mesh.GetVertices(), clusters, MESH_OPTIMIZER_CACHE_SIZE, 1.05f);
+
+	List<u32> remap;
+	const u32 newCount = OptimizeVertexFetch(indices, vertexCount, remap);
+
+	const auto after = AnalyzeVertexCache(indices, newCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+	mesh.SetVertices(RemapVertices(mesh.GetVertices(), remap, newCount));
+	mesh.SetColors(RemapVertices(mesh.GetColors(), remap, newCount));
+	mesh.SetNormals(RemapVertices(mesh.GetNormals(), remap, newCount));
+	mesh.SetTangents(RemapVertices(mesh.GetTangents(), remap, newCount));
+	mesh.SetUvs(RemapVertices(mesh.GetUvs(), remap, newCount));
+	mesh.SetBoneIds(RemapVertices(mesh.GetBones(), remap, newCount));
+	mesh.SetWeights(RemapVertices(mesh.GetWeights(), remap, newCount));
+	mesh.SetTriangles(indices);
+
+	BX_LOGI("Optimized mesh ({} triangles, {} -> {} vertices): ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+		indices.size() / 3, vertexCount, newCount, before.acmr, after.acmr, before.atvr, after.atvr);
+}
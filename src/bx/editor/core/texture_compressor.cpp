@@ -0,0 +1,607 @@
+#include "bx/editor/core/texture_compressor.hpp"
+
+#include <bx/engine/core/file.hpp>
+#include <bx/engine/core/macros.hpp>
+#include <bx/framework/resources/texture.hpp>
+
+#include <stb_image_resize2.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+constexpr u32 BLOCK_TEXELS = TEXTURE_COMPRESSOR_BLOCK_SIZE * TEXTURE_COMPRESSOR_BLOCK_SIZE;
+
+// BC7 interpolation weights of 4 bit indices, out of 64
+static const i32 s_bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Writes bit fields from the least significant bit up, the way BC7 blocks are laid out
+class BlockWriter
+{
+public:
+	explicit BlockWriter(u8* pDst)
+		: m_pDst(pDst)
+	{}
+
+	inline void Write(u32 value, u32 count)
+	{
+		for (u32 b = 0; b < count; ++b, ++m_bit)
+		{
+			if ((value >> b) & 1)
+				m_pDst[m_bit >> 3] |= static_cast<u8>(1 << (m_bit & 7));
+		}
+	}
+
+private:
+	u8* m_pDst = nullptr;
+	u32 m_bit = 0;
+};
+
+static inline f32 Saturate255(f32 v)
+{
+	return std::min(std::max(v, 0.0f), 255.0f);
+}
+
+// Fits a line through the texels of a block, the endpoints are the extremes of the texels projected on the
+// principal axis. The axis is found by power iteration on the covariance, seeded with the furthest texel.
+static void FitEndpoints(const u8* pBlock, u32 channels, f32 e0[4], f32 e1[4])
+{
+	f32 mean[4] = {};
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+		for (u32 c = 0; c < channels; ++c)
+			mean[c] += pBlock[i * 4 + c];
+	for (u32 c = 0; c < channels; ++c)
+		mean[c] /= BLOCK_TEXELS;
+
+	f32 cov[4][4] = {};
+	f32 axis[4] = {};
+	f32 furthest = 0.0f;
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		f32 d[4] = {};
+		f32 lengthSq = 0.0f;
+		for (u32 c = 0; c < channels; ++c)
+		{
+			d[c] = pBlock[i * 4 + c] - mean[c];
+			lengthSq += d[c] * d[c];
+		}
+
+		for (u32 a = 0; a < channels; ++a)
+			for (u32 b = 0; b < channels; ++b)
+				cov[a][b] += d[a] * d[b];
+
+		if (lengthSq > furthest)
+		{
+			furthest = lengthSq;
+			memcpy(axis, d, sizeof(axis));
+		}
+	}
+
+	for (u32 iteration = 0; iteration < 8 && furthest > 0.0f; ++iteration)
+	{
+		f32 next[4] = {};
+		f32 scale = 0.0f;
+		for (u32 a = 0; a < channels; ++a)
+		{
+			for (u32 b = 0; b < channels; ++b)
+				next[a] += cov[a][b] * axis[b];
+			scale = std::max(scale, std::abs(next[a]));
+		}
+
+		if (scale <= 0.0f)
+			break;
+
+		for (u32 c = 0; c < channels; ++c)
+			axis[c] = next[c] / scale;
+	}
+
+	f32 length = 0.0f;
+	for (u32 c = 0; c < channels; ++c)
+		length += axis[c] * axis[c];
+	length = std::sqrt(length);
+
+	f32 tMin = 0.0f;
+	f32 tMax = 0.0f;
+	if (length > 0.0f)
+	{
+		for (u32 c = 0; c < channels; ++c)
+			axis[c] /= length;
+
+		for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			f32 t = 0.0f;
+			for (u32 c = 0; c < channels; ++c)
+				t += (pBlock[i * 4 + c] - mean[c]) * axis[c];
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+	}
+
+	for (u32 c = 0; c < channels; ++c)
+	{
+		e0[c] = Saturate255(mean[c] + axis[c] * tMin);
+		e1[c] = Saturate255(mean[c] + axis[c] * tMax);
+	}
+}
+
+// Least squares endpoints for the selected indices, weights are the fraction of the second endpoint
+static bool RefineEndpoints(const u8* pBlock, u32 channels, const u8* pIndices, const f32* pWeights, f32 e0[4], f32 e1[4])
+{
+	f32 aa = 0.0f;
+	f32 bb = 0.0f;
+	f32 ab = 0.0f;
+	f32 ax[4] = {};
+	f32 bx[4] = {};
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		const f32 b = pWeights[pIndices[i]];
+		const f32 a = 1.0f - b;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (u32 c = 0; c < channels; ++c)
+		{
+			ax[c] += a * pBlock[i * 4 + c];
+			bx[c] += b * pBlock[i * 4 + c];
+		}
+	}
+
+	const f32 det = aa * bb - ab * ab;
+	if (std::abs(det) < 1e-6f)
+		return false;
+
+	for (u32 c = 0; c < channels; ++c)
+	{
+		e0[c] = Saturate255((ax[c] * bb - bx[c] * ab) / det);
+		e1[c] = Saturate255((bx[c] * aa - ax[c] * ab) / det);
+	}
+	return true;
+}
+
+// Picks the closest palette entry for every texel, returns the squared error
+static u32 SelectIndices(const u8* pBlock, u32 channels, const i32 (*pPalette)[4], u32 paletteSize, u8* pIndices)
+{
+	u32 error = 0;
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		u32 best = ~0u;
+		for (u32 p = 0; p < paletteSize; ++p)
+		{
+			u32 distance = 0;
+			for (u32 c = 0; c < channels; ++c)
+			{
+				const i32 d = pBlock[i * 4 + c] - pPalette[p][c];
+				distance += static_cast<u32>(d * d);
+			}
+
+			if (distance < best)
+			{
+				best = distance;
+				pIndices[i] = static_cast<u8>(p);
+			}
+		}
+		error += best;
+	}
+	return error;
+}
+
+struct ColorBlock
+{
+	u16 color0 = 0;
+	u16 color1 = 0;
+	u8 indices[BLOCK_TEXELS] = {};
+	u32 error = ~0u;
+};
+
+static u16 PackRgb565(const f32 color[3])
+{
+	const u32 r = static_cast<u32>(color[0] * 31.0f / 255.0f + 0.5f);
+	const u32 g = static_cast<u32>(color[1] * 63.0f / 255.0f + 0.5f);
+	const u32 b = static_cast<u32>(color[2] * 31.0f / 255.0f + 0.5f);
+	return static_cast<u16>((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRgb565(u16 packed, i32 color[4])
+{
+	const i32 r = (packed >> 11) & 31;
+	const i32 g = (packed >> 5) & 63;
+	const i32 b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+	color[3] = 255;
+}
+
+// Always uses the four color mode (color0 > color1), equal endpoints only need index 0
+static void QuantizeColorBlock(const u8* pBlock, const f32 e0[4], const f32 e1[4], ColorBlock& block)
+{
+	block.color0 = PackRgb565(e0);
+	block.color1 = PackRgb565(e1);
+	if (block.color0 < block.color1)
+		std::swap(block.color0, block.color1);
+
+	i32 palette[4][4];
+	UnpackRgb565(block.color0, palette[0]);
+	UnpackRgb565(block.color1, palette[1]);
+	for (u32 c = 0; c < 4; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	block.error = SelectIndices(pBlock, 3, palette, block.color0 == block.color1 ? 1 : 4, block.indices);
+}
+
+void TextureCompressor::EncodeBC1(const u8* pBlock, u8* pDst)
+{
+	static const f32 s_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	f32 e0[4];
+	f32 e1[4];
+	FitEndpoints(pBlock, 3, e0, e1);
+
+	ColorBlock best;
+	QuantizeColorBlock(pBlock, e0, e1, best);
+
+	for (u32 iteration = 0; iteration < 2 && best.error > 0 && best.color0 != best.color1; ++iteration)
+	{
+		i32 q0[4];
+		i32 q1[4];
+		UnpackRgb565(best.color0, q0);
+		UnpackRgb565(best.color1, q1);
+		for (u32 c = 0; c < 3; ++c)
+		{
+			e0[c] = static_cast<f32>(q0[c]);
+			e1[c] = static_cast<f32>(q1[c]);
+		}
+
+		if (!RefineEndpoints(pBlock, 3, best.indices, s_weights, e0, e1))
+			break;
+
+		ColorBlock refined;
+		QuantizeColorBlock(pBlock, e0, e1, refined);
+		if (refined.error >= best.error)
+			break;
+		best = refined;
+	}
+
+	u32 bits = 0;
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+		bits |= static_cast<u32>(best.indices[i]) << (2 * i);
+
+	pDst[0] = static_cast<u8>(best.color0);
+	pDst[1] = static_cast<u8>(best.color0 >> 8);
+	pDst[2] = static_cast<u8>(best.color1);
+	pDst[3] = static_cast<u8>(best.color1 >> 8);
+	for (u32 b = 0; b < 4; ++b)
+		pDst[4 + b] = static_cast<u8>(bits >> (8 * b));
+}
+
+// BC4 block of one channel, always in the eight value mode (value0 > value1)
+static void EncodeChannelBlock(const u8* pBlock, u32 channel, u8* pDst)
+{
+	i32 lo = 255;
+	i32 hi = 0;
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		lo = std::min<i32>(lo, pBlock[i * 4 + channel]);
+		hi = std::max<i32>(hi, pBlock[i * 4 + channel]);
+	}
+
+	i32 palette[8];
+	palette[0] = hi;
+	palette[1] = lo;
+	for (i32 k = 2; k < 8; ++k)
+		palette[k] = ((8 - k) * hi + (k - 1) * lo) / 7;
+
+	u64 bits = 0;
+	for (u32 i = 0; i < BLOCK_TEXELS && hi > lo; ++i)
+	{
+		const i32 v = pBlock[i * 4 + channel];
+		u64 best = 0;
+		for (u32 k = 1; k < 8; ++k)
+		{
+			if (std::abs(v - palette[k]) < std::abs(v - palette[best]))
+				best = k;
+		}
+		bits |= best << (3 * i);
+	}
+
+	pDst[0] = static_cast<u8>(hi);
+	pDst[1] = static_cast<u8>(lo);
+	for (u32 b = 0; b < 6; ++b)
+		pDst[2 + b] = static_cast<u8>(bits >> (8 * b));
+}
+
+void TextureCompressor::EncodeBC3(const u8* pBlock, u8* pDst)
+{
+	EncodeChannelBlock(pBlock, 3, pDst);
+	EncodeBC1(pBlock, pDst + 8);
+}
+
+void TextureCompressor::EncodeBC5(const u8* pBlock, u8* pDst)
+{
+	EncodeChannelBlock(pBlock, 0, pDst);
+	EncodeChannelBlock(pBlock, 1, pDst + 8);
+}
+
+// BC7 mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit each and 4 bit indices
+struct Bc7Block
+{
+	u32 endpoints[2][4] = {};
+	u32 pbits[2] = {};
+	u8 indices[BLOCK_TEXELS] = {};
+	u32 error = ~0u;
+};
+
+// Picks the p-bit that lands closest to the endpoint
+static void QuantizeBc7Endpoint(const f32 endpoint[4], u32 quantized[4], u32& pbit)
+{
+	f32 bestError = 0.0f;
+	for (u32 p = 0; p < 2; ++p)
+	{
+		u32 q[4];
+		f32 error = 0.0f;
+		for (u32 c = 0; c < 4; ++c)
+		{
+			const i32 v = static_cast<i32>(std::floor((endpoint[c] - p) * 0.5f + 0.5f));
+			q[c] = static_cast<u32>(std::min(std::max(v, 0), 127));
+			const f32 d = static_cast<f32>((q[c] << 1) | p) - endpoint[c];
+			error += d * d;
+		}
+
+		if (p == 0 || error < bestError)
+		{
+			bestError = error;
+			memcpy(quantized, q, sizeof(q));
+			pbit = p;
+		}
+	}
+}
+
+static void QuantizeBc7Block(const u8* pBlock, const f32 e0[4], const f32 e1[4], Bc7Block& block)
+{
+	QuantizeBc7Endpoint(e0, block.endpoints[0], block.pbits[0]);
+	QuantizeBc7Endpoint(e1, block.endpoints[1], block.pbits[1]);
+
+	i32 palette[16][4];
+	for (u32 w = 0; w < 16; ++w)
+	{
+		for (u32 c = 0; c < 4; ++c)
+		{
+			const i32 a = static_cast<i32>((block.endpoints[0][c] << 1) | block.pbits[0]);
+			const i32 b = static_cast<i32>((block.endpoints[1][c] << 1) | block.pbits[1]);
+			palette[w][c] = ((64 - s_bc7Weights[w]) * a + s_bc7Weights[w] * b + 32) >> 6;
+		}
+	}
+
+	block.error = SelectIndices(pBlock, 4, palette, 16, block.indices);
+}
+
+void TextureCompressor::EncodeBC7(const u8* pBlock, u8* pDst)
+{
+	static const f32 s_weights[16] =
+	{
+		0 / 64.0f, 4 / 64.0f, 9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+		34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 64 / 64.0f
+	};
+
+	f32 e0[4];
+	f32 e1[4];
+	FitEndpoints(pBlock, 4, e0, e1);
+
+	Bc7Block best;
+	QuantizeBc7Block(pBlock, e0, e1, best);
+
+	for (u32 iteration = 0; iteration < 2 && best.error > 0; ++iteration)
+	{
+		if (!RefineEndpoints(pBlock, 4, best.indices, s_weights, e0, e1))
+			break;
+
+		Bc7Block refined;
+		QuantizeBc7Block(pBlock, e0, e1, refined);
+		if (refined.error >= best.error)
+			break;
+		best = refined;
+	}
+
+	// The most significant bit of the first index is implied zero
+	if (best.indices[0] & 8)
+	{
+		for (u32 c = 0; c < 4; ++c)
+			std::swap(best.endpoints[0][c], best.endpoints[1][c]);
+		std::swap(best.pbits[0], best.pbits[1]);
+		for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+			best.indices[i] = static_cast<u8>(15 - best.indices[i]);
+	}
+
+	memset(pDst, 0, 16);
+	BlockWriter writer(pDst);
+	writer.Write(1 << 6, 7);
+	for (u32 c = 0; c < 4; ++c)
+	{
+		writer.Write(best.endpoints[0][c], 7);
+		writer.Write(best.endpoints[1][c], 7);
+	}
+	writer.Write(best.pbits[0], 1);
+	writer.Write(best.pbits[1], 1);
+	for (u32 i = 0; i < BLOCK_TEXELS; ++i)
+		writer.Write(best.indices[i], i == 0 ? 3 : 4);
+}
+
+bool TextureCompressor::IsNormalMap(const String& filename)
+{
+	String name = File::RemoveExt(filename);
+	const SizeType slash = name.find_last_of("/\\]");
+	if (slash != String::npos)
+		name = name.substr(slash + 1);
+
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+	auto endsWith = [&](const char* suffix)
+	{
+		const SizeType length = strlen(suffix);
+		return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+	};
+	return name.find("normal") != String::npos || endsWith("_n") || endsWith("_nrm");
+}
+
+TextureFormat TextureCompressor::ChooseFormat(const Texture& texture, bool isNormalMap)
+{
+	if (texture.format != TextureFormat::RGBA8_UNORM
+		|| texture.width % TEXTURE_COMPRESSOR_BLOCK_SIZE != 0 || texture.height % TEXTURE_COMPRESSOR_BLOCK_SIZE != 0)
+		return texture.format;
+
+	if (isNormalMap)
+		return TextureFormat::BC5_UNORM;
+
+	const SizeType texelCount = static_cast<SizeType>(texture.width) * static_cast<SizeType>(texture.height);
+	for (SizeType i = 0; i < texelCount; ++i)
+	{
+		if (texture.pixels[i * 4 + 3] != 255)
+			return TextureFormat::BC7_UNORM;
+	}
+	return TextureFormat::BC1_UNORM;
+}
+
+// Downsampled normals are shorter than unit length, rescale them so lighting does not darken with distance
+static void RenormalizeLevel(u8* pPixels, SizeType texelCount)
+{
+	for (SizeType i = 0; i < texelCount; ++i)
+	{
+		u8* pTexel = pPixels + i * 4;
+		f32 n[3];
+		f32 length = 0.0f;
+		for (u32 c = 0; c < 3; ++c)
+		{
+			n[c] = pTexel[c] / 127.5f - 1.0f;
+			length += n[c] * n[c];
+		}
+
+		length = std::sqrt(length);
+		if (length <= 0.0f)
+			continue;
+
+		for (u32 c = 0; c < 3; ++c)
+			pTexel[c] = static_cast<u8>(Saturate255((n[c] / length + 1.0f) * 127.5f + 0.5f));
+	}
+}
+
+u32 TextureCompressor::GenerateMips(Texture& texture, bool isLinear)
+{
+	BX_ASSERT(texture.format == TextureFormat::RGBA8_UNORM && texture.mipCount == 1, "Mips are generated from a single RGBA8 level!");
+
+	const u32 width = static_cast<u32>(texture.width);
+	const u32 height = static_cast<u32>(texture.height);
+
+	u32 mipCount = 1;
+	while ((width >> mipCount) > 0 || (height >> mipCount) > 0)
+		mipCount++;
+
+	List<u8> pixels(GetTextureSize(TextureFormat::RGBA8_UNORM, width, height, mipCount));
+	memcpy(pixels.data(), texture.pixels.data(), GetTextureLevelSize(TextureFormat::RGBA8_UNORM, width, height, 0));
+
+	SizeType offset = 0;
+	for (u32 level = 1; level < mipCount; ++level)
+	{
+		const u8* pSrc = pixels.data() + offset;
+		offset += GetTextureLevelSize(TextureFormat::RGBA8_UNORM, width, height, level - 1);
+		u8* pDst = pixels.data() + offset;
+
+		const i32 srcWidth = static_cast<i32>(GetTextureLevelExtent(width, level - 1));
+		const i32 srcHeight = static_cast<i32>(GetTextureLevelExtent(height, level - 1));
+		const i32 dstWidth = static_cast<i32>(GetTextureLevelExtent(width, level));
+		const i32 dstHeight = static_cast<i32>(GetTextureLevelExtent(height, level));
+
+		// Color is weighted by alpha so transparent texels do not bleed into their neighbours
+		const u8* pResult = isLinear
+			? stbir_resize_uint8_linear(pSrc, srcWidth, srcHeight, 0, pDst, dstWidth, dstHeight, 0, STBIR_4CHANNEL)
+			: stbir_resize_uint8_srgb(pSrc, srcWidth, srcHeight, 0, pDst, dstWidth, dstHeight, 0, STBIR_RGBA);
+		if (pResult == nullptr)
+		{
+			BX_LOGE("Failed to generate mip level {} ({}x{})!", level, dstWidth, dstHeight);
+			return static_cast<u32>(texture.mipCount);
+		}
+
+		if (isLinear)
+			RenormalizeLevel(pDst, static_cast<SizeType>(dstWidth) * static_cast<SizeType>(dstHeight));
+	}
+
+	texture.pixels.swap(pixels);
+	texture.mipCount = static_cast<i32>(mipCount);
+	return mipCount;
+}
+
+bool TextureCompressor::Encode(Texture& texture, TextureFormat format)
+{
+	BX_ASSERT(texture.format == TextureFormat::RGBA8_UNORM, "Only RGBA8 textures can be encoded!");
+
+	void (*encodeBlock)(const u8*, u8*) = nullptr;
+	switch (format)
+	{
+	case TextureFormat::BC1_UNORM: encodeBlock = &EncodeBC1; break;
+	case TextureFormat::BC3_UNORM: encodeBlock = &EncodeBC3; break;
+	case TextureFormat::BC5_UNORM: encodeBlock = &EncodeBC5; break;
+	case TextureFormat::BC7_UNORM: encodeBlock = &EncodeBC7; break;
+	default: return false;
+	}
+
+	const u32 width = static_cast<u32>(texture.width);
+	const u32 height = static_cast<u32>(texture.height);
+	const u32 mipCount = static_cast<u32>(texture.mipCount);
+	const u32 blockBytes = GetTextureFormatSize(format);
+
+	List<u8> blocks(GetTextureSize(format, width, height, mipCount));
+	u8* pDst = blocks.data();
+	const u8* pLevel = texture.pixels.data();
+
+	u8 block[BLOCK_TEXELS * 4];
+	for (u32 level = 0; level < mipCount; ++level)
+	{
+		const u32 levelWidth = GetTextureLevelExtent(width, level);
+		const u32 levelHeight = GetTextureLevelExtent(height, level);
+
+		for (u32 by = 0; by < levelHeight; by += TEXTURE_COMPRESSOR_BLOCK_SIZE)
+		{
+			for (u32 bx = 0; bx < levelWidth; bx += TEXTURE_COMPRESSOR_BLOCK_SIZE)
+			{
+				// Partial blocks at the edges of small levels repeat the last row and column
+				for (u32 y = 0; y < TEXTURE_COMPRESSOR_BLOCK_SIZE; ++y)
+				{
+					const u32 sy = std::min(by + y, levelHeight - 1);
+					for (u32 x = 0; x < TEXTURE_COMPRESSOR_BLOCK_SIZE; ++x)
+					{
+						const u32 sx = std::min(bx + x, levelWidth - 1);
+						memcpy(block + (y * TEXTURE_COMPRESSOR_BLOCK_SIZE + x) * 4, pLevel + (static_cast<SizeType>(sy) * levelWidth + sx) * 4, 4);
+					}
+				}
+
+				encodeBlock(block, pDst);
+				pDst += blockBytes;
+			}
+		}
+
+		pLevel += GetTextureLevelSize(TextureFormat::RGBA8_UNORM, width, height, level);
+	}
+
+	BX_ASSERT(pDst == blocks.data() + blocks.size(), "Texture blocks do not match the level sizes!");
+	texture.pixels.swap(blocks);
+	texture.format = format;
+	return true;
+}
+
+void TextureCompressor::Compress(Texture& texture, const String& filename)
+{
+	const bool isNormalMap = IsNormalMap(filename);
+	const SizeType before = texture.pixels.size();
+
+	GenerateMips(texture, isNormalMap);
+
+	const TextureFormat format = ChooseFormat(texture, isNormalMap);
+	if (format != texture.format)
+		Encode(texture, format);
+
+	BX_LOGI("Compressed texture {} ({}x{}, {} levels): {} -> {} bytes",
+		filename, texture.width, texture.height, texture.mipCount, before, texture.pixels.size());
+}
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include <bx/engine/modules/script.hpp>
 
 #include <bx/framework/gameobject.hpp>
+#include <bx/framework/scene_streamer.hpp>
 
 #include <bx/runtime/runtime.hpp>
 
@@ -30,6 +31,7 @@
 
 static bool playing = false;
 static bool paused = false;
+static SceneSnapshot play_snapshot;
 static float ui_scale = 1.0f;
 
 static bool show_gameobjects = true;
@@ -185,6 +187,18 @@ void Toolbar::Present()
 					const String& scene = Data::GetString("Current Scene", "", DataTarget::EDITOR);
 					Scene::Save(scene);
 				}
+				if (ImGui::MenuItem("Export Binary"))
+				{
+					const String& scene = Data::GetString("Current Scene", "", DataTarget::EDITOR);
+					Scene::Save(scene);
+					Scene::Convert(scene, Scene::GetBinaryFilename(scene));
+				}
+				if (ImGui::MenuItem("Export Cells"))
+				{
+					const String& scene = Data::GetString("Current Scene", "", DataTarget::EDITOR);
+					Scene::Save(scene);
+					SceneStreamer::Partition(scene, Data::GetFloat("Scene Cell Size", SCENE_STREAMING_CELL_SIZE, DataTarget::GAME));
+				}
 				ImGui::Separator();
 				if (ImGui::MenuItem("Exit"))
 				{
@@ -336,17 +350,21 @@ void Toolbar::Present()
 			{
 				paused = false;
 
-				const String& scene = Data::GetString("Current Scene", "", DataTarget::EDITOR);
-
+				// The scene comes back from memory instead of the file. The runtime is still reloaded
+				// so the script VM starts over, without the module state and objects of the play session.
 				Runtime::Reload();
-				Scene::Load(scene);
+				if (!play_snapshot.Restore(Scene::GetCurrent()))
+				{
+					const String& scene = Data::GetString("Current Scene", "", DataTarget::EDITOR);
+					Scene::Load(scene);
+				}
+				play_snapshot.Clear();
 
 				Window::SetCursorMode(CursorMode::NORMAL);
 			}
 			else
 			{
-				const String& scene = Data::GetString("Current Scene", "", DataTarget::EDITOR);
-				Scene::Save(scene);
+				play_snapshot.Capture(Scene::GetCurrent());
 
 				Window::SetCursorMode(CursorMode::DISABLED);
 			}
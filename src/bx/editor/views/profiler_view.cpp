@@ -4,6 +4,7 @@
 #include <bx/engine/core/profiler.hpp>
 #include <bx/engine/core/time.hpp>
 #include <bx/engine/containers/list.hpp>
+#include <bx/engine/modules/script.hpp>
 
 #include <imgui.h>
 #include <implot.h>
@@ -53,5 +54,59 @@ void ProfilerView::Present(bool& show)
     for (auto& itr : data)
         ImGui::LabelText(itr.first.c_str(), "%f ms", itr.second.avg);
 
+    for (auto& itr : Profiler::GetCounters())
+        ImGui::LabelText(itr.first.c_str(), "%.2f", itr.second);
+
+    if (ImGui::CollapsingHeader("Script Calls"))
+    {
+        static const char* s_modeNames[] = { "Off", "Sampled", "Full" };
+        int mode = (int)Script::GetProfileMode();
+        if (ImGui::Combo("Mode", &mode, s_modeNames, IM_ARRAYSIZE(s_modeNames)))
+            Script::SetProfileMode((ScriptProfileMode)mode);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+            Script::ResetProfile();
+
+        // Most expensive first
+        List<const std::pair<const String, ScriptProfileData>*> entries;
+        for (const auto& itr : Script::GetProfile())
+            entries.emplace_back(&itr);
+        std::sort(entries.begin(), entries.end(),
+            [](const std::pair<const String, ScriptProfileData>* a, const std::pair<const String, ScriptProfileData>* b)
+            {
+                return a->second.exclusive > b->second.exclusive;
+            });
+
+        if (ImGui::BeginTable("ScriptProfile", 6, ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+        {
+            ImGui::TableSetupColumn("Call");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Inclusive (ms)");
+            ImGui::TableSetupColumn("Exclusive (ms)");
+            ImGui::TableSetupColumn("Allocated (KB)");
+            ImGui::TableSetupColumn("GCs");
+            ImGui::TableHeadersRow();
+
+            for (const auto* pEntry : entries)
+            {
+                const auto& profile = pEntry->second;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(pEntry->first.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)profile.calls);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", profile.inclusive);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", profile.exclusive);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", profile.allocated / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", (unsigned long long)profile.collections);
+            }
+            ImGui::EndTable();
+        }
+    }
+
     ImGui::End();
 }
\ No newline at end of file
@@ -354,7 +354,7 @@ static void Render(const ImVec2& size)
                 cmd.model.entityId = entity.GetId();
                 cmd.vbuffers = meshData.GetVertexBuffers();
                 cmd.ibuffer = meshData.GetIndexBuffer();
-                cmd.numIndices = static_cast<u32>(meshData.GetTriangles().size());
+                cmd.numIndices = meshData.GetIndexCount();
 
                 g_drawCmds.emplace_back(cmd);
             }
@@ -0,0 +1,308 @@
+#include "bx/engine/core/compression.hpp"
+
+#include "bx/engine/containers/list.hpp"
+
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+constexpr u32 COMPRESSION_MIN_MATCH = 4;
+constexpr u32 COMPRESSION_MAX_OFFSET = 0xFFFF;
+constexpr u32 COMPRESSION_HASH_BITS = 16;
+// Small inputs get a smaller table, clearing the full one would cost more than compressing
+constexpr u32 COMPRESSION_SMALL_HASH_BITS = 12;
+constexpr SizeType COMPRESSION_SMALL_INPUT = 16 * 1024;
+// Every miss in a row beyond this many widens the search step by one byte
+constexpr u32 COMPRESSION_SKIP_TRIGGER = 6;
+// Copies run in whole 16 byte steps when the output has at least this much room left
+constexpr SizeType COMPRESSION_WILD_COPY = 16;
+
+// The format requires the last literals to cover the final bytes of the block
+constexpr SizeType COMPRESSION_LAST_LITERALS = 5;
+constexpr SizeType COMPRESSION_MATCH_SAFE_END = 12;
+
+static inline u32 Read32(const u8* p)
+{
+	u32 value;
+	memcpy(&value, p, sizeof(u32));
+	return value;
+}
+
+static inline u32 HashSequence(u32 sequence, u32 hashBits)
+{
+	return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+static inline u32 TrailingZeros(u64 value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<u32>(index);
+#else
+	return static_cast<u32>(__builtin_ctzll(value));
+#endif
+}
+
+// Compares 8 bytes at a time, the first differing byte is found from the lowest set bit (little endian)
+static inline SizeType CountMatch(const u8* pA, const u8* pB, const u8* pALimit)
+{
+	const u8* pStart = pA;
+	while (pA + sizeof(u64) <= pALimit)
+	{
+		u64 a, b;
+		memcpy(&a, pA, sizeof(u64));
+		memcpy(&b, pB, sizeof(u64));
+
+		const u64 diff = a ^ b;
+		if (diff != 0)
+			return static_cast<SizeType>(pA - pStart) + TrailingZeros(diff) / 8;
+
+		pA += sizeof(u64);
+		pB += sizeof(u64);
+	}
+
+	while (pA < pALimit && *pA == *pB)
+	{
+		pA++;
+		pB++;
+	}
+	return static_cast<SizeType>(pA - pStart);
+}
+
+// Copies in 16 byte steps, writing up to 15 bytes past the end. Only valid if the
+// regions are at least 16 bytes apart or the source comes after the destination.
+static inline void WildCopy(u8* pDst, const u8* pSrc, const u8* pDstEnd)
+{
+	do
+	{
+		memcpy(pDst, pSrc, COMPRESSION_WILD_COPY);
+		pDst += COMPRESSION_WILD_COPY;
+		pSrc += COMPRESSION_WILD_COPY;
+	} while (pDst < pDstEnd);
+}
+
+// Lengths past the 4 bit token field continue in bytes of 255 terminated by a smaller byte
+static inline bool WriteLength(u8*& pDst, const u8* pEnd, SizeType length)
+{
+	while (length >= 255)
+	{
+		if (pDst >= pEnd)
+			return false;
+		*pDst++ = 255;
+		length -= 255;
+	}
+
+	if (pDst >= pEnd)
+		return false;
+	*pDst++ = static_cast<u8>(length);
+	return true;
+}
+
+static inline bool ReadLength(const u8*& pSrc, const u8* pEnd, SizeType& length)
+{
+	u8 byte;
+	do
+	{
+		if (pSrc >= pEnd)
+			return false;
+		byte = *pSrc++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+static bool WriteSequence(u8*& pDst, const u8* pDstEnd, const u8* pLiterals, SizeType literalCount, u32 offset, SizeType matchLength)
+{
+	u8* pToken = pDst++;
+	if (pToken >= pDstEnd)
+		return false;
+
+	u8 token = 0;
+	if (literalCount >= 15)
+	{
+		token = 15 << 4;
+		if (!WriteLength(pDst, pDstEnd, literalCount - 15))
+			return false;
+	}
+	else
+	{
+		token = static_cast<u8>(literalCount << 4);
+	}
+
+	if (pDst + literalCount > pDstEnd)
+		return false;
+	if (literalCount > 0)
+		memcpy(pDst, pLiterals, literalCount);
+	pDst += literalCount;
+
+	// The last sequence only carries literals
+	if (matchLength > 0)
+	{
+		if (pDst + 2 > pDstEnd)
+			return false;
+		*pDst++ = static_cast<u8>(offset & 0xFF);
+		*pDst++ = static_cast<u8>(offset >> 8);
+
+		const SizeType length = matchLength - COMPRESSION_MIN_MATCH;
+		if (length >= 15)
+		{
+			token |= 15;
+			if (!WriteLength(pDst, pDstEnd, length - 15))
+				return false;
+		}
+		else
+		{
+			token |= static_cast<u8>(length);
+		}
+	}
+
+	*pToken = token;
+	return true;
+}
+
+SizeType Compression::GetMaxCompressedSize(SizeType size)
+{
+	return size + size / 255 + 16;
+}
+
+SizeType Compression::Compress(const u8* pSrc, SizeType srcSize, u8* pDst, SizeType dstCapacity)
+{
+	u8* pOut = pDst;
+	const u8* pOutEnd = pDst + dstCapacity;
+
+	const u8* pAnchor = pSrc;
+	const u8* pEnd = pSrc + srcSize;
+
+	if (srcSize > COMPRESSION_MATCH_SAFE_END)
+	{
+		// Positions of the last occurrence of each hashed 4 byte sequence
+		const u32 hashBits = srcSize < COMPRESSION_SMALL_INPUT ? COMPRESSION_SMALL_HASH_BITS : COMPRESSION_HASH_BITS;
+		List<u32> table(static_cast<SizeType>(1) << hashBits, 0);
+
+		const u8* pMatchLimit = pEnd - COMPRESSION_LAST_LITERALS;
+		const u8* pSearchEnd = pEnd - COMPRESSION_MATCH_SAFE_END;
+
+		u32 misses = 0;
+		const u8* pCurrent = pSrc + 1;
+		while (pCurrent < pSearchEnd)
+		{
+			const u32 sequence = Read32(pCurrent);
+			const u32 hash = HashSequence(sequence, hashBits);
+			const u8* pCandidate = pSrc + table[hash];
+			table[hash] = static_cast<u32>(pCurrent - pSrc);
+
+			if (pCandidate >= pCurrent
+				|| static_cast<SizeType>(pCurrent - pCandidate) > COMPRESSION_MAX_OFFSET
+				|| Read32(pCandidate) != sequence)
+			{
+				// Incompressible stretches are skipped over faster and faster
+				pCurrent += 1 + (misses++ >> COMPRESSION_SKIP_TRIGGER);
+				continue;
+			}
+			misses = 0;
+
+			// Extend backwards over pending literals, then forwards up to the limit
+			while (pCurrent > pAnchor && pCandidate > pSrc && pCurrent[-1] == pCandidate[-1])
+			{
+				pCurrent--;
+				pCandidate--;
+			}
+
+			const u8* pMatchEnd = pCurrent + COMPRESSION_MIN_MATCH;
+			pMatchEnd += CountMatch(pMatchEnd, pCandidate + COMPRESSION_MIN_MATCH, pMatchLimit);
+
+			if (!WriteSequence(pOut, pOutEnd, pAnchor, pCurrent - pAnchor,
+				static_cast<u32>(pCurrent - pCandidate), pMatchEnd - pCurrent))
+				return 0;
+
+			pCurrent = pMatchEnd;
+			pAnchor = pCurrent;
+
+			if (pCurrent < pSearchEnd)
+				table[HashSequence(Read32(pCurrent - 2), hashBits)] = static_cast<u32>(pCurrent - 2 - pSrc);
+		}
+	}
+
+	if (!WriteSequence(pOut, pOutEnd, pAnchor, pEnd - pAnchor, 0, 0))
+		return 0;
+
+	return static_cast<SizeType>(pOut - pDst);
+}
+
+bool Compression::Decompress(const u8* pSrc, SizeType srcSize, u8* pDst, SizeType dstSize)
+{
+	const u8* pIn = pSrc;
+	const u8* pInEnd = pSrc + srcSize;
+	u8* pOut = pDst;
+	u8* pOutEnd = pDst + dstSize;
+
+	while (pIn < pInEnd)
+	{
+		const u8 token = *pIn++;
+
+		SizeType literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(pIn, pInEnd, literalCount))
+			return false;
+
+		if (literalCount > static_cast<SizeType>(pInEnd - pIn) || literalCount > static_cast<SizeType>(pOutEnd - pOut))
+			return false;
+
+		// Room to spare on both sides allows copying whole steps past the literals
+		if (literalCount + COMPRESSION_WILD_COPY <= static_cast<SizeType>(pOutEnd - pOut)
+			&& literalCount + COMPRESSION_WILD_COPY <= static_cast<SizeType>(pInEnd - pIn))
+			WildCopy(pOut, pIn, pOut + literalCount);
+		else if (literalCount > 0)
+			memcpy(pOut, pIn, literalCount);
+		pIn += literalCount;
+		pOut += literalCount;
+
+		// The block ends after the literals of the last sequence
+		if (pIn == pInEnd)
+			break;
+
+		if (pInEnd - pIn < 2)
+			return false;
+
+		const SizeType offset = pIn[0] | (static_cast<SizeType>(pIn[1]) << 8);
+		pIn += 2;
+
+		if (offset == 0 || offset > static_cast<SizeType>(pOut - pDst))
+			return false;
+
+		SizeType matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(pIn, pInEnd, matchLength))
+			return false;
+		matchLength += COMPRESSION_MIN_MATCH;
+
+		if (matchLength > static_cast<SizeType>(pOutEnd - pOut))
+			return false;
+
+		// Matches may overlap their own output (e.g. runs), steps are only as wide as the offset allows
+		const u8* pMatch = pOut - offset;
+		u8* pMatchEnd = pOut + matchLength;
+		if (offset == 1)
+		{
+			memset(pOut, *pMatch, matchLength);
+		}
+		else if (offset >= COMPRESSION_WILD_COPY && static_cast<SizeType>(pOutEnd - pMatchEnd) >= COMPRESSION_WILD_COPY)
+		{
+			WildCopy(pOut, pMatch, pMatchEnd);
+		}
+		else if (offset >= sizeof(u64) && static_cast<SizeType>(pOutEnd - pMatchEnd) >= sizeof(u64))
+		{
+			for (u8* pCopy = pOut; pCopy < pMatchEnd; pCopy += sizeof(u64), pMatch += sizeof(u64))
+				memcpy(pCopy, pMatch, sizeof(u64));
+		}
+		else
+		{
+			for (SizeType i = 0; i < matchLength; ++i)
+				pOut[i] = pMatch[i];
+		}
+		pOut = pMatchEnd;
+	}
+
+	return pOut == pOutEnd;
+}
\ No newline at end of file
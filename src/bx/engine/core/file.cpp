@@ -1,5 +1,6 @@
 #include "bx/engine/core/file.hpp"
 
+#include "bx/engine/core/pak.hpp"
 #include "bx/engine/core/macros.hpp"
 #include "bx/engine/core/guard.hpp"
 #include "bx/engine/containers/hash_map.hpp"
@@ -24,13 +25,126 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <pwd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 
 HashMap<String, String> s_wildcards;
+HashMap<String, PakArchive> s_mounts;
+
+// Everything below a root, listed once
+struct DirectoryIndex
+{
+	bool isStale = false;
+	// Directory path, in the form ListFiles was given it, to its entries
+	HashMap<String, List<FileHandle>> directories;
+	// All files depth first in listing order, which is the order Find and FindEach visit them in
+	List<FileHandle> files;
+	// Filename to the first file with that name
+	HashMap<String, SizeType> names;
+};
+
+static HashMap<String, DirectoryIndex> s_indexes;
+static std::mutex s_indexMutex;
+
+static bool ListEntries(const String& root, List<FileHandle>& files);
+
+// Marks the indexes stale once the enclosing file operation is done
+struct IndexInvalidator
+{
+	const String& path;
+	~IndexInvalidator() { File::Invalidate(path); }
+};
+
+static bool IsBelow(const String& path, const String& root)
+{
+	return path.size() >= root.size() && path.compare(0, root.size(), root) == 0
+		&& (path.size() == root.size() || path[root.size()] == '/');
+}
+
+static void IndexDirectory(DirectoryIndex& index, const String& directory)
+{
+	List<FileHandle> entries;
+	if (!ListEntries(directory, entries))
+		return;
+
+	for (const auto& entry : entries)
+	{
+		if (entry.isDirectory)
+		{
+			IndexDirectory(index, entry.filepath);
+			continue;
+		}
+
+		index.names.emplace(entry.filename, index.files.size());
+		index.files.emplace_back(entry);
+	}
+
+	index.directories[directory] = std::move(entries);
+}
+
+static void RebuildIndex(const String& root, DirectoryIndex& index)
+{
+	index = DirectoryIndex();
+	IndexDirectory(index, root);
+}
+
+// Returns the index containing the path, rebuilt if stale. Expects s_indexMutex to be held.
+static DirectoryIndex* FindIndex(const String& path, String& root)
+{
+	for (auto& it : s_indexes)
+	{
+		if (!IsBelow(path, it.first))
+			continue;
+
+		if (it.second.isStale)
+			RebuildIndex(it.first, it.second);
+
+		root = it.first;
+		return &it.second;
+	}
+
+	return nullptr;
+}
+
+// Same as FindIndex, but indexes the path itself if nothing covers it yet
+static DirectoryIndex& FindOrBuildIndex(const String& path, String& root)
+{
+	if (auto* pIndex = FindIndex(path, root))
+		return *pIndex;
+
+	root = path;
+	auto& index = s_indexes[path];
+	RebuildIndex(path, index);
+	return index;
+}
+
+// Returns the pak serving the filename, if any, along with the name inside the pak
+static const PakArchive* FindMount(const String& filename, String& name)
+{
+	for (const auto& mount : s_mounts)
+	{
+		const auto& wildcard = mount.first;
+		if (filename.compare(0, wildcard.size(), wildcard) != 0)
+			continue;
+
+		SizeType start = wildcard.size();
+		while (start < filename.size() && filename[start] == '/')
+			start++;
+
+		name = filename.substr(start);
+		return &mount.second;
+	}
+
+	return nullptr;
+}
 
 static List<String> StringSplit(const String& source, const char* delimiter, bool keep_empty)
 {
@@ -106,56 +220,37 @@ void File::Initialize()
 
 #ifdef BX_EDITOR_BUILD
 	AddWildcard("[editor]", BX_PROJECT_PATH"/editor");
+#else
+	// Shipped builds read their assets from a single archive when one was built
+	if (Exists(BX_PROJECT_PATH"/game/assets.pak"))
+		Mount("[assets]", BX_PROJECT_PATH"/game/assets.pak");
 #endif
 }
 
 List<char> File::ReadBinaryFile(const String& filename)
 {
-	const auto path = GetPath(filename);
-	std::ifstream file(path, std::ios::binary | std::ios::ate);
-	if (!file.is_open())
-	{
-		BX_LOGE("File {} with full path {} was not found!", filename, path);
+	// Copies once, straight out of the mapping
+	MappedFile file(filename);
+	if (!file.IsOpen())
 		return List<char>();
-	}
-
-	const std::streamsize size = file.tellg();
-	file.seekg(0, std::ios::beg);
-	
-	List<char> buffer(size);
-	if (file.read(buffer.data(), size))
-		return  buffer;
 
-	BX_ASSERT(false, "");
-	return List<char>();
+	const auto* pData = reinterpret_cast<const char*>(file.GetData());
+	return List<char>(pData, pData + file.GetSize());
 }
 
 String File::ReadTextFile(const String& filename)
 {
-	const auto path = GetPath(filename);
-
-	//std::ifstream file(path);
-	//return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-
-	std::ifstream file(path);
-	if (!file.is_open())
-	{
-		BX_LOGE("File {} with full path {} was not found!", filename, path);
+	MappedFile file(filename);
+	if (!file.IsOpen())
 		return String();
-	}
-
-	file.seekg(0, std::ios::end);
-	const size_t size = file.tellg();
-
-	String buffer(size, '\0');
-	file.seekg(0);
-	file.read(&buffer[0], size);
 
-	return buffer;
+	return String(file.GetText(), file.GetSize());
 }
 
 bool File::WriteTextFile(const String& filename, const String& text)
 {
+	const IndexInvalidator invalidate{ filename };
+
 	auto fullpath = GetPath(filename);
 	std::ofstream ofs;
 	ofs.open(fullpath);
@@ -169,6 +264,31 @@ bool File::WriteTextFile(const String& filename, const String& text)
 	return false;
 }
 
+bool File::Mount(const String& wildcard, const String& pakFilename)
+{
+	PakArchive pak;
+	if (!pak.Open(pakFilename))
+	{
+		BX_LOGE("Failed to mount {} at {}!", pakFilename, wildcard);
+		return false;
+	}
+
+	s_mounts[wildcard] = std::move(pak);
+	BX_LOGI("Mounted {} at {}", pakFilename, wildcard);
+	return true;
+}
+
+void File::Unmount(const String& wildcard)
+{
+	s_mounts.erase(wildcard);
+}
+
+bool File::IsMounted(const String& filename)
+{
+	String name;
+	return FindMount(filename, name) != nullptr;
+}
+
 void File::AddWildcard(const String& wildcard, const String& value)
 {
 	if (!Exists(value))
@@ -201,6 +321,21 @@ static String StringReplace(
 
 String File::GetPath(const String& filename)
 {
+	// Wildcards lead the path, which makes resolving them a single lookup
+	if (!filename.empty() && filename[0] == '[')
+	{
+		const SizeType close = filename.find(']');
+		if (close != String::npos)
+		{
+			auto it = s_wildcards.find(filename.substr(0, close + 1));
+			if (it != s_wildcards.end() && filename.find('[', close) == String::npos)
+				return it->second + filename.substr(close + 1);
+		}
+	}
+
+	if (filename.find('[') == String::npos)
+		return filename;
+
 	String filepath = filename;
 
 	for (const auto& p : s_wildcards)
@@ -227,6 +362,9 @@ bool File::Move(const String& oldPath, const String& newPath)
 	String oldFullPath = File::GetPath(oldPath);
 	String newFullPath = File::GetPath(newPath);
 
+	const IndexInvalidator invalidateOld{ oldPath };
+	const IndexInvalidator invalidateNew{ newPath };
+
 #if defined(BX_PLATFORM_PC)
 	LPCSTR oldFileName = oldFullPath.c_str();
 	LPCSTR newFileName = newFullPath.c_str();
@@ -254,6 +392,8 @@ bool File::Move(const String& oldPath, const String& newPath)
 
 bool File::Delete(const String& filename)
 {
+	const IndexInvalidator invalidate{ filename };
+
 #if defined(BX_PLATFORM_PC)
 	const String fullpath = GetPath(filename);
 	
@@ -296,6 +436,10 @@ bool File::Delete(const String& filename)
 
 bool File::Exists(const String& path)
 {
+	String name;
+	if (const auto* pPak = FindMount(path, name))
+		return name.empty() || pPak->Find(name) != nullptr || pPak->IsDirectory(name);
+
 	const auto filepath = GetPath(path);
 	struct stat info;
 	return (stat(filepath.c_str(), &info) == 0);
@@ -303,6 +447,8 @@ bool File::Exists(const String& path)
 
 bool File::CreateDirectory(const String& path)
 {
+	const IndexInvalidator invalidate{ path };
+
 #if defined(BX_PLATFORM_PC)
 	BOOL ret = WinCreateDirectory(path.c_str(), NULL);
 	switch (GetLastError())
@@ -332,24 +478,78 @@ bool File::CreateDirectory(const String& path)
 
 u64 File::LastWrite(const String& filename)
 {
-#if (defined(BX_PLATFORM_PC) || defined(BX_PLATFORM_LINUX)) \
-&& (defined(BX_BUILD_DEBUG) || defined(BX_BUILD_PROFILE))
+	// Pak contents never change while mounted
+	if (IsMounted(filename))
+		return 0;
+
 	const auto filepath = GetPath(filename);
 	struct stat info;
-	if (stat(filename.c_str(), &info) == 0)
+	if (stat(filepath.c_str(), &info) == 0)
 	{
-		return info.st_mtime;
-	}
+#if defined(BX_PLATFORM_LINUX)
+		// Nanoseconds, whole seconds miss writes in quick succession
+		return static_cast<u64>(info.st_mtim.tv_sec) * 1000000000ull + static_cast<u64>(info.st_mtim.tv_nsec);
+#else
+		return static_cast<u64>(info.st_mtime);
 #endif
+	}
 
 	return 0;
 }
 
 bool File::ListFiles(const String& root, List<FileHandle>& files)
 {
+	{
+		std::lock_guard<std::mutex> lock(s_indexMutex);
+
+		String indexRoot;
+		if (auto* pIndex = FindIndex(root, indexRoot))
+		{
+			auto it = pIndex->directories.find(root);
+			if (it == pIndex->directories.end())
+				return false;
+
+			files.insert(files.end(), it->second.begin(), it->second.end());
+			return true;
+		}
+	}
+
+	return ListEntries(root, files);
+}
+
+static bool ListEntries(const String& root, List<FileHandle>& files)
+{
+	String directory;
+	if (const auto* pPak = FindMount(root, directory))
+	{
+		if (!directory.empty() && !pPak->IsDirectory(directory))
+			return false;
+
+		const String prefix = directory.empty() ? directory : directory + "/";
+		for (SizeType i = 0; i < pPak->GetEntryCount(); ++i)
+		{
+			const String name = pPak->GetName(pPak->GetEntry(i));
+			if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+				continue;
+
+			// Direct children only, nested entries show up as their top directory
+			FileHandle fh;
+			const SizeType split = name.find('/', prefix.size());
+			fh.filename = name.substr(prefix.size(), split == String::npos ? String::npos : split - prefix.size());
+			fh.filepath = root + "/" + fh.filename;
+			fh.isDirectory = split != String::npos;
+
+			const bool isListed = std::find_if(files.begin(), files.end(),
+				[&](const FileHandle& other) { return other.filepath == fh.filepath; }) != files.end();
+			if (!isListed)
+				files.emplace_back(fh);
+		}
+		return true;
+	}
+
 #if defined(BX_PLATFORM_PC)
 
-	String rootPath = GetPath(root);
+	String rootPath = File::GetPath(root);
 
 	if (rootPath.size() > (MAX_PATH - 3))
 		return false;
@@ -392,7 +592,7 @@ bool File::ListFiles(const String& root, List<FileHandle>& files)
 
 #elif defined(BX_PLATFORM_LINUX)
 
-	String rootPath = GetPath(root);
+	String rootPath = File::GetPath(root);
 
 	DIR* dir = opendir(rootPath.c_str());
 	if (dir == NULL)
@@ -433,26 +633,27 @@ bool File::ListFiles(const String& root, List<FileHandle>& files)
 
 bool File::Find(const String& root, const String& filename, String& filepath)
 {
-	List<FileHandle> files;
-	if (!ListFiles(root, files))
-		return false;
+	std::lock_guard<std::mutex> lock(s_indexMutex);
 
-	for (const auto& file : files)
+	String indexRoot;
+	const auto& index = FindOrBuildIndex(root, indexRoot);
+	if (indexRoot == root)
 	{
-		if (file.isDirectory)
-		{
-			if (File::Find(file.filepath, filename, filepath))
-			{
-				return true;
-			}
-		}
-		else
+		auto it = index.names.find(filename);
+		if (it == index.names.end())
+			return false;
+
+		filepath = index.files[it->second].filepath;
+		return true;
+	}
+
+	// Only part of the index is searched
+	for (const auto& file : index.files)
+	{
+		if (file.filename == filename && IsBelow(file.filepath, root))
 		{
-			if (file.filename == filename)
-			{
-				filepath = file.filepath;
-				return true;
-			}
+			filepath = file.filepath;
+			return true;
 		}
 	}
 
@@ -461,24 +662,330 @@ bool File::Find(const String& root, const String& filename, String& filepath)
 
 void File::FindEach(const String& root, const String& ext, const FindEachCallback& callback)
 {
-	List<FileHandle> files;
-	if (!ListFiles(root, files))
+	List<FileHandle> matches;
+	{
+		std::lock_guard<std::mutex> lock(s_indexMutex);
+
+		String indexRoot;
+		const auto& index = FindOrBuildIndex(root, indexRoot);
+		for (const auto& file : index.files)
+		{
+			const SizeType split = file.filename.find_last_of(".");
+			if (split == String::npos || file.filename.compare(split, String::npos, ext) != 0)
+				continue;
+
+			if (indexRoot == root || IsBelow(file.filepath, root))
+				matches.emplace_back(file);
+		}
+	}
+
+	// Callbacks run unlocked, they are free to use the file system again
+	for (const auto& file : matches)
+		callback(file.filepath, file.filename.substr(0, file.filename.find_last_of(".")));
+}
+
+void File::BuildIndex(const String& root)
+{
+	std::lock_guard<std::mutex> lock(s_indexMutex);
+	RebuildIndex(root, s_indexes[root]);
+}
+
+void File::Invalidate(const String& path)
+{
+	std::lock_guard<std::mutex> lock(s_indexMutex);
+	if (s_indexes.empty())
 		return;
 
-	for (const auto& file : files)
+	const String filepath = GetPath(path);
+	for (auto& it : s_indexes)
 	{
-		if (file.isDirectory)
+		// Anything changing right below the root, the root itself included, can change its listing
+		const String rootPath = GetPath(it.first);
+		if (IsBelow(filepath, rootPath))
+			it.second.isStale = true;
+	}
+}
+
+MappedFile::MappedFile(const String& filename, bool isText)
+{
+	Open(filename, isText);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+
+		m_pData = other.m_pData;
+		m_size = other.m_size;
+		m_isMapped = other.m_isMapped;
+		m_buffer = std::move(other.m_buffer);
+		other.m_pData = nullptr;
+		other.m_size = 0;
+		other.m_isMapped = false;
+
+#if defined(BX_PLATFORM_PC)
+		m_file = other.m_file;
+		m_mapping = other.m_mapping;
+		other.m_file = nullptr;
+		other.m_mapping = nullptr;
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const String& filename, bool isText)
+{
+	Close();
+
+	String name;
+	if (const auto* pPak = FindMount(filename, name))
+	{
+		const auto* pEntry = pPak->Find(name);
+		if (pEntry == nullptr)
 		{
-			FindEach(file.filepath, ext, callback);
-			continue;
+			BX_LOGE("File {} was not found in the mounted pak!", filename);
+			return false;
 		}
-		
-		std::size_t split = file.filename.find_last_of(".");
-		const auto& fileName = file.filename.substr(0, split);
-		const auto& fileExt = file.filename.substr(split);
-		if (fileExt == ext)
+
+		if (pEntry->uncompressedSize == 0)
+			return OpenEmpty();
+
+		const u8* pData = pPak->Read(*pEntry, m_buffer);
+		if (pData == nullptr)
+			return false;
+
+		m_size = static_cast<SizeType>(pEntry->uncompressedSize);
+		if (isText)
 		{
-			callback(file.filepath, fileName);
+			// Stored entries point into the pak, the terminator needs a copy
+			if (pData != m_buffer.data())
+				m_buffer.assign(pData, pData + m_size);
+
+			m_buffer.emplace_back(0);
+			pData = m_buffer.data();
 		}
+
+		m_pData = pData;
+		return true;
+	}
+
+	const auto path = File::GetPath(filename);
+
+#if defined(BX_PLATFORM_PC)
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		BX_LOGE("File {} with full path {} was not found!", filename, path);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// Nothing to map
+	if (size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return OpenEmpty();
+	}
+
+	SYSTEM_INFO system;
+	GetSystemInfo(&system);
+	if (isText && size.QuadPart % system.dwPageSize == 0)
+	{
+		CloseHandle(file);
+		return OpenBuffered(filename, path, isText);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		BX_LOGE("Failed to map file {}: {}", filename, GetLastError());
+		CloseHandle(file);
+		return false;
+	}
+
+	void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (pView == NULL)
+	{
+		BX_LOGE("Failed to map file {}: {}", filename, GetLastError());
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_pData = static_cast<const u8*>(pView);
+	m_size = static_cast<SizeType>(size.QuadPart);
+	m_isMapped = true;
+	return true;
+
+#elif defined(BX_PLATFORM_LINUX)
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		BX_LOGE("File {} with full path {} was not found!", filename, path);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	// Nothing to map
+	if (info.st_size == 0)
+	{
+		close(fd);
+		return OpenEmpty();
+	}
+
+	// The rest of the last page reads as zeros, which terminates text unless the page is full
+	if (isText && info.st_size % sysconf(_SC_PAGESIZE) == 0)
+	{
+		close(fd);
+		return OpenBuffered(filename, path, isText);
+	}
+
+	void* pView = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+
+	if (pView == MAP_FAILED)
+	{
+		BX_LOGE("Failed to map file {}: {}", filename, strerror(errno));
+		return false;
+	}
+
+	m_pData = static_cast<const u8*>(pView);
+	m_size = static_cast<SizeType>(info.st_size);
+	m_isMapped = true;
+	return true;
+
+#else
+	return OpenBuffered(filename, path, isText);
+
+#endif
+}
+
+bool MappedFile::OpenBuffered(const String& filename, const String& path, bool isText)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		BX_LOGE("File {} with full path {} was not found!", filename, path);
+		return false;
+	}
+
+	const std::streamsize size = file.tellg();
+	if (size < 0)
+		return false;
+
+	if (size == 0)
+		return OpenEmpty();
+
+	file.seekg(0, std::ios::beg);
+	m_buffer.resize(static_cast<SizeType>(size));
+	if (!file.read(reinterpret_cast<char*>(m_buffer.data()), size))
+	{
+		m_buffer.clear();
+		return false;
+	}
+
+	if (isText)
+		m_buffer.emplace_back(0);
+
+	m_pData = m_buffer.data();
+	m_size = static_cast<SizeType>(size);
+	return true;
+}
+
+bool MappedFile::OpenEmpty()
+{
+	// Also the null terminator of an empty text file
+	static const u8 s_empty[1] = { 0 };
+
+	m_pData = s_empty;
+	m_size = 0;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_pData == nullptr)
+		return;
+
+	if (m_isMapped)
+	{
+#if defined(BX_PLATFORM_PC)
+		UnmapViewOfFile(m_pData);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = nullptr;
+#elif defined(BX_PLATFORM_LINUX)
+		munmap(const_cast<u8*>(m_pData), m_size);
+#endif
 	}
+
+	m_buffer.clear();
+	m_buffer.shrink_to_fit();
+
+	m_pData = nullptr;
+	m_size = 0;
+	m_isMapped = false;
+}
+
+MemoryStream::Buffer::Buffer(const u8* pData, SizeType size)
+{
+	char* pBegin = const_cast<char*>(reinterpret_cast<const char*>(pData));
+	setg(pBegin, pBegin, pBegin + size);
+}
+
+MemoryStream::Buffer::pos_type MemoryStream::Buffer::seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+	char* pTarget = gptr();
+	if (dir == std::ios_base::beg)
+		pTarget = eback() + offset;
+	else if (dir == std::ios_base::cur)
+		pTarget = gptr() + offset;
+	else if (dir == std::ios_base::end)
+		pTarget = egptr() + offset;
+
+	if (!(which & std::ios_base::in) || pTarget < eback() || pTarget > egptr())
+		return pos_type(off_type(-1));
+
+	setg(eback(), pTarget, egptr());
+	return pos_type(pTarget - eback());
+}
+
+MemoryStream::Buffer::pos_type MemoryStream::Buffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+MemoryStream::MemoryStream(const u8* pData, SizeType size)
+	: std::istream(nullptr)
+	, m_buffer(pData, size)
+{
+	rdbuf(&m_buffer);
 }
\ No newline at end of file
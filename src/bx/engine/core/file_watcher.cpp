@@ -0,0 +1,191 @@
+#include "bx/engine/core/file_watcher.hpp"
+
+#include "bx/engine/core/file.hpp"
+#include "bx/engine/core/macros.hpp"
+
+#include <algorithm>
+
+#if defined(BX_PLATFORM_LINUX)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+static void AddChanged(List<String>& changed, const String& filename)
+{
+	if (std::find(changed.begin(), changed.end(), filename) == changed.end())
+		changed.emplace_back(filename);
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+bool FileWatcher::Watch(const String& root, f32 pollInterval)
+{
+	Stop();
+
+	if (!File::Exists(root))
+	{
+		BX_LOGE("Cannot watch {}, the directory does not exist!", root);
+		return false;
+	}
+
+	m_root = root;
+	m_pollInterval = pollInterval;
+	m_isWatching = true;
+
+#if defined(BX_PLATFORM_LINUX)
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotify >= 0)
+	{
+		m_isNotifying = true;
+		AddDirectory(m_root, nullptr);
+		return true;
+	}
+
+	BX_LOGW("inotify is not available (errno {}), polling {} instead.", errno, root);
+#endif
+
+	Scan(m_root, nullptr);
+	m_timer.Start();
+	return true;
+}
+
+void FileWatcher::Stop()
+{
+#if defined(BX_PLATFORM_LINUX)
+	if (m_inotify >= 0)
+		close(m_inotify);
+
+	m_inotify = -1;
+	m_directories.clear();
+#endif
+
+	m_lastWrites.clear();
+	m_isWatching = false;
+	m_isNotifying = false;
+}
+
+void FileWatcher::Poll(List<String>& changed)
+{
+	if (!m_isWatching)
+		return;
+
+#if defined(BX_PLATFORM_LINUX)
+	if (m_isNotifying)
+	{
+		alignas(inotify_event) char buffer[4096];
+		while (true)
+		{
+			const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;
+
+			for (ssize_t offset = 0; offset < length; )
+			{
+				const auto* pEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + pEvent->len;
+
+				if (pEvent->mask & IN_Q_OVERFLOW)
+				{
+					BX_LOGW("Too many file changes in {}, some may have been missed.", m_root);
+					continue;
+				}
+
+				auto it = m_directories.find(pEvent->wd);
+				if (it == m_directories.end())
+					continue;
+
+				if (pEvent->mask & IN_IGNORED)
+				{
+					m_directories.erase(it);
+					continue;
+				}
+
+				if (pEvent->len == 0)
+					continue;
+
+				const String path = it->second + "/" + pEvent->name;
+				if (pEvent->mask & IN_ISDIR)
+				{
+					// Files written before the watch was added would be missed, so report what is already there
+					if (pEvent->mask & (IN_CREATE | IN_MOVED_TO))
+						AddDirectory(path, &changed);
+
+					// Listings change either way
+					AddChanged(changed, path);
+				}
+				else
+				{
+					AddChanged(changed, path);
+				}
+			}
+		}
+		return;
+	}
+#endif
+
+	if (m_timer.Elapsed() < m_pollInterval)
+		return;
+
+	m_timer.Start();
+	Scan(m_root, &changed);
+}
+
+void FileWatcher::AddDirectory(const String& directory, List<String>* pChanged)
+{
+#if defined(BX_PLATFORM_LINUX)
+	const int wd = inotify_add_watch(m_inotify, File::GetPath(directory).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MOVED_FROM | IN_DELETE);
+	if (wd < 0)
+	{
+		BX_LOGE("Failed to watch {} (errno {})", directory, errno);
+		return;
+	}
+	m_directories[wd] = directory;
+
+	List<FileHandle> files;
+	if (!File::ListFiles(directory, files))
+		return;
+
+	for (const auto& file : files)
+	{
+		if (file.isDirectory)
+			AddDirectory(file.filepath, pChanged);
+		else if (pChanged != nullptr)
+			AddChanged(*pChanged, file.filepath);
+	}
+#endif
+}
+
+void FileWatcher::Scan(const String& directory, List<String>* pChanged)
+{
+	List<FileHandle> files;
+	if (!File::ListFiles(directory, files))
+		return;
+
+	for (const auto& file : files)
+	{
+		if (file.isDirectory)
+		{
+			Scan(file.filepath, pChanged);
+			continue;
+		}
+
+		const u64 lastWrite = File::LastWrite(file.filepath);
+		auto it = m_lastWrites.find(file.filepath);
+		if (it == m_lastWrites.end())
+		{
+			m_lastWrites.insert(std::make_pair(file.filepath, lastWrite));
+			if (pChanged != nullptr)
+				AddChanged(*pChanged, file.filepath);
+		}
+		else if (it->second != lastWrite)
+		{
+			it->second = lastWrite;
+			if (pChanged != nullptr)
+				AddChanged(*pChanged, file.filepath);
+		}
+	}
+}
\ No newline at end of file
@@ -4,25 +4,36 @@
 #include <iostream>
 #include <cstdarg>
 #include <cstdio>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #define LOG_LEVEL_OUTPUT 4
+#define LOG_MAX_ENTRIES 1024
 
+// Any thread can print, entries wait in the pending list until the console asks for them
+static std::mutex g_mutex;
+static std::vector<LogEntry> g_pending;
 static std::vector<LogEntry> g_entries;
 
+static void TrimEntries(std::vector<LogEntry>& entries)
+{
+	if (entries.size() > LOG_MAX_ENTRIES)
+		entries.erase(entries.begin(), entries.end() - LOG_MAX_ENTRIES);
+}
+
 void Log::Print(LogLevel level, const String& message)
 {
+	std::lock_guard<std::mutex> lock(g_mutex);
+
 	std::cout << message << std::endl;
 
 	if (level == LogLevel::LOG_DEBUG)
 		return;
 
 	// Output the formatted string to the console
-	g_entries.emplace_back(level, message);
-
-	if (g_entries.size() > 1024)
-		g_entries.erase(g_entries.begin());
+	g_pending.emplace_back(level, message);
+	TrimEntries(g_pending);
 }
 
 void Log::Print(const char* file, i32 line, const char* func, LogLevel level, const String& message)
@@ -33,11 +44,21 @@ void Log::Print(const char* file, i32 line, const char* func, LogLevel level, co
 
 LogEntry* Log::GetLogs(SizeType& count)
 {
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	for (auto& entry : g_pending)
+		g_entries.emplace_back(std::move(entry));
+	g_pending.clear();
+	TrimEntries(g_entries);
+
 	count = g_entries.size();
 	return g_entries.data();
 }
 
 void Log::Clear()
 {
+	std::lock_guard<std::mutex> lock(g_mutex);
+
+	g_pending.clear();
 	g_entries.clear();
 }
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "bx/engine/core/pak.hpp"
+
+#include "bx/engine/core/macros.hpp"
+#include "bx/engine/core/compression.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(PakHeader) == 40, "Pak header layout changed!");
+static_assert(sizeof(PakEntry) == 48, "Pak entry layout changed!");
+
+static inline u64 AlignOffset(u64 offset)
+{
+	return (offset + PAK_ALIGNMENT - 1) & ~(PAK_ALIGNMENT - 1);
+}
+
+PakArchive::PakArchive(const String& filename)
+{
+	Open(filename);
+}
+
+bool PakArchive::Open(const String& filename)
+{
+	Close();
+
+	if (!m_file.Open(filename))
+		return false;
+
+	PakHeader header;
+	if (m_file.GetSize() < sizeof(PakHeader))
+	{
+		BX_LOGE("Pak {} is truncated!", filename);
+		Close();
+		return false;
+	}
+
+	memcpy(&header, m_file.GetData(), sizeof(PakHeader));
+	if (header.magic != PAK_MAGIC || header.version != PAK_VERSION)
+	{
+		BX_LOGE("Pak {} is not a pak or was built with an incompatible version ({})!", filename, header.version);
+		Close();
+		return false;
+	}
+
+	const u64 indexEnd = header.indexOffset + u64(header.entryCount) * sizeof(PakEntry);
+	const u64 namesEnd = header.namesOffset + header.namesSize;
+	if (header.indexOffset % alignof(PakEntry) != 0 || indexEnd > m_file.GetSize() || namesEnd > m_file.GetSize())
+	{
+		BX_LOGE("Pak {} is truncated!", filename);
+		Close();
+		return false;
+	}
+
+	m_pEntries = reinterpret_cast<const PakEntry*>(m_file.GetData() + header.indexOffset);
+	m_pNames = reinterpret_cast<const char*>(m_file.GetData() + header.namesOffset);
+	m_entryCount = header.entryCount;
+
+	for (SizeType i = 0; i < m_entryCount; ++i)
+	{
+		const auto& entry = m_pEntries[i];
+		if (entry.offset + entry.size > m_file.GetSize() || u64(entry.nameOffset) + entry.nameSize > header.namesSize)
+		{
+			BX_LOGE("Pak {} has a corrupt entry ({})!", filename, i);
+			Close();
+			return false;
+		}
+	}
+
+	BX_LOGD("Opened pak {} ({} entries)", filename, m_entryCount);
+	return true;
+}
+
+void PakArchive::Close()
+{
+	m_file.Close();
+	m_pEntries = nullptr;
+	m_pNames = nullptr;
+	m_entryCount = 0;
+}
+
+u64 PakArchive::HashName(const String& name)
+{
+	// FNV-1a, stable across platforms and standard libraries unlike std::hash
+	u64 hash = 14695981039346656037ull;
+	for (char c : name)
+	{
+		hash ^= static_cast<u8>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+const PakEntry* PakArchive::Find(const String& name) const
+{
+	const u64 hash = HashName(name);
+
+	const PakEntry* pEnd = m_pEntries + m_entryCount;
+	const PakEntry* pEntry = std::lower_bound(m_pEntries, pEnd, hash,
+		[](const PakEntry& entry, u64 value) { return entry.hash < value; });
+
+	// Colliding hashes are adjacent
+	for (; pEntry != pEnd && pEntry->hash == hash; ++pEntry)
+	{
+		if (pEntry->nameSize == name.size() && memcmp(m_pNames + pEntry->nameOffset, name.data(), name.size()) == 0)
+			return pEntry;
+	}
+
+	return nullptr;
+}
+
+bool PakArchive::IsDirectory(const String& name) const
+{
+	const String prefix = name.empty() ? name : name + "/";
+	for (SizeType i = 0; i < m_entryCount; ++i)
+	{
+		const auto& entry = m_pEntries[i];
+		if (entry.nameSize > prefix.size() && memcmp(m_pNames + entry.nameOffset, prefix.data(), prefix.size()) == 0)
+			return true;
+	}
+	return false;
+}
+
+String PakArchive::GetName(const PakEntry& entry) const
+{
+	return String(m_pNames + entry.nameOffset, entry.nameSize);
+}
+
+const u8* PakArchive::Read(const PakEntry& entry, List<u8>& buffer) const
+{
+	const u8* pData = m_file.GetData() + entry.offset;
+
+	switch (entry.compression)
+	{
+	case PakCompression::NONE:
+		return pData;
+
+	case PakCompression::LZ4:
+		buffer.resize(entry.uncompressedSize);
+		if (!Compression::Decompress(pData, entry.size, buffer.data(), buffer.size()))
+		{
+			BX_LOGE("Pak entry {} is corrupt!", GetName(entry));
+			return nullptr;
+		}
+		return buffer.data();
+	}
+
+	BX_LOGE("Pak entry {} uses an unknown compression ({})!", GetName(entry), static_cast<u32>(entry.compression));
+	return nullptr;
+}
+
+void PakBuilder::AddFile(const String& name, const String& filename, bool compress)
+{
+	Source source;
+	source.name = name;
+	source.filename = filename;
+	source.compress = compress;
+	m_files.emplace_back(source);
+}
+
+bool PakBuilder::Write(const String& filename) const
+{
+	std::ofstream stream(File::GetPath(filename), std::ios::binary);
+	if (stream.fail())
+	{
+		BX_LOGE("Failed to create pak {}!", filename);
+		return false;
+	}
+
+	static const char s_padding[PAK_ALIGNMENT] = {};
+	auto pad = [&]()
+	{
+		const u64 pos = static_cast<u64>(stream.tellp());
+		stream.write(s_padding, static_cast<std::streamsize>(AlignOffset(pos) - pos));
+		return AlignOffset(pos);
+	};
+
+	// Patched once the index is known
+	PakHeader header;
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(PakHeader));
+
+	List<PakEntry> entries;
+	String names;
+	List<u8> compressed;
+
+	entries.reserve(m_files.size());
+	for (const auto& source : m_files)
+	{
+		// Empty files cannot be mapped but are valid entries
+		MappedFile file(source.filename);
+		if (!file.IsOpen() && std::ifstream(File::GetPath(source.filename), std::ios::binary | std::ios::ate).tellg() != 0)
+		{
+			BX_LOGE("Failed to read {} for pak {}!", source.filename, filename);
+			return false;
+		}
+
+		PakEntry entry;
+		entry.hash = PakArchive::HashName(source.name);
+		entry.offset = pad();
+		entry.uncompressedSize = file.GetSize();
+		entry.size = file.GetSize();
+		entry.nameOffset = static_cast<u32>(names.size());
+		entry.nameSize = static_cast<u32>(source.name.size());
+
+		const u8* pData = file.GetData();
+		if (source.compress && file.GetSize() > 0)
+		{
+			compressed.resize(Compression::GetMaxCompressedSize(file.GetSize()));
+			const SizeType size = Compression::Compress(file.GetData(), file.GetSize(), compressed.data(), compressed.size());
+			if (size > 0 && size < file.GetSize())
+			{
+				entry.compression = PakCompression::LZ4;
+				entry.size = size;
+				pData = compressed.data();
+			}
+		}
+
+		if (entry.size > 0)
+			stream.write(reinterpret_cast<const char*>(pData), static_cast<std::streamsize>(entry.size));
+
+		names += source.name;
+		entries.emplace_back(entry);
+	}
+
+	std::stable_sort(entries.begin(), entries.end(),
+		[](const PakEntry& a, const PakEntry& b) { return a.hash < b.hash; });
+
+	header.entryCount = static_cast<u32>(entries.size());
+	header.indexOffset = pad();
+	stream.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PakEntry)));
+
+	header.namesOffset = static_cast<u64>(stream.tellp());
+	header.namesSize = names.size();
+	stream.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+	stream.seekp(0);
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(PakHeader));
+
+	return !stream.fail();
+}
\ No newline at end of file
@@ -14,6 +14,7 @@ struct ProfilerEntry
 
 static HashMap<String, ProfilerData> s_data;
 static HashMap<String, ProfilerEntry> s_entries;
+static HashMap<String, f64> s_counters;
 static Timer timer;
 static f32 g_time = 0;
 
@@ -80,4 +81,14 @@ void Profiler::EndSection(const String& name)
 const HashMap<String, ProfilerData>& Profiler::GetData()
 {
     return s_data;
+}
+
+void Profiler::SetCounter(const String& name, f64 value)
+{
+    s_counters[name] = value;
+}
+
+const HashMap<String, f64>& Profiler::GetCounters()
+{
+    return s_counters;
 }
\ No newline at end of file
@@ -1,21 +1,250 @@
 #include "bx/engine/core/resource.hpp"
 #include "bx/engine/core/resource.serial.hpp"
 
+#include "bx/engine/core/thread.hpp"
+#include "bx/engine/core/file.hpp"
+#include "bx/engine/core/file_watcher.hpp"
+#include "bx/engine/core/time.hpp"
+#include "bx/engine/core/profiler.hpp"
+#include "bx/engine/core/data.hpp"
+#include "bx/engine/core/math.hpp"
+
+#include <algorithm>
+
 static HashMap<ResourceHandle, SizeType> g_refCountMap;
 
+static WorkerPool* g_pWorkers = nullptr;
+
+// Decoded jobs waiting for the main thread, shared with the workers
+static std::mutex g_readyLock;
+static List<std::shared_ptr<IResourceJob>> g_readyJobs;
+
+// Main thread only, counts queued jobs per filename
+static HashMap<String, SizeType> g_pendingFiles;
+static SizeType g_pendingCount = 0;
+
+static SizeType g_budget = 0;
+
+// Dependency filename to the filenames of the resources that requested it while loading
+static HashMap<String, List<String>> g_dependents;
+static List<String> g_loadStack;
+
+static FileWatcher* g_pWatcher = nullptr;
+
 void ResourceManager::Initialize()
 {
+	g_pWorkers = new WorkerPool();
+
+	// Per resource type, low memory targets can lower it in the system data
+	const i32 budget = Data::GetInt("Resource Cache Budget (MB)", 256, DataTarget::SYSTEM);
+	SetBudget(static_cast<SizeType>(Math::Max(budget, 0)) * 1024 * 1024);
+
+#if defined(BX_EDITOR_BUILD) || defined(BX_DEBUG_BUILD)
+	g_pWatcher = new FileWatcher();
+	if (!g_pWatcher->Watch("[assets]"))
+	{
+		delete g_pWatcher;
+		g_pWatcher = nullptr;
+	}
+#endif
 }
 
 void ResourceManager::Shutdown()
 {
+	// Joins the workers, jobs that have not been decoded yet are dropped
+	delete g_pWorkers;
+	g_pWorkers = nullptr;
+
+	delete g_pWatcher;
+	g_pWatcher = nullptr;
+
+	g_dependents.clear();
+	g_loadStack.clear();
+
+	g_readyJobs.clear();
+	g_pendingFiles.clear();
+	g_pendingCount = 0;
+
 	for (auto database : IResourceDatabase::GetDatabaseRecord())
 		database->Shutdown();
 
 	IResourceDatabase::GetDatabaseRecord().clear();
 }
 
+void ResourceManager::Update(f32 budget)
+{
+	PROFILE_FUNCTION();
+
+	static const f64 s_toMegabytes = 1.0 / (1024.0 * 1024.0);
+	for (auto database : IResourceDatabase::GetDatabaseRecord())
+	{
+		const auto& name = database->GetName();
+		Profiler::SetCounter(name + " CPU (MB)", database->GetResident().cpu * s_toMegabytes);
+		Profiler::SetCounter(name + " GPU (MB)", database->GetResident().gpu * s_toMegabytes);
+		Profiler::SetCounter(name + " Cached (MB)", database->GetCached().Total() * s_toMegabytes);
+	}
+
+	if (g_pWatcher != nullptr)
+	{
+		List<String> changed;
+		g_pWatcher->Poll(changed);
+
+		for (const auto& filename : changed)
+		{
+			File::Invalidate(filename);
+			if (File::Exists(filename))
+				Reload(filename);
+		}
+	}
+
+	if (g_pendingCount == 0)
+		return;
+
+	Timer timer;
+	timer.Start();
+
+	List<std::shared_ptr<IResourceJob>> jobs;
+	while (true)
+	{
+		if (jobs.empty())
+		{
+			std::unique_lock<std::mutex> lock(g_readyLock);
+			jobs.swap(g_readyJobs);
+		}
+
+		if (jobs.empty())
+			break;
+
+		// Finalize in the order the jobs were decoded
+		auto job = jobs.front();
+		jobs.erase(jobs.begin());
+
+		job->Finalize();
+
+		auto it = g_pendingFiles.find(job->GetFilename());
+		if (it != g_pendingFiles.end() && --it->second == 0)
+			g_pendingFiles.erase(it);
+		g_pendingCount--;
+
+		if (timer.Elapsed() * 1000.0f >= budget)
+			break;
+	}
+
+	// Hand back whatever did not fit in the budget
+	if (!jobs.empty())
+	{
+		std::unique_lock<std::mutex> lock(g_readyLock);
+		g_readyJobs.insert(g_readyJobs.begin(), jobs.begin(), jobs.end());
+	}
+}
+
+void ResourceManager::Flush()
+{
+	while (g_pendingCount > 0)
+	{
+		Update(1000.0f);
+		std::this_thread::yield();
+	}
+}
+
+SizeType ResourceManager::GetPendingCount()
+{
+	return g_pendingCount;
+}
+
+bool ResourceManager::IsPending(const String& filename)
+{
+	return g_pendingFiles.find(filename) != g_pendingFiles.end();
+}
+
+bool ResourceManager::IsIdle()
+{
+	return g_pendingCount == 0;
+}
+
+void ResourceManager::SetBudget(SizeType budget)
+{
+	g_budget = budget;
+
+	for (auto database : IResourceDatabase::GetDatabaseRecord())
+		database->SetBudget(budget);
+}
+
+SizeType ResourceManager::GetBudget()
+{
+	return g_budget;
+}
+
+void ResourceManager::Reload(const String& filename)
+{
+	// Breadth first so dependencies are reloaded before whatever depends on them
+	List<String> queue;
+	queue.emplace_back(filename);
+
+	for (SizeType i = 0; i < queue.size(); ++i)
+	{
+		const String current = queue[i];
+
+		bool isLoaded = false;
+		for (auto database : IResourceDatabase::GetDatabaseRecord())
+			isLoaded |= database->Reload(current);
+
+		if (!isLoaded)
+			continue;
+
+		BX_LOGI("Reloaded {}", current);
+
+		auto it = g_dependents.find(current);
+		if (it == g_dependents.end())
+			continue;
+
+		for (const auto& dependent : it->second)
+		{
+			if (std::find(queue.begin(), queue.end(), dependent) == queue.end())
+				queue.emplace_back(dependent);
+		}
+	}
+}
+
+void ResourceManager::BeginLoad(const String& filename)
+{
+	g_loadStack.emplace_back(filename);
+}
+
+void ResourceManager::EndLoad()
+{
+	BX_ASSERT(!g_loadStack.empty(), "Unbalanced resource load!");
+	g_loadStack.pop_back();
+}
+
+void ResourceManager::RecordDependency(const String& filename)
+{
+	if (g_loadStack.empty() || filename.empty())
+		return;
+
+	auto& dependents = g_dependents[filename];
+	const auto& dependent = g_loadStack.back();
+	if (std::find(dependents.begin(), dependents.end(), dependent) == dependents.end())
+		dependents.emplace_back(dependent);
+}
+
+void ResourceManager::QueueJob(const std::shared_ptr<IResourceJob>& job)
+{
+	BX_ASSERT(g_pWorkers != nullptr, "Resource manager is not initialized!");
+
+	g_pendingFiles[job->GetFilename()]++;
+	g_pendingCount++;
+
+	g_pWorkers->Queue([job]()
+	{
+		job->Decode();
+
+		std::unique_lock<std::mutex> lock(g_readyLock);
+		g_readyJobs.emplace_back(job);
+	});
+}
+
 HashMap<ResourceHandle, SizeType>& ResourceManager::GetRefCountMap()
 {
 	return g_refCountMap;
-}
\ No newline at end of file
+}
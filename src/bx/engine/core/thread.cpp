@@ -42,6 +42,64 @@ void Worker::Loop()
 		task = m_queue.front();
 		m_queue.pop();
 
+		qlk.unlock();
+		task();
+	}
+}
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+	: m_queueLock()
+	, m_queue()
+	, m_queueCondition()
+	, m_running(true)
+{
+	if (threadCount == 0)
+	{
+		const unsigned int hardware = std::thread::hardware_concurrency();
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	m_threads.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; ++i)
+		m_threads.emplace_back(&WorkerPool::Loop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	std::unique_lock<std::mutex> qlk(m_queueLock);
+	m_running = false;
+
+	qlk.unlock();
+	m_queueCondition.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+void WorkerPool::Queue(std::function<void()> task)
+{
+	std::unique_lock<std::mutex> qlk(m_queueLock);
+	m_queue.push(std::move(task));
+
+	qlk.unlock();
+	m_queueCondition.notify_one();
+}
+
+void WorkerPool::Loop()
+{
+	std::function<void()> task;
+	while (true)
+	{
+		std::unique_lock<std::mutex> qlk(m_queueLock);
+		m_queueCondition.wait(qlk, [&]() { return !m_queue.empty() || !m_running; });
+
+		if (!m_running)
+			break;
+
+		task = std::move(m_queue.front());
+		m_queue.pop();
+
+		qlk.unlock();
 		task();
 	}
 }
\ No newline at end of file
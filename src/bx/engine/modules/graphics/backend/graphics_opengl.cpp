@@ -507,6 +507,10 @@ static GLenum GetTextureFormat(TextureFormat format)
     case TextureFormat::RGBA8_UNORM: return GL_RGBA8;
     case TextureFormat::RG32_UINT: return GL_RG32UI;
     case TextureFormat::D24_UNORM_S8_UINT: return GL_DEPTH24_STENCIL8;
+    case TextureFormat::BC1_UNORM: return COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case TextureFormat::BC3_UNORM: return COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TextureFormat::BC5_UNORM: return GL_COMPRESSED_RG_RGTC2;
+    case TextureFormat::BC7_UNORM: return GL_COMPRESSED_RGBA_BPTC_UNORM;
 
     default:
         BX_FAIL("Texture format not supported!");
@@ -514,6 +518,18 @@ static GLenum GetTextureFormat(TextureFormat format)
     }
 }
 
+// Pixel transfer format and type of uncompressed formats
+static void GetTexturePixelFormat(TextureFormat format, GLenum& pixelFormat, GLenum& type)
+{
+    switch (format)
+    {
+    case TextureFormat::RGB8_UNORM: pixelFormat = GL_RGB; type = GL_UNSIGNED_BYTE; break;
+    case TextureFormat::RG32_UINT: pixelFormat = GL_RG_INTEGER; type = GL_UNSIGNED_INT; break;
+    case TextureFormat::D24_UNORM_S8_UINT: pixelFormat = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; break;
+    default: pixelFormat = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+    }
+}
+
 GraphicsHandle Graphics::CreateTexture(const TextureInfo& info)
 {
     TextureImpl texture_impl;
@@ -558,21 +574,42 @@ GraphicsHandle Graphics::CreateTexture(const TextureInfo& info, const BufferData
 
     GLenum internalFormat = GetTextureFormat(info.format);
 
-    // TODO:
-    GLenum format = GL_RGBA;// GetTextureFormat(info.format);
-    GLenum type = GL_UNSIGNED_BYTE;// GetTextureFormat(info.format);
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    GetTexturePixelFormat(info.format, format, type);
+
+    const u32 mipCount = info.mipCount > 0 ? info.mipCount : 1;
+    BX_ASSERT(data.dataSize >= GetTextureSize(info.format, info.width, info.height, mipCount), "Texture data is smaller than its levels!");
 
 #ifdef GRAPHICS_BINDLESS
     glCreateSamplers(1, &texture_impl.sampler);
     glSamplerParameteri(texture_impl.sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glSamplerParameteri(texture_impl.sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glSamplerParameteri(texture_impl.sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(texture_impl.sampler, GL_TEXTURE_MIN_FILTER, mipCount > 1 ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST);
     glSamplerParameteri(texture_impl.sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     
     glCreateTextures(GL_TEXTURE_2D, 1, &texture_impl.texture);
-    glTextureStorage2D(texture_impl.texture, 1, internalFormat, info.width, info.height);
-    glTextureSubImage2D(texture_impl.texture, 0, 0, 0, info.width, info.height, format, type, data.pData);
-    glGenerateTextureMipmap(texture_impl.texture);
+    glTextureStorage2D(texture_impl.texture, mipCount, internalFormat, info.width, info.height);
+
+    // Every level comes with the data, tightly packed so rows must not be padded
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const u8* pLevel = static_cast<const u8*>(data.pData);
+    for (u32 level = 0; level < mipCount; ++level)
+    {
+        const u32 width = GetTextureLevelExtent(info.width, level);
+        const u32 height = GetTextureLevelExtent(info.height, level);
+        const SizeType levelSize = GetTextureLevelSize(info.format, info.width, info.height, level);
+
+        if (IsBlockCompressed(info.format))
+            glCompressedTextureSubImage2D(texture_impl.texture, level, 0, 0, width, height, internalFormat, static_cast<GLsizei>(levelSize), pLevel);
+        else
+            glTextureSubImage2D(texture_impl.texture, level, 0, 0, width, height, format, type, pLevel);
+
+        pLevel += levelSize;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     
     BX_ENSURE(glGetTextureSamplerHandleARB != nullptr);
     texture_impl.handle = glGetTextureSamplerHandleARB(texture_impl.texture, texture_impl.sampler);
@@ -669,12 +706,24 @@ static GLenum GetValueType(GraphicsValueType vt)
 {
     switch (vt)
     {
-    case GraphicsValueType::FLOAT32: return GL_FLOAT;
+    case GraphicsValueType::INT8: return GL_BYTE;
         break;
-    case GraphicsValueType::UINT32: return GL_UNSIGNED_INT;
+    case GraphicsValueType::INT16: return GL_SHORT;
         break;
     case GraphicsValueType::INT32: return GL_INT;
         break;
+    case GraphicsValueType::UINT8: return GL_UNSIGNED_BYTE;
+        break;
+    case GraphicsValueType::UINT16: return GL_UNSIGNED_SHORT;
+        break;
+    case GraphicsValueType::UINT32: return GL_UNSIGNED_INT;
+        break;
+    case GraphicsValueType::FLOAT16: return GL_HALF_FLOAT;
+        break;
+    case GraphicsValueType::FLOAT32: return GL_FLOAT;
+        break;
+    case GraphicsValueType::INT10_10_10_2: return GL_INT_2_10_10_10_REV;
+        break;
 
     default:
         BX_LOGE("Value type not supported!");
@@ -686,12 +735,22 @@ static u32 GetValueSize(GraphicsValueType vt)
 {
     switch (vt)
     {
-    case GraphicsValueType::FLOAT32: return sizeof(f32);
+    case GraphicsValueType::INT8: return sizeof(i8);
         break;
-    case GraphicsValueType::UINT32: return sizeof(u32);
+    case GraphicsValueType::INT16: return sizeof(i16);
         break;
     case GraphicsValueType::INT32: return sizeof(i32);
         break;
+    case GraphicsValueType::UINT8: return sizeof(u8);
+        break;
+    case GraphicsValueType::UINT16: return sizeof(u16);
+        break;
+    case GraphicsValueType::UINT32: return sizeof(u32);
+        break;
+    case GraphicsValueType::FLOAT16: return sizeof(u16);
+        break;
+    case GraphicsValueType::FLOAT32: return sizeof(f32);
+        break;
 
     default:
         BX_LOGE("Value type not supported!");
@@ -699,6 +758,28 @@ static u32 GetValueSize(GraphicsValueType vt)
     }
 }
 
+static u32 GetElementSize(const LayoutElement& elem)
+{
+    if (elem.valueType == GraphicsValueType::INT10_10_10_2)
+        return sizeof(u32);
+
+    return elem.numComponents * GetValueSize(elem.valueType);
+}
+
+static bool IsIntegerAttrib(const LayoutElement& elem)
+{
+    switch (elem.valueType)
+    {
+    case GraphicsValueType::FLOAT16:
+    case GraphicsValueType::FLOAT32:
+    case GraphicsValueType::INT10_10_10_2:
+        return false;
+
+    default:
+        return !elem.isNormalized;
+    }
+}
+
 GraphicsHandle Graphics::CreatePipeline(const PipelineInfo& info)
 {
     const auto& vert_shader = GetImpl(info.vertShader, s_shaders);
@@ -731,15 +812,15 @@ GraphicsHandle Graphics::CreatePipeline(const PipelineInfo& info)
             relativeOffset = elem.relativeOffset;
         }
 
-        if (elem.valueType == GraphicsValueType::FLOAT32)
-            glVertexArrayAttribFormat(vao_handle, elem.inputIndex, elem.numComponents, GetValueType(elem.valueType), elem.isNormalized, relativeOffset);
-        if (elem.valueType == GraphicsValueType::INT32)
+        if (IsIntegerAttrib(elem))
             glVertexArrayAttribIFormat(vao_handle, elem.inputIndex, elem.numComponents, GetValueType(elem.valueType), relativeOffset);
+        else
+            glVertexArrayAttribFormat(vao_handle, elem.inputIndex, elem.numComponents, GetValueType(elem.valueType), elem.isNormalized, relativeOffset);
 
         glEnableVertexArrayAttrib(vao_handle, elem.inputIndex);
         glVertexArrayAttribBinding(vao_handle, elem.inputIndex, elem.bufferSlot);
 
-        relativeOffset += elem.numComponents * GetValueSize(elem.valueType);
+        relativeOffset += GetElementSize(elem);
     }
 
     PipelineImpl pipeline_impl;
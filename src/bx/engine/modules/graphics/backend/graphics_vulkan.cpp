@@ -1703,10 +1703,32 @@ static void BindTexture(const PipelineImpl& pipelineImpl, const TextureImpl& tex
     }
 }
 
+static VkFormat GetTextureFormat(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::RGB8_UNORM: return VK_FORMAT_R8G8B8_UNORM;
+    case TextureFormat::RGBA8_UNORM: return VK_FORMAT_R8G8B8A8_UNORM;
+    case TextureFormat::RG32_UINT: return VK_FORMAT_R32G32_UINT;
+    case TextureFormat::D24_UNORM_S8_UINT: return VK_FORMAT_D24_UNORM_S8_UINT;
+    case TextureFormat::BC1_UNORM: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case TextureFormat::BC3_UNORM: return VK_FORMAT_BC3_UNORM_BLOCK;
+    case TextureFormat::BC5_UNORM: return VK_FORMAT_BC5_UNORM_BLOCK;
+    case TextureFormat::BC7_UNORM: return VK_FORMAT_BC7_UNORM_BLOCK;
+
+    default:
+        BX_FAIL("Texture format not supported!");
+        return VK_FORMAT_UNDEFINED;
+    }
+}
+
 GraphicsHandle Graphics::CreateTexture(const TextureInfo& info, const BufferData& data)
 {
     TextureImpl impl;
 
+    const VkFormat format = GetTextureFormat(info.format);
+    const u32 mipCount = info.mipCount > 0 ? info.mipCount : 1;
+
     //unsigned char* pixels;
     //int width, height;
     //io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
@@ -1716,11 +1738,11 @@ GraphicsHandle Graphics::CreateTexture(const TextureInfo& info, const BufferData
     {
         VkImageCreateInfo imgInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
         imgInfo.imageType = VK_IMAGE_TYPE_2D;
-        imgInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imgInfo.format = format;
         imgInfo.extent.width = info.width;
         imgInfo.extent.height = info.height;
         imgInfo.extent.depth = 1;
-        imgInfo.mipLevels = 1;
+        imgInfo.mipLevels = mipCount;
         imgInfo.arrayLayers = 1;
         imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imgInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -1742,88 +1764,127 @@ GraphicsHandle Graphics::CreateTexture(const TextureInfo& info, const BufferData
         VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         viewInfo.image = impl.image;
         viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        viewInfo.format = format;
         viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.levelCount = mipCount;
         viewInfo.subresourceRange.layerCount = 1;
         VK_CHECK(vkCreateImageView(g_ctx.device, &viewInfo, g_ctx.allocator, &impl.view));
     }
 
     //BindTexture(pipeline, texture); // ????
-    
-    // Create the Upload Buffer:
-    /*{
-        VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        bufferInfo.size = data.dataSize;
-        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        VK_CHECK(vkCreateBuffer(g_ctx.device, &bufferInfo, g_ctx.allocator, &g_ctx.uploadBuffer));
 
-        VkMemoryRequirements req;
-        vkGetBufferMemoryRequirements(g_ctx.device, g_ctx.uploadBuffer, &req);
-        g_ctx.bufferMemoryAlignment = (g_ctx.bufferMemoryAlignment > req.alignment) ? g_ctx.bufferMemoryAlignment : req.alignment;
-        
-        VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        allocInfo.allocationSize = req.size;
-        allocInfo.memoryTypeIndex = GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, req.memoryTypeBits);
-        VK_CHECK(vkAllocateMemory(g_ctx.device, &allocInfo, g_ctx.allocator, &g_ctx.uploadBufferMemory));
-        VK_CHECK(vkBindBufferMemory(g_ctx.device, g_ctx.uploadBuffer, g_ctx.uploadBufferMemory, 0));
-    }
-
-    // Upload to Buffer:
+    if (data.pData != nullptr)
     {
-        char* map = nullptr;
-        VK_CHECK(vkMapMemory(g_ctx.device, g_ctx.uploadBufferMemory, 0, data.dataSize, 0, (void**)(&map)));
-        memcpy(map, data.pData, data.dataSize);
-        VkMappedMemoryRange range[1] = {};
-        range[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        range[0].memory = g_ctx.uploadBufferMemory;
-        range[0].size = data.dataSize;
-        VK_CHECK(vkFlushMappedMemoryRanges(g_ctx.device, 1, range));
-        vkUnmapMemory(g_ctx.device, g_ctx.uploadBufferMemory);
-    }
+        // Levels are packed tightly one after another, block compressed rows are ((w + 3) / 4) * block size
+        const VkDeviceSize uploadSize = GetTextureSize(info.format, info.width, info.height, mipCount);
+        BX_ASSERT(data.dataSize >= uploadSize, "Texture data is smaller than its mip chain!");
 
-    auto commandBuffer = BeginCommand();
+        // Create the Upload Buffer:
+        VkBuffer uploadBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory uploadBufferMemory = VK_NULL_HANDLE;
+        {
+            VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+            bufferInfo.size = uploadSize;
+            bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            VK_CHECK(vkCreateBuffer(g_ctx.device, &bufferInfo, g_ctx.allocator, &uploadBuffer));
+
+            VkMemoryRequirements req;
+            vkGetBufferMemoryRequirements(g_ctx.device, uploadBuffer, &req);
+
+            VkMemoryAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+            allocInfo.allocationSize = req.size;
+            allocInfo.memoryTypeIndex = GetMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, req.memoryTypeBits);
+            VK_CHECK(vkAllocateMemory(g_ctx.device, &allocInfo, g_ctx.allocator, &uploadBufferMemory));
+            VK_CHECK(vkBindBufferMemory(g_ctx.device, uploadBuffer, uploadBufferMemory, 0));
+        }
 
-    // Copy to Image:
-    {
-        VkImageMemoryBarrier copy_barrier[1] = {};
-        copy_barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        copy_barrier[0].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        copy_barrier[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        copy_barrier[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        copy_barrier[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        copy_barrier[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        copy_barrier[0].image = impl.image;
-        copy_barrier[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copy_barrier[0].subresourceRange.levelCount = 1;
-        copy_barrier[0].subresourceRange.layerCount = 1;
-        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, copy_barrier);
-
-        VkBufferImageCopy region = {};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent.width = info.width;
-        region.imageExtent.height = info.height;
-        region.imageExtent.depth = 1;
-        vkCmdCopyBufferToImage(commandBuffer, g_ctx.uploadBuffer, impl.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-        VkImageMemoryBarrier use_barrier[1] = {};
-        use_barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        use_barrier[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        use_barrier[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        use_barrier[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        use_barrier[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        use_barrier[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        use_barrier[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        use_barrier[0].image = impl.image;
-        use_barrier[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        use_barrier[0].subresourceRange.levelCount = 1;
-        use_barrier[0].subresourceRange.layerCount = 1;
-        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, use_barrier);
-    }
+        // Upload to Buffer:
+        {
+            char* map = nullptr;
+            VK_CHECK(vkMapMemory(g_ctx.device, uploadBufferMemory, 0, uploadSize, 0, (void**)(&map)));
+            memcpy(map, data.pData, uploadSize);
+            vkUnmapMemory(g_ctx.device, uploadBufferMemory);
+        }
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        {
+            VkCommandBufferAllocateInfo cmdBuffInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+            cmdBuffInfo.commandPool = g_ctx.commandPool;
+            cmdBuffInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            cmdBuffInfo.commandBufferCount = 1;
+            VK_CHECK(vkAllocateCommandBuffers(g_ctx.device, &cmdBuffInfo, &commandBuffer));
+
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+        }
 
-    EndCommand();*/
+        // Copy to Image:
+        {
+            VkImageMemoryBarrier copy_barrier[1] = {};
+            copy_barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            copy_barrier[0].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            copy_barrier[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            copy_barrier[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            copy_barrier[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            copy_barrier[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            copy_barrier[0].image = impl.image;
+            copy_barrier[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy_barrier[0].subresourceRange.levelCount = mipCount;
+            copy_barrier[0].subresourceRange.layerCount = 1;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, copy_barrier);
+
+            // One region per mip level, a zero row length and image height means tightly packed
+            List<VkBufferImageCopy> regions(mipCount);
+            VkDeviceSize offset = 0;
+            for (u32 level = 0; level < mipCount; ++level)
+            {
+                VkBufferImageCopy& region = regions[level];
+                region.bufferOffset = offset;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel = level;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent.width = GetTextureLevelExtent(info.width, level);
+                region.imageExtent.height = GetTextureLevelExtent(info.height, level);
+                region.imageExtent.depth = 1;
+
+                offset += GetTextureLevelSize(info.format, info.width, info.height, level);
+            }
+            vkCmdCopyBufferToImage(commandBuffer, uploadBuffer, impl.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipCount, regions.data());
+
+            VkImageMemoryBarrier use_barrier[1] = {};
+            use_barrier[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            use_barrier[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            use_barrier[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            use_barrier[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            use_barrier[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            use_barrier[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            use_barrier[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            use_barrier[0].image = impl.image;
+            use_barrier[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            use_barrier[0].subresourceRange.levelCount = mipCount;
+            use_barrier[0].subresourceRange.layerCount = 1;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, use_barrier);
+        }
+
+        // Submit and wait, the upload buffer is released right after
+        {
+            VK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+            VkSubmitInfo submitInfo = {};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &commandBuffer;
+            VK_CHECK(vkQueueSubmit(g_ctx.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+            vkQueueWaitIdle(g_ctx.graphicsQueue);
+
+            vkFreeCommandBuffers(g_ctx.device, g_ctx.commandPool, 1, &commandBuffer);
+            vkDestroyBuffer(g_ctx.device, uploadBuffer, g_ctx.allocator);
+            vkFreeMemory(g_ctx.device, uploadBufferMemory, g_ctx.allocator);
+        }
+    }
     
     // Store into global map
     static GraphicsHandle g_counter = 0;
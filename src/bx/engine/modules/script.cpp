@@ -6,10 +6,13 @@
 #include "bx/engine/core/data.hpp"
 #include "bx/engine/core/profiler.hpp"
 #include "bx/engine/core/file.hpp"
+#include "bx/engine/core/resource.hpp"
 #include "bx/engine/core/math.hpp"
 #include "bx/engine/core/ecs.hpp"
+#include "bx/engine/core/thread.hpp"
 #include "bx/engine/containers/string.hpp"
 #include "bx/engine/containers/hash_map.hpp"
+#include "bx/engine/containers/hash_set.hpp"
 
 #include "bx/engine/modules/audio.hpp"
 #include "bx/engine/modules/graphics.hpp"
@@ -34,10 +37,13 @@
 #include <bx/framework/systems/dynamics.hpp>
 #include <bx/framework/systems/acoustics.hpp>
 #include <bx/framework/gameobject.hpp>
+#include <bx/framework/scene_streamer.hpp>
 
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <mutex>
+#include <tuple>
 
 extern "C" {
 #include <wren.h>
@@ -54,23 +60,309 @@ static WrenVM* s_vm;
 static WrenHandle* s_goNewMethod = nullptr;
 static WrenHandle* s_goStartMethod = nullptr;
 static WrenHandle* s_goUpdateMethod = nullptr;
+static WrenHandle* s_fnCallMethod = nullptr;
 
 static List<BindApiFn> g_bindApis;
 
 static bool s_initialized = false;
-static bool s_error = false;
+// Set by errors of the worker VMs too
+static std::atomic<bool> s_error(false);
+
+using ScriptCommand = std::function<void()>;
+
+// Duration of the last collection of a VM in milliseconds, and the threshold it left for the next one
+struct ScriptGcState
+{
+	f32 time = 0.0f;
+	size_t next = 0;
+};
+
+// A call into scripts being profiled, the name belongs to the caller and outlives the call.
+// The heap is the one of the VM called, job safe game objects start on a worker VM.
+struct ScriptProfileFrame
+{
+	const String* pName = nullptr;
+	WrenVM* vm = nullptr;
+	TimePoint start;
+	TimeSpan children{};
+	size_t bytesAllocated = 0;
+	size_t nextGC = 0;
+};
+
+// A VM of its own for the game objects of job safe classes, updated by one thread at a time.
+// The foreign bindings are only read once BindApi is done, so every VM shares them.
+struct ScriptWorker
+{
+	u32 index = 0;
+	WrenVM* vm = nullptr;
+
+	HashSet<String> modules;
+	// Game object classes registered by the modules of this VM
+	HashMap<String, WrenHandle*> classes;
+
+	WrenHandle* newMethod = nullptr;
+	WrenHandle* startMethod = nullptr;
+	WrenHandle* updateMethod = nullptr;
+	WrenHandle* callMethod = nullptr;
+
+	// Deferred while updating in parallel, run by the main thread afterwards
+	List<ScriptCommand> commands;
+
+	// Collected between frames with the main VM, while the workers are idle
+	ScriptGcState gc;
+
+	// Calls profiled while updating in parallel, merged into the main profile afterwards
+	HashMap<String, ScriptProfileData> profile;
+	List<ScriptProfileFrame> profileStack;
+	TimeSpan profileTime{};
+};
+
+static List<std::unique_ptr<ScriptWorker>> s_workers;
+static WorkerPool* s_pWorkerPool = nullptr;
+static u32 s_nextWorker = 0;
+
+// Classes registered with GameObject.registerJobSafe
+static HashSet<String> s_jobSafeClasses;
+
+// Commands deferred outside of the workers
+static List<ScriptCommand> s_commands;
+
+// The worker whose game objects this thread is updating
+static thread_local ScriptWorker* t_pWorker = nullptr;
+
+static ScriptWorker* FindWorker(WrenVM* vm)
+{
+	for (auto& pWorker : s_workers)
+	{
+		if (pWorker->vm == vm)
+			return pWorker.get();
+	}
+	return nullptr;
+}
+
+// Runs the command after the update when called from a worker, right away otherwise
+static void DeferOnWorker(const ScriptCommand& command)
+{
+	if (t_pWorker != nullptr)
+		t_pWorker->commands.emplace_back(command);
+	else
+		command();
+}
+
+// Structural changes that return a result can't wait for the update to end, the script gets an error instead
+static bool AbortOnWorker(WrenVM* vm, const char* signature)
+{
+	if (t_pWorker == nullptr)
+		return false;
+
+	const String msg = String(signature) + " can not be called from a job safe game object, use GameObject.defer(_)";
+	wrenEnsureSlots(vm, 1);
+	wrenSetSlotString(vm, 0, msg.c_str());
+	wrenAbortFiber(vm, 0);
+	return true;
+}
+
+// Binds a static function that changes state outside of the game object, calls from a worker copy the
+// arguments and run once the update is done
+template<typename Signature, Signature>
+struct ScriptDeferredInvoke;
+
+template<typename... Args, void(*f)(Args...)>
+struct ScriptDeferredInvoke<void(*)(Args...), f>
+{
+	static void Call(WrenVM* vm)
+	{
+		wrenEnsureSlots(vm, static_cast<i32>(sizeof...(Args)) + 1);
+		CallImpl(vm, meta::make_index_sequence<sizeof...(Args)>{});
+	}
+
+	template<std::size_t... index>
+	static void CallImpl(WrenVM* vm, meta::index_sequence<index...>)
+	{
+		const std::tuple<typename std::decay<Args>::type...> args(ScriptArg<Args>::Get(vm, index + 1)...);
+		DeferOnWorker([args]() { f(std::get<index>(args)...); });
+	}
+};
+
+// Data lookups insert missing values, the workers take turns
+static std::mutex s_workerDataLock;
+
+template<typename T, T&(*f)(const String&, T, DataTarget)>
+static void DataAccess(WrenVM* vm)
+{
+	wrenEnsureSlots(vm, 4);
+	const String name = ScriptArg<const String&>::Get(vm, 1);
+	const T value = ScriptArg<T>::Get(vm, 2);
+	const DataTarget target = ScriptArg<DataTarget>::Get(vm, 3);
+
+	T result;
+	{
+		std::lock_guard<std::mutex> lock(s_workerDataLock);
+		result = f(name, value, target);
+	}
+	ScriptArg<T>::Set(vm, 0, result);
+}
+
+// Wren collects by itself once the heap reaches the next threshold, in the middle of whichever script
+// happens to allocate. Collecting between frames once the heap gets close keeps that off the update.
+constexpr f64 SCRIPT_GC_FORCE_RATIO = 0.9;
+// After a collection the threshold is this far above the live heap
+constexpr i32 SCRIPT_HEAP_GROWTH_PERCENT = 80;
+// Collections that fit the budget start once this much of the way from the heap left by the last
+// collection to the threshold has been allocated, the smaller heap makes the next one cheaper.
+// Starting any lower would collect again right away, a collection leaves the heap at 1 / 1.8 of it.
+constexpr f64 SCRIPT_GC_EARLY_FRACTION = 0.5;
+constexpr f64 SCRIPT_GC_COLLECTED_RATIO = 100.0 / (100.0 + SCRIPT_HEAP_GROWTH_PERCENT);
+constexpr f64 SCRIPT_GC_EARLY_RATIO = SCRIPT_GC_COLLECTED_RATIO + (1.0 - SCRIPT_GC_COLLECTED_RATIO) * SCRIPT_GC_EARLY_FRACTION;
+
+static ScriptGcState s_gc;
+
+static ScriptProfileMode s_profileMode = ScriptProfileMode::OFF;
+static u32 s_profileInterval = 30;
+static u64 s_profileFrame = 0;
+static bool s_profiling = false;
+static TimeSpan s_profileTime{};
+// Summed over the workers, which run at the same time
+static TimeSpan s_workersProfileTime{};
+static HashMap<String, ScriptProfileData> s_profile;
+static List<ScriptProfileFrame> s_profileStack;
+
+// Profile names of the calls into a game object class, built once per class and never removed
+// since the game objects of a class point at them
+struct GameObjectProfileNames
+{
+	String start;
+	String update;
+};
+static HashMap<String, GameObjectProfileNames> s_gameObjectProfileNames;
+
+// Profiles the call into scripts for as long as it lives
+class ScriptProfileScope
+{
+public:
+	ScriptProfileScope(WrenVM* vm, const String& name)
+		: m_isProfiling(Script::IsProfiling())
+	{
+		if (m_isProfiling)
+			Script::BeginProfile(vm, name);
+	}
+
+	~ScriptProfileScope()
+	{
+		if (m_isProfiling)
+			Script::EndProfile();
+	}
+
+private:
+	bool m_isProfiling;
+};
 
 // Wren binding context state
 static const char* s_moduleName = nullptr;
 static const char* s_className = nullptr;
 
-// Wren storage for module code sources
-static HashMap<String, String> s_wrenModulesSource;
+// Modules already handed to the VM, sources are only kept while compiling
+static HashSet<String> s_wrenModules;
+
+static HashSet<String>& GetModules(WrenVM* vm)
+{
+	ScriptWorker* pWorker = FindWorker(vm);
+	return pWorker != nullptr ? pWorker->modules : s_wrenModules;
+}
+
+// Foreign functions by module, class, static flag and signature (empty for classes).
+// Looked up by a hash over every part of the name with a separator in between, the name itself is kept
+// and compared on every hit, so two bindings can never share an entry unnoticed.
+template <typename TFn>
+class ScriptBindingTable
+{
+public:
+	bool Add(const char* moduleName, const char* className, bool isStatic, const char* signature, TFn fn)
+	{
+		const u64 hash = GetHash(moduleName, className, isStatic, signature);
+		auto it = m_indices.find(hash);
+		if (it != m_indices.end())
+		{
+			const Entry& entry = m_entries[it->second];
+			if (!entry.Matches(moduleName, className, isStatic, signature))
+			{
+				BX_LOGE("Script binding {}.{}.{} collides with {}.{}.{}!", moduleName, className, signature, entry.moduleName, entry.className, entry.signature);
+				BX_ASSERT(false, "Script binding hash collision!");
+				return false;
+			}
+
+			if (entry.fn != fn)
+				BX_LOGW("Script binding {}.{}.{} is bound twice, the first one is kept.", moduleName, className, signature);
+			return false;
+		}
+
+		m_indices.insert(std::make_pair(hash, m_entries.size()));
+		m_entries.emplace_back(Entry{ moduleName, className, isStatic, signature, fn });
+		return true;
+	}
+
+	TFn Find(const char* moduleName, const char* className, bool isStatic, const char* signature) const
+	{
+		auto it = m_indices.find(GetHash(moduleName, className, isStatic, signature));
+		if (it == m_indices.end())
+			return nullptr;
+
+		const Entry& entry = m_entries[it->second];
+		return entry.Matches(moduleName, className, isStatic, signature) ? entry.fn : nullptr;
+	}
+
+	void Clear()
+	{
+		m_entries.clear();
+		m_indices.clear();
+	}
+
+private:
+	struct Entry
+	{
+		String moduleName;
+		String className;
+		bool isStatic;
+		String signature;
+		TFn fn;
+
+		bool Matches(const char* module, const char* cls, bool stat, const char* sig) const
+		{
+			return isStatic == stat && moduleName == module && className == cls && signature == sig;
+		}
+	};
+
+	// 64 bit FNV-1a, streamed over the C strings so lookups don't build any temporary String
+	static u64 GetHash(const char* moduleName, const char* className, bool isStatic, const char* signature)
+	{
+		u64 hash = 14695981039346656037ULL;
+		const auto mix = [&hash](u8 byte)
+		{
+			hash ^= byte;
+			hash *= 1099511628211ULL;
+		};
+		const auto mixString = [&mix](const char* str)
+		{
+			for (; *str != '\0'; ++str)
+				mix(static_cast<u8>(*str));
+			mix(0);
+		};
+
+		mixString(moduleName);
+		mixString(className);
+		mix(isStatic ? 1 : 0);
+		mixString(signature);
+		return hash;
+	}
+
+	List<Entry> m_entries;
+	HashMap<u64, SizeType> m_indices;
+};
 
 // Reflection mappings utility
-static HashMap<SizeType, WrenForeignMethodFn> s_foreignMethods;
-static HashMap<SizeType, WrenForeignMethodFn> s_foreignConstructors;
-static HashMap<SizeType, WrenFinalizerFn> s_foreignDestructors;
+static ScriptBindingTable<WrenForeignMethodFn> s_foreignMethods;
+static ScriptBindingTable<WrenForeignMethodFn> s_foreignConstructors;
+static ScriptBindingTable<WrenFinalizerFn> s_foreignDestructors;
 
 static HashMap<TypeId, ScriptClassInfo> s_foreignClassRegistry;
 static HashMap<u32, TypeId> s_wrenTypeIdMap;
@@ -80,22 +372,6 @@ static HashMap<u32, TypeId> s_wrenTypeIdMap;
 static HashMap<TypeId, ComponentClassWrapper> s_componentClassWrappers;
 
 // Helper functions and Wren callbacks
-static SizeType GetClassHash(const char* moduleName, const char* className)
-{
-	static std::hash<String> s_strHash;
-	return s_strHash(moduleName)
-		^ s_strHash(className);
-}
-
-static SizeType GetMethodHash(const char* moduleName, const char* className, bool isStatic, const char* signature)
-{
-	static std::hash<String> s_strHash;
-	return s_strHash(moduleName)
-		^ s_strHash(className)
-		^ s_strHash(isStatic ? "s" : "")
-		^ s_strHash(signature);
-}
-
 static WrenForeignMethodFn WrenBindForeignMethod(WrenVM* vm, const char* moduleName, const char* className, bool isStatic, const char* signature)
 {
 	if (std::strcmp(moduleName, "random") == 0)
@@ -103,27 +379,7 @@ static WrenForeignMethodFn WrenBindForeignMethod(WrenVM* vm, const char* moduleN
 	if (std::strcmp(moduleName, "meta") == 0)
 		return nullptr;
 
-	const SizeType hash = GetMethodHash(moduleName, className, isStatic, signature);
-	const auto it = s_foreignMethods.find(hash);
-	if (it == s_foreignMethods.end())
-		return nullptr;
-	return it->second;
-}
-
-static WrenForeignMethodFn WrenAllocate(const SizeType classHash)
-{
-	const auto it = s_foreignConstructors.find(classHash);
-	if (it != s_foreignConstructors.end())
-		return it->second;
-	return nullptr;
-}
-
-static WrenFinalizerFn WrenFinalizer(const SizeType classHash)
-{
-	const auto it = s_foreignDestructors.find(classHash);
-	if (it != s_foreignDestructors.end())
-		return it->second;
-	return nullptr;
+	return s_foreignMethods.Find(moduleName, className, isStatic, signature);
 }
 
 static WrenForeignClassMethods WrenBindForeignClass(WrenVM* vm, const char* moduleName, const char* className)
@@ -135,9 +391,8 @@ static WrenForeignClassMethods WrenBindForeignClass(WrenVM* vm, const char* modu
 	if (std::strcmp(moduleName, "random") == 0) return methods;
 	if (std::strcmp(moduleName, "meta") == 0) return methods;
 
-	const SizeType classHash = GetClassHash(moduleName, className);
-	methods.allocate = WrenAllocate(classHash);
-	methods.finalize = WrenFinalizer(classHash);
+	methods.allocate = s_foreignConstructors.Find(moduleName, className, false, "");
+	methods.finalize = s_foreignDestructors.Find(moduleName, className, false, "");
 
 	return methods;
 }
@@ -151,21 +406,30 @@ static WrenLoadModuleResult WrenLoadModule(WrenVM* vm, const char* name)
 	if (strcmp(name, "random") == 0)
 		return res;
 
-	String moduleName = name;
-	if (s_wrenModulesSource.find(moduleName) == s_wrenModulesSource.end())
+	String filepath;
+	if (!File::Find("[assets]", String(name) + ".wren", filepath))
 	{
-		String filepath;
-		if (!File::Find("[assets]", String(name) + ".wren", filepath))
-		{
-			BX_LOGE("Module '{}' can not be found!", name);
-			return res;
-		}
+		BX_LOGE("Module '{}' can not be found!", name);
+		return res;
+	}
 
-		String moduleSrc = File::ReadTextFile(filepath);
-		s_wrenModulesSource.insert(std::make_pair(moduleName, moduleSrc));
+	// Wren compiles straight from the mapping and releases it once done
+	MappedFile* pFile = new MappedFile(filepath, true);
+	if (!pFile->IsOpen())
+	{
+		delete pFile;
+		BX_LOGE("Module '{}' can not be read!", name);
+		return res;
 	}
 
-	res.source = s_wrenModulesSource[moduleName].c_str();
+	GetModules(vm).insert(name);
+
+	res.source = pFile->GetText();
+	res.userData = pFile;
+	res.onComplete = [](WrenVM* vm, const char* name, WrenLoadModuleResult result)
+	{
+		delete static_cast<MappedFile*>(result.userData);
+	};
 	return res;
 }
 
@@ -192,11 +456,8 @@ static void WrenError(WrenVM* vm, WrenErrorType errorType, const char* module, c
 	s_error = true;
 }
 
-static void CreateVm()
+static WrenVM* NewVm()
 {
-	s_initialized = false;
-	s_error = false;
-
 	WrenConfiguration config;
 	wrenInitConfiguration(&config);
 	config.writeFn = WrenWrite;
@@ -207,8 +468,19 @@ static void CreateVm()
 	config.loadModuleFn = WrenLoadModule;
 	config.initialHeapSize = 1024LL * 1024 * 32;
 	config.minHeapSize = 1024LL * 1024 * 16;
-	config.heapGrowthPercent = 80;
-	s_vm = wrenNewVM(&config);
+	config.heapGrowthPercent = SCRIPT_HEAP_GROWTH_PERCENT;
+	return wrenNewVM(&config);
+}
+
+static void CreateVm()
+{
+	s_initialized = false;
+	s_error = false;
+
+	s_vm = NewVm();
+
+	s_gc = ScriptGcState{};
+	s_gc.next = s_vm->nextGC;
 }
 
 static void DestroyVm()
@@ -230,11 +502,24 @@ static void DestroyVm()
 		s_vm = nullptr;
 	}
 
-	s_wrenModulesSource.clear();
+	// Joins the threads before their VMs go
+	delete s_pWorkerPool;
+	s_pWorkerPool = nullptr;
+
+	for (auto& pWorker : s_workers)
+		wrenFreeVM(pWorker->vm);
+	s_workers.clear();
+	s_nextWorker = 0;
+
+	s_jobSafeClasses.clear();
+	s_commands.clear();
+
+	s_wrenModules.clear();
+	s_profileStack.clear();
 	
-	s_foreignMethods.clear();
-	s_foreignConstructors.clear();
-	s_foreignDestructors.clear();
+	s_foreignMethods.Clear();
+	s_foreignConstructors.Clear();
+	s_foreignDestructors.Clear();
 
 	s_foreignClassRegistry.clear();
 	s_wrenTypeIdMap.clear();
@@ -246,7 +531,8 @@ static void DestroyVm()
 static void WrenCompile(WrenVM* vm, const char* name, const char* src)
 {
 	String moduleName = name;
-	if (s_wrenModulesSource.find(moduleName) == s_wrenModulesSource.end())
+	auto& modules = GetModules(vm);
+	if (modules.find(moduleName) == modules.end())
 	{
 		switch (wrenInterpret(vm, name, src))
 		{
@@ -266,13 +552,28 @@ static void WrenCompile(WrenVM* vm, const char* name, const char* src)
 			break;
 		}
 
-		String moduleSrc = src;
-		s_wrenModulesSource.insert(std::make_pair(moduleName, moduleSrc));
+		modules.insert(moduleName);
 	}
 }
 
+static void WrenCompileFile(WrenVM* vm, const char* name, const String& filename)
+{
+	const auto& modules = GetModules(vm);
+	if (modules.find(name) != modules.end())
+		return;
+
+	MappedFile file(filename, true);
+	if (!file.IsOpen())
+	{
+		BX_LOGE("Wren module {} can not be read from {}!", name, filename);
+		return;
+	}
+
+	WrenCompile(vm, name, file.GetText());
+}
+
 #if defined BX_DEBUG_BUILD || defined BX_EDITOR_BUILD
-#define LOAD_ENGINE_MODULE(ModuleName) { String src = File::ReadTextFile(BX_PATH"/wren/"#ModuleName".wren"); WrenCompile(s_vm, #ModuleName, src.c_str()); }
+#define LOAD_ENGINE_MODULE(vm, ModuleName) { WrenCompileFile(vm, #ModuleName, BX_PATH"/wren/"#ModuleName".wren"); }
 
 #else
 extern "C" {
@@ -286,25 +587,30 @@ extern "C" {
 #include "framework_wren.h"
 }
 
-#define LOAD_ENGINE_MODULE(ModuleName) { WrenCompile(s_vm, #ModuleName, ModuleName##_wren_data); }
+#define LOAD_ENGINE_MODULE(vm, ModuleName) { WrenCompile(vm, #ModuleName, ModuleName##_wren_data); }
 #endif
 
-static void Configure()
+static void CompileModules(WrenVM* vm)
 {
-	LOAD_ENGINE_MODULE(core);
-	LOAD_ENGINE_MODULE(device);
-	LOAD_ENGINE_MODULE(math);
-	LOAD_ENGINE_MODULE(graphics);
-	LOAD_ENGINE_MODULE(physics);
-	LOAD_ENGINE_MODULE(audio);
-	LOAD_ENGINE_MODULE(ecs);
-	LOAD_ENGINE_MODULE(framework);
+	LOAD_ENGINE_MODULE(vm, core);
+	LOAD_ENGINE_MODULE(vm, device);
+	LOAD_ENGINE_MODULE(vm, math);
+	LOAD_ENGINE_MODULE(vm, graphics);
+	LOAD_ENGINE_MODULE(vm, physics);
+	LOAD_ENGINE_MODULE(vm, audio);
+	LOAD_ENGINE_MODULE(vm, ecs);
+	LOAD_ENGINE_MODULE(vm, framework);
 
 	File::FindEach("[assets]", ".wren",
-		[](const String& path, const String& name)
+		[vm](const String& path, const String& name)
 		{
-			WrenCompile(s_vm, name.c_str(), File::ReadTextFile(path).c_str());
+			WrenCompileFile(vm, name.c_str(), path);
 		});
+}
+
+static void Configure()
+{
+	CompileModules(s_vm);
 
 	for (auto& it : s_foreignClassRegistry)
 	{
@@ -333,11 +639,67 @@ static void Configure()
 		s_goNewMethod = wrenMakeCallHandle(s_vm, "new(_)");
 		s_goStartMethod = wrenMakeCallHandle(s_vm, "start()");
 		s_goUpdateMethod = wrenMakeCallHandle(s_vm, "update()");
+		s_fnCallMethod = wrenMakeCallHandle(s_vm, "call()");
 
 		//wrenCall(s_vm, s_configMethod);
 	}
 }
 
+static void CreateWorkers(u32 count)
+{
+	if (count == 0 || !s_initialized || s_error)
+		return;
+
+	PROFILE_FUNCTION();
+
+	Timer timer;
+	timer.Start();
+
+	// The modules run once per VM, top level code included
+	for (u32 i = 0; i < count; ++i)
+	{
+		s_workers.emplace_back(new ScriptWorker());
+		ScriptWorker& worker = *s_workers.back();
+		worker.index = i;
+		worker.vm = NewVm();
+
+		CompileModules(worker.vm);
+
+		worker.newMethod = wrenMakeCallHandle(worker.vm, "new(_)");
+		worker.startMethod = wrenMakeCallHandle(worker.vm, "start()");
+		worker.updateMethod = wrenMakeCallHandle(worker.vm, "update()");
+		worker.callMethod = wrenMakeCallHandle(worker.vm, "call()");
+
+		worker.gc.next = worker.vm->nextGC;
+	}
+
+	s_pWorkerPool = new WorkerPool(count);
+
+	BX_LOGI("Wren created {} worker VMs in {:.2f} ms", count, timer.Elapsed() * 1000.0f);
+}
+
+// In the order they were deferred, the ones of the main thread first. Commands may defer more of them.
+static void FlushCommands()
+{
+	List<ScriptCommand> commands;
+	while (true)
+	{
+		commands.swap(s_commands);
+		for (auto& pWorker : s_workers)
+		{
+			commands.insert(commands.end(), pWorker->commands.begin(), pWorker->commands.end());
+			pWorker->commands.clear();
+		}
+
+		if (commands.empty())
+			break;
+
+		for (const auto& command : commands)
+			command();
+		commands.clear();
+	}
+}
+
 void Script::RegisterApi(BindApiFn bindApi)
 {
 	g_bindApis.emplace_back(bindApi);
@@ -353,6 +715,146 @@ void Script::ClearError()
 	s_error = false;
 }
 
+u32 Script::GetWorkerCount()
+{
+	return static_cast<u32>(s_workers.size());
+}
+
+bool Script::IsOnWorker()
+{
+	return t_pWorker != nullptr;
+}
+
+static void MergeWorkerProfiles()
+{
+	for (auto& pWorker : s_workers)
+	{
+		for (const auto& itr : pWorker->profile)
+		{
+			auto& data = s_profile[itr.first];
+			data.calls += itr.second.calls;
+			data.inclusive += itr.second.inclusive;
+			data.exclusive += itr.second.exclusive;
+			data.allocated += itr.second.allocated;
+			data.collections += itr.second.collections;
+		}
+		pWorker->profile.clear();
+
+		s_workersProfileTime += pWorker->profileTime;
+		pWorker->profileTime = TimeSpan{};
+	}
+}
+
+void Script::RunWorkers(const std::function<void(u32)>& fn)
+{
+	PROFILE_FUNCTION();
+
+	if (!s_workers.empty())
+	{
+		std::mutex doneLock;
+		std::condition_variable doneCondition;
+		SizeType remaining = s_workers.size();
+
+		// One task per VM, so no VM is ever run by two threads at once
+		for (auto& pWorker : s_workers)
+		{
+			ScriptWorker* pTaskWorker = pWorker.get();
+			s_pWorkerPool->Queue(
+				[&fn, &doneLock, &doneCondition, &remaining, pTaskWorker]()
+				{
+					t_pWorker = pTaskWorker;
+					fn(pTaskWorker->index);
+					t_pWorker = nullptr;
+
+					std::lock_guard<std::mutex> lk(doneLock);
+					if (--remaining == 0)
+						doneCondition.notify_one();
+				});
+		}
+
+		std::unique_lock<std::mutex> lk(doneLock);
+		doneCondition.wait(lk, [&remaining]() { return remaining == 0; });
+
+		if (s_profiling)
+			MergeWorkerProfiles();
+	}
+
+	FlushCommands();
+}
+
+void Script::SetProfileMode(ScriptProfileMode mode, u32 interval)
+{
+	s_profileMode = mode;
+	s_profileInterval = interval > 0 ? interval : 1;
+}
+
+ScriptProfileMode Script::GetProfileMode()
+{
+	return s_profileMode;
+}
+
+const HashMap<String, ScriptProfileData>& Script::GetProfile()
+{
+	return s_profile;
+}
+
+void Script::ResetProfile()
+{
+	s_profile.clear();
+}
+
+bool Script::IsProfiling()
+{
+	return s_profiling;
+}
+
+void Script::BeginProfile(WrenVM* vm, const String& name)
+{
+	// Each worker profiles on its own until the parallel update is done
+	List<ScriptProfileFrame>& stack = t_pWorker != nullptr ? t_pWorker->profileStack : s_profileStack;
+
+	ScriptProfileFrame frame;
+	frame.pName = &name;
+	frame.vm = vm;
+	frame.bytesAllocated = vm->bytesAllocated;
+	frame.nextGC = vm->nextGC;
+	frame.start = Clock::now();
+	stack.emplace_back(frame);
+}
+
+void Script::EndProfile()
+{
+	const TimePoint end = Clock::now();
+
+	List<ScriptProfileFrame>& stack = t_pWorker != nullptr ? t_pWorker->profileStack : s_profileStack;
+	if (stack.empty())
+		return;
+
+	const ScriptProfileFrame frame = stack.back();
+	stack.pop_back();
+
+	static const f64 s_toMilliseconds = 1.0 / 1000000.0;
+	const TimeSpan elapsed = std::chrono::duration_cast<TimeSpan>(end - frame.start);
+
+	auto& data = (t_pWorker != nullptr ? t_pWorker->profile : s_profile)[*frame.pName];
+	data.calls++;
+	data.inclusive += elapsed.count() * s_toMilliseconds;
+	data.exclusive += (elapsed - frame.children).count() * s_toMilliseconds;
+
+	// The threshold only moves when the heap is collected
+	if (frame.vm->nextGC != frame.nextGC)
+		data.collections++;
+	else
+		data.allocated += static_cast<i64>(frame.vm->bytesAllocated) - static_cast<i64>(frame.bytesAllocated);
+
+	if (!stack.empty())
+		stack.back().children += elapsed;
+	else if (t_pWorker != nullptr)
+		t_pWorker->profileTime += elapsed;
+	else
+		s_profileTime += elapsed;
+}
+
 void Script::BeginModule(const char* moduleName)
 {
 	s_moduleName = moduleName;
@@ -429,13 +931,10 @@ void Script::RegisterComponentClass(TypeId typeId, const ComponentClassWrapper&
 	s_componentClassWrappers.insert(std::make_pair(typeId, wrapper));
 }
 
-static void GetComponentCallInfo(WrenVM* vm, Entity& entity, ComponentClassWrapper& wrapper)
+// Wrapper of the component class in the slot
+static const ComponentClassWrapper& GetComponentClassWrapper(WrenVM* vm, i32 slot)
 {
-	wrenEnsureSlots(vm, 2);
-	entity = ScriptArg<Entity&>::Get(vm, 0);
-
-	WrenHandle* handle = wrenGetSlotHandle(vm, 1);
-	ObjClass* objClass = wrenGetClass(vm, handle->value);
+	ObjClass* objClass = wrenGetClass(vm, vm->apiStack[slot]);
 
 	auto it = s_wrenTypeIdMap.find(objClass->name->hash);
 	BX_ASSERT(it != s_wrenTypeIdMap.end(), "Class is not registered!");
@@ -443,42 +942,197 @@ static void GetComponentCallInfo(WrenVM* vm, Entity& entity, ComponentClassWrapp
 
 	auto it2 = s_componentClassWrappers.find(typeId);
 	BX_ASSERT(it2 != s_componentClassWrappers.end(), "Component is not registered!");
-	wrapper = it2->second;
+	return it2->second;
+}
+
+static const ComponentClassWrapper& GetComponentCallInfo(WrenVM* vm, Entity& entity)
+{
+	wrenEnsureSlots(vm, 2);
+	entity = ScriptArg<Entity&>::Get(vm, 0);
+
+	return GetComponentClassWrapper(vm, 1);
 }
 
 static void EntityHasComponent(WrenVM* vm)
 {
 	Entity entity;
-	ComponentClassWrapper wrapper;
-	GetComponentCallInfo(vm, entity, wrapper);
+	const auto& wrapper = GetComponentCallInfo(vm, entity);
 	wrapper.hasComponentFn(vm, entity);
 }
 
+static void EntityCreate(WrenVM* vm)
+{
+	if (AbortOnWorker(vm, "Entity.create()"))
+		return;
+
+	ScriptArg<Entity>::Set(vm, 0, EntityManager::CreateEntity());
+}
+
+static void EntityDestroy(WrenVM* vm)
+{
+	const Entity entity = ScriptArg<Entity&>::Get(vm, 0);
+	DeferOnWorker([entity]()
+		{
+			Entity e = entity;
+			if (e.IsValid())
+				e.Destroy();
+		});
+}
+
 static void EntityAddComponent(WrenVM* vm)
 {
+	if (AbortOnWorker(vm, "Entity.addComponent(_)"))
+		return;
+
 	Entity entity;
-	ComponentClassWrapper wrapper;
-	GetComponentCallInfo(vm, entity, wrapper);
+	const auto& wrapper = GetComponentCallInfo(vm, entity);
 	wrapper.addComponentFn(vm, entity);
 }
 
 static void EntityGetComponent(WrenVM* vm)
 {
 	Entity entity;
-	ComponentClassWrapper wrapper;
-	GetComponentCallInfo(vm, entity, wrapper);
+	const auto& wrapper = GetComponentCallInfo(vm, entity);
 	wrapper.getComponentFn(vm, entity);
 }
 
 static void EntityRemoveComponent(WrenVM* vm)
 {
 	Entity entity;
-	ComponentClassWrapper wrapper;
-	GetComponentCallInfo(vm, entity, wrapper);
-	wrapper.removeComponentFn(vm, entity);
+	const auto& wrapper = GetComponentCallInfo(vm, entity);
+	const ComponentClassWrapper* pWrapper = &wrapper;
+	DeferOnWorker([pWrapper, vm, entity]() { pWrapper->removeComponentFn(vm, entity); });
 }
 
-static void RegisterGameObject(WrenVM* vm)
+// Walks the entities that have every component of a set, which are gathered natively when the query is created.
+// The entity and component objects handed to scripts are created once and pointed at the current entity on each step.
+struct EntityQuery
+{
+	List<const ComponentClassWrapper*> wrappers;
+	ComponentMask mask;
+
+	List<Entity> entities;
+	SizeType next = 0;
+
+	// Owned by the VM, the handles keep them alive for as long as the query can still write through them
+	WrenVM* vm = nullptr;
+	ScriptObj* pEntity = nullptr;
+	WrenHandle* pEntityHandle = nullptr;
+	List<ScriptObj*> components;
+	List<WrenHandle*> componentHandles;
+
+	~EntityQuery()
+	{
+		ReleaseEntity();
+		ReleaseComponents();
+	}
+
+	void ReleaseEntity()
+	{
+		if (pEntityHandle != nullptr)
+			wrenReleaseHandle(vm, pEntityHandle);
+		pEntityHandle = nullptr;
+		pEntity = nullptr;
+	}
+
+	void ReleaseComponents()
+	{
+		for (auto pHandle : componentHandles)
+			wrenReleaseHandle(vm, pHandle);
+		componentHandles.clear();
+		components.clear();
+	}
+};
+
+static void ConstructEntityQuery(WrenVM* vm)
+{
+	wrenEnsureSlots(vm, 3);
+
+	void* memory = ScriptArg<void*>::Set(vm, 0, 0, sizeof(ScriptObjVal<EntityQuery>));
+	ScriptObjVal<EntityQuery>* obj = new (memory) ScriptObjVal<EntityQuery>{};
+	EntityQuery* pQuery = new (obj->Ptr()) EntityQuery();
+	pQuery->vm = vm;
+
+	const i32 count = ScriptArg<void*>::GetListCount(vm, 1);
+	pQuery->wrappers.reserve(count);
+	for (i32 i = 0; i < count; ++i)
+	{
+		ScriptArg<void*>::GetListElement(vm, 1, i, 2);
+		const auto& wrapper = GetComponentClassWrapper(vm, 2);
+		pQuery->wrappers.emplace_back(&wrapper);
+		pQuery->mask |= wrapper.mask;
+	}
+
+	EntityQuery& query = *pQuery;
+	EntityManager::ForAll([&query](const Entity& entity)
+		{
+			if (HasMask(Entity(entity).GetComponentMask(), query.mask))
+				query.entities.emplace_back(entity);
+		});
+}
+
+static void FinalizeEntityQuery(void* data)
+{
+	ScriptObj* obj = static_cast<ScriptObj*>(data);
+	obj->~ScriptObj();
+}
+
+static void EntityQueryCount(WrenVM* vm)
+{
+	const auto& query = ScriptArg<const EntityQuery&>::Get(vm, 0);
+	ScriptArg<f64>::Set(vm, 0, static_cast<f64>(query.entities.size()));
+}
+
+static void EntityQueryEntity(WrenVM* vm)
+{
+	auto& query = ScriptArg<EntityQuery&>::Get(vm, 0);
+	query.ReleaseEntity();
+	ScriptArg<Entity>::Set(vm, 0, Entity::Invalid());
+	query.pEntity = static_cast<ScriptObj*>(ScriptArg<void*>::Get(vm, 0));
+	query.pEntityHandle = wrenGetSlotHandle(vm, 0);
+}
+
+static void EntityQueryComponents(WrenVM* vm)
+{
+	wrenEnsureSlots(vm, 2);
+	auto& query = ScriptArg<EntityQuery&>::Get(vm, 0);
+
+	query.ReleaseComponents();
+	ScriptArg<void*>::SetList(vm, 0);
+	for (auto pWrapper : query.wrappers)
+	{
+		query.components.emplace_back(pWrapper->newComponentRefFn(vm, 1));
+		query.componentHandles.emplace_back(wrenGetSlotHandle(vm, 1));
+		ScriptArg<void*>::InsertInList(vm, 0, -1, 1);
+	}
+}
+
+static void EntityQueryNext(WrenVM* vm)
+{
+	auto& query = ScriptArg<EntityQuery&>::Get(vm, 0);
+
+	while (query.next < query.entities.size())
+	{
+		Entity entity = query.entities[query.next++];
+
+		// Earlier steps may have destroyed the entity or removed one of its components
+		if (!entity.IsValid() || !HasMask(entity.GetComponentMask(), query.mask))
+			continue;
+
+		if (query.pEntity != nullptr)
+			*static_cast<Entity*>(query.pEntity->Ptr()) = entity;
+
+		for (SizeType i = 0; i < query.components.size(); ++i)
+			query.wrappers[i]->setComponentRefFn(query.components[i], entity);
+
+		ScriptArg<bool>::Set(vm, 0, true);
+		return;
+	}
+
+	ScriptArg<bool>::Set(vm, 0, false);
+}
+
+static void RegisterGameObjectClass(WrenVM* vm, bool isJobSafe)
 {
 	WrenHandle* classHandle = wrenGetSlotHandle(vm, 1);
 	ObjClass* classObj = wrenGetClass(vm, classHandle->value);
@@ -486,16 +1140,51 @@ static void RegisterGameObject(WrenVM* vm)
 	String className = classObj->name->value;
 	className = className.substr(0, className.find(" "));
 
+	// Worker VMs run the same modules, their classes are only kept to create instances from
+	ScriptWorker* pWorker = FindWorker(vm);
+	if (pWorker != nullptr)
+	{
+		pWorker->classes[className] = classHandle;
+		return;
+	}
+
+	if (isJobSafe)
+		s_jobSafeClasses.insert(className);
+
+	const String newName = className + ".new()";
+
 	GameObjectMetaData metaData
 	{
 		[vm, classHandle]()
 		{
 			wrenSetSlotHandle(vm, 0, classHandle);
 		},
-		[vm](const GameObjectData& data)
+		[vm, newName, className, isJobSafe](const GameObjectData& data)
 		{
-			ScriptArg<const GameObjectData&>::Set(vm, 1, data);
-			auto result = wrenCall(vm, s_goNewMethod);
+			WrenVM* targetVm = vm;
+			WrenHandle* newMethod = s_goNewMethod;
+
+			// Job safe instances are spread over the workers in turn
+			if (isJobSafe && !s_workers.empty())
+			{
+				ScriptWorker& worker = *s_workers[s_nextWorker];
+				s_nextWorker = (s_nextWorker + 1) % static_cast<u32>(s_workers.size());
+
+				auto it = worker.classes.find(className);
+				if (it != worker.classes.end())
+				{
+					targetVm = worker.vm;
+					newMethod = worker.newMethod;
+
+					wrenEnsureSlots(targetVm, 2);
+					wrenSetSlotHandle(targetVm, 0, it->second);
+				}
+			}
+
+			ScriptProfileScope profile(targetVm, newName);
+
+			ScriptArg<const GameObjectData&>::Set(targetVm, 1, data);
+			auto result = wrenCall(targetVm, newMethod);
 			return result == WREN_RESULT_SUCCESS;
 		}
 	};
@@ -503,14 +1192,66 @@ static void RegisterGameObject(WrenVM* vm)
 	GameObject::Register(className, metaData);
 }
 
+static void RegisterGameObject(WrenVM* vm)
+{
+	RegisterGameObjectClass(vm, false);
+}
+
+static void RegisterJobSafeGameObject(WrenVM* vm)
+{
+	RegisterGameObjectClass(vm, true);
+}
+
+// Runs the function once the game objects are done updating, on the main thread
+static void DeferGameObjectCommand(WrenVM* vm)
+{
+	WrenHandle* fnHandle = wrenGetSlotHandle(vm, 1);
+
+	ScriptWorker* pWorker = FindWorker(vm);
+	WrenHandle* callMethod = pWorker != nullptr ? pWorker->callMethod : s_fnCallMethod;
+
+	const ScriptCommand command = [vm, fnHandle, callMethod]()
+	{
+		wrenEnsureSlots(vm, 1);
+		wrenSetSlotHandle(vm, 0, fnHandle);
+		wrenCall(vm, callMethod);
+		wrenReleaseHandle(vm, fnHandle);
+	};
+
+	if (t_pWorker != nullptr)
+		t_pWorker->commands.emplace_back(command);
+	else
+		s_commands.emplace_back(command);
+}
+
 static void GetTypeGameObjectData(WrenVM* vm)
 {
 	wrenEnsureSlots(vm, 0);
 	const auto& data = ScriptArg<const GameObjectData&>::Get(vm, 0);
+
+	ScriptWorker* pWorker = FindWorker(vm);
+	if (pWorker != nullptr)
+	{
+		auto it = pWorker->classes.find(data.className);
+		BX_ASSERT(it != pWorker->classes.end(), "Game object class is not registered!");
+		wrenSetSlotHandle(vm, 0, it->second);
+		return;
+	}
+
 	const auto& metaData = GameObject::GetClassMetaData(data.className);
 	metaData.bindClassFn();
 }
 
+static void LoadGameObjectData(WrenVM* vm)
+{
+	// The prefab cache is not shared with the workers
+	if (AbortOnWorker(vm, "GameObjectData.load(_)"))
+		return;
+
+	const String filepath = ScriptArg<const String&>::Get(vm, 1);
+	ScriptArg<GameObjectData>::Set(vm, 0, GameObjectData::Load(filepath));
+}
+
 static void CreateGameObjectData(WrenVM* vm)
 {
 	wrenEnsureSlots(vm, 1);
@@ -525,6 +1266,9 @@ static void CreateGameObjectData(WrenVM* vm)
 
 static void ConstructGameObjectBase(WrenVM* vm)
 {
+	if (AbortOnWorker(vm, "GameObject.new(_)"))
+		return;
+
 	wrenEnsureSlots(vm, 2);
 
 	const auto& data = ScriptArg<const GameObjectData&>::Get(vm, 1);
@@ -534,6 +1278,15 @@ static void ConstructGameObjectBase(WrenVM* vm)
 	String className = classObj->name->value;
 	className = className.substr(0, className.find(" "));
 
+	auto namesIt = s_gameObjectProfileNames.find(className);
+	if (namesIt == s_gameObjectProfileNames.end())
+		namesIt = s_gameObjectProfileNames.insert(std::make_pair(className, GameObjectProfileNames{ className + ".start()", className + ".update()" })).first;
+	const GameObjectProfileNames* pNames = &namesIt->second;
+
+	ScriptWorker* pWorker = FindWorker(vm);
+	WrenHandle* startMethod = pWorker != nullptr ? pWorker->startMethod : s_goStartMethod;
+	WrenHandle* updateMethod = pWorker != nullptr ? pWorker->updateMethod : s_goUpdateMethod;
+
 	void* memory = ScriptArg<void*>::Set(vm, 0, 0, sizeof(ScriptObjVal<GameObjectBase>));
 	ScriptObjVal<GameObjectBase>* obj = new (memory) ScriptObjVal<GameObjectBase>{};
 
@@ -543,20 +1296,68 @@ static void ConstructGameObjectBase(WrenVM* vm)
 		{
 			wrenSetSlotHandle(vm, 0, objHandle);
 		},
-		[vm, objHandle]()
+		[vm, objHandle, pNames, startMethod]()
 		{
 			//auto fiber = wrenNewFiber(vm, NULL);
 			//wrenSetSlotHandle(vm, 0, objHandle);
 			//wrenCallFunction(vm, fiber, AS_CLOSURE(s_goStartMethod->value), 0);
 
+			ScriptProfileScope profile(vm, pNames->start);
 			wrenSetSlotHandle(vm, 0, objHandle);
-			wrenCall(vm, s_goStartMethod);
+			wrenCall(vm, startMethod);
 		},
-		[vm, objHandle]()
+		[vm, objHandle, pNames, updateMethod]()
 		{
+			ScriptProfileScope profile(vm, pNames->update);
 			wrenSetSlotHandle(vm, 0, objHandle);
-			wrenCall(vm, s_goUpdateMethod);
+			wrenCall(vm, updateMethod);
 		});
+
+	// Other classes created on a worker VM, by a deferred command, update on the main thread
+	if (pWorker != nullptr && s_jobSafeClasses.find(className) != s_jobSafeClasses.end())
+		static_cast<GameObjectBase*>(obj->Ptr())->SetUpdateGroup(pWorker->index + 1);
+}
+
+// Creates an instance of a job safe class on a worker VM the way scenes do, the calling VM only gets its entity.
+// Null for other classes, or without workers, and the script creates the instance itself.
+static void NewGameObjectOnWorker(WrenVM* vm)
+{
+	wrenEnsureSlots(vm, 2);
+	const auto& data = ScriptArg<const GameObjectData&>::Get(vm, 1);
+
+	// Worker VMs create their instances right there, in deferred commands
+	if (FindWorker(vm) != nullptr)
+	{
+		wrenSetSlotNull(vm, 0);
+		return;
+	}
+
+	// The next worker is the one the instance goes to, the class may fail to compile there
+	if (s_workers.empty() || s_jobSafeClasses.find(data.className) == s_jobSafeClasses.end()
+		|| s_workers[s_nextWorker]->classes.find(data.className) == s_workers[s_nextWorker]->classes.end())
+	{
+		wrenSetSlotNull(vm, 0);
+		return;
+	}
+
+	const auto& metaData = GameObject::GetClassMetaData(data.className);
+	if (!metaData.constructFn(data))
+	{
+		const String msg = "Failed to construct game object " + data.className + " on a worker";
+		wrenSetSlotString(vm, 0, msg.c_str());
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+
+	GameObjectBase& gameObj = *Scene::GetCurrent().GetGameObjects().back();
+	gameObj.Initialize(data);
+	ScriptArg<Entity>::Set(vm, 0, gameObj.GetEntity());
+}
+
+static void DestroyGameObjectBase(WrenVM* vm)
+{
+	GameObjectBase* pGameObj = &ScriptArg<GameObjectBase&>::Get(vm, 0);
+	DeferOnWorker([pGameObj]() { pGameObj->Destroy(); });
 }
 
 static void FinalizeGameObjectBase(void* data)
@@ -565,6 +1366,18 @@ static void FinalizeGameObjectBase(void* data)
 	obj->~ScriptObj();
 }
 
+static void FileWriteTextFile(WrenVM* vm)
+{
+	// Two workers could write the same file at once
+	if (AbortOnWorker(vm, "File.writeTextFile(_,_)"))
+		return;
+
+	wrenEnsureSlots(vm, 3);
+	const String filename = ScriptArg<const String&>::Get(vm, 1);
+	const String text = ScriptArg<const String&>::Get(vm, 2);
+	ScriptArg<bool>::Set(vm, 0, File::WriteTextFile(filename, text));
+}
+
 static void BindApi()
 {
 	Script::BeginModule("core");
@@ -588,19 +1401,19 @@ static void BindApi()
 
 		Script::BeginClass("Data");
 		{
-			Script::BindFunction<decltype(&Data::GetBool), &Data::GetBool>(true, "getBool(_,_,_)");
-			Script::BindFunction<decltype(&Data::GetInt), &Data::GetInt>(true, "getInt(_,_,_)");
-			Script::BindFunction<decltype(&Data::GetUInt), &Data::GetUInt>(true, "getUInt(_,_,_)");
-			Script::BindFunction<decltype(&Data::GetFloat), &Data::GetFloat>(true, "getFloat(_,_,_)");
-			Script::BindFunction<decltype(&Data::GetDouble), &Data::GetDouble>(true, "getDouble(_,_,_)");
-			Script::BindFunction<decltype(&Data::GetString), &Data::GetString>(true, "getString(_,_,_)");
-
-			Script::BindFunction<decltype(&Data::SetBool), &Data::SetBool>(true, "setBool(_,_,_)");
-			Script::BindFunction<decltype(&Data::SetInt), &Data::SetInt>(true, "setInt(_,_,_)");
-			Script::BindFunction<decltype(&Data::SetUInt), &Data::SetUInt>(true, "setUInt(_,_,_)");
-			Script::BindFunction<decltype(&Data::SetFloat), &Data::SetFloat>(true, "setFloat(_,_,_)");
-			Script::BindFunction<decltype(&Data::SetDouble), &Data::SetDouble>(true, "setDouble(_,_,_)");
-			Script::BindFunction<decltype(&Data::SetString), &Data::SetString>(true, "setString(_,_,_)");
+			Script::BindCFunction(true, "getBool(_,_,_)", DataAccess<bool, &Data::GetBool>);
+			Script::BindCFunction(true, "getInt(_,_,_)", DataAccess<int, &Data::GetInt>);
+			Script::BindCFunction(true, "getUInt(_,_,_)", DataAccess<unsigned, &Data::GetUInt>);
+			Script::BindCFunction(true, "getFloat(_,_,_)", DataAccess<float, &Data::GetFloat>);
+			Script::BindCFunction(true, "getDouble(_,_,_)", DataAccess<double, &Data::GetDouble>);
+			Script::BindCFunction(true, "getString(_,_,_)", DataAccess<String, &Data::GetString>);
+
+			Script::BindCFunction(true, "setBool(_,_,_)", DataAccess<bool, &Data::SetBool>);
+			Script::BindCFunction(true, "setInt(_,_,_)", DataAccess<int, &Data::SetInt>);
+			Script::BindCFunction(true, "setUInt(_,_,_)", DataAccess<unsigned, &Data::SetUInt>);
+			Script::BindCFunction(true, "setFloat(_,_,_)", DataAccess<float, &Data::SetFloat>);
+			Script::BindCFunction(true, "setDouble(_,_,_)", DataAccess<double, &Data::SetDouble>);
+			Script::BindCFunction(true, "setString(_,_,_)", DataAccess<String, &Data::SetString>);
 		}
 		Script::EndClass();
 
@@ -614,11 +1427,19 @@ static void BindApi()
 		Script::BeginClass("File");
 		{
 			Script::BindFunction<decltype(&File::ReadTextFile), &File::ReadTextFile>(true, "readTextFile(_)");
-			Script::BindFunction<decltype(&File::WriteTextFile), &File::WriteTextFile>(true, "writeTextFile(_,_)");
+			Script::BindCFunction(true, "writeTextFile(_,_)", FileWriteTextFile);
 			Script::BindFunction<decltype(&File::Exists), &File::Exists>(true, "exists(_)");
 		}
 		Script::EndClass();
 
+		Script::BeginClass("Resources");
+		{
+			Script::BindFunction<decltype(&ResourceManager::GetPendingCount), &ResourceManager::GetPendingCount>(true, "pendingCount");
+			Script::BindFunction<decltype(&ResourceManager::IsIdle), &ResourceManager::IsIdle>(true, "isIdle");
+			Script::BindFunction<decltype(&ResourceManager::IsPending), &ResourceManager::IsPending>(true, "isPending(_)");
+		}
+		Script::EndClass();
+
 		//Script::BeginClass<MetaResource>("Resource");
 		//{
 		//	Script::BindCFunction(true, "create(_,_)", ResourceCreate);
@@ -735,9 +1556,9 @@ static void BindApi()
 			Script::BindFunction<decltype(&Input::GetTouchX), &Input::GetTouchX>(true, "getTouchX(_)");
 			Script::BindFunction<decltype(&Input::GetTouchY), &Input::GetTouchY>(true, "getTouchY(_)");
 
-			Script::BindFunction<decltype(&Input::SetPadVibration), &Input::SetPadVibration>(true, "setPadVibration(_,_)");
-			Script::BindFunction<decltype(&Input::SetPadLightbarColor), &Input::SetPadLightbarColor>(true, "setPadLightbarColor(_,_,_)");
-			Script::BindFunction<decltype(&Input::ResetPadLightbarColor), &Input::ResetPadLightbarColor>(true, "resetPadLightbarColor()");
+			Script::BindCFunction(true, "setPadVibration(_,_)", ScriptDeferredInvoke<decltype(&Input::SetPadVibration), &Input::SetPadVibration>::Call);
+			Script::BindCFunction(true, "setPadLightbarColor(_,_,_)", ScriptDeferredInvoke<decltype(&Input::SetPadLightbarColor), &Input::SetPadLightbarColor>::Call);
+			Script::BindCFunction(true, "resetPadLightbarColor()", ScriptDeferredInvoke<decltype(&Input::ResetPadLightbarColor), &Input::ResetPadLightbarColor>::Call);
 		}
 		Script::EndClass();
 
@@ -853,7 +1674,7 @@ static void BindApi()
 		// Disable constructor from wren
 		Script::BeginClass<Entity, EntityId>("Entity");
 		{
-			Script::BindFunction<decltype(&EntityManager::CreateEntity), &EntityManager::CreateEntity>(true, "create()");
+			Script::BindCFunction(true, "create()", EntityCreate);
 
 			Script::BindFunction<decltype(&Entity::Invalid), &Entity::Invalid>(true, "invalid");
 
@@ -864,7 +1685,16 @@ static void BindApi()
 			Script::BindCFunction(false, "addComponent(_)", EntityAddComponent);
 			Script::BindCFunction(false, "getComponent(_)", EntityGetComponent);
 			Script::BindCFunction(false, "removeComponent(_)", EntityRemoveComponent);
-			Script::BindFunction<decltype(&Entity::Destroy), &Entity::Destroy>(false, "destroy()");
+			Script::BindCFunction(false, "destroy()", EntityDestroy);
+		}
+		Script::EndClass();
+
+		Script::BeginClass<EntityQuery>("EntityQueryBase", ConstructEntityQuery, FinalizeEntityQuery);
+		{
+			Script::BindCFunction(false, "count", EntityQueryCount);
+			Script::BindCFunction(false, "entity", EntityQueryEntity);
+			Script::BindCFunction(false, "components", EntityQueryComponents);
+			Script::BindCFunction(false, "next()", EntityQueryNext);
 		}
 		Script::EndClass();
 	}
@@ -982,7 +1812,7 @@ static void BindApi()
 			//Script::BindFunction<decltype(&Graphics::DrawScreen), &Graphics::DrawScreen>(true, "drawScreen(_,_)");
 			//Script::BindFunction<decltype(&Graphics::DrawSkybox), &Graphics::DrawSkybox>(true, "drawSkybox(_,_,_,_)");
 
-			Script::BindFunction<decltype(&Graphics::DebugLine), &Graphics::DebugLine>(true, "debugLine(_,_,_,_)");
+			Script::BindCFunction(true, "debugLine(_,_,_,_)", ScriptDeferredInvoke<decltype(&Graphics::DebugLine), &Graphics::DebugLine>::Call);
 		}
 		Script::EndClass();
 
@@ -1092,14 +1922,14 @@ static void BindApi()
 		{
 			Script::BindCFunction(false, "type", GetTypeGameObjectData);
 			Script::BindCFunction(true, "create(_)", CreateGameObjectData);
-			Script::BindFunction<decltype(&GameObjectData::Load), &GameObjectData::Load>(true, "load(_)");
+			Script::BindCFunction(true, "load(_)", LoadGameObjectData);
 		}
 		Script::EndClass();
 
 		Script::BeginClass<GameObjectBase>("GameObjectBase", ConstructGameObjectBase, FinalizeGameObjectBase);
 		{
 			Script::BindFunction<decltype(&GameObjectBase::Initialize), &GameObjectBase::Initialize>(false, "initialize(_)");			Script::BindFunction<decltype(&GameObjectBase::Initialize), &GameObjectBase::Initialize>(false, "initialize(_)");
-			Script::BindFunction<decltype(&GameObjectBase::Destroy), &GameObjectBase::Destroy>(false, "destroy()");
+			Script::BindCFunction(false, "destroy()", DestroyGameObjectBase);
 			Script::BindFunction<decltype(&GameObjectBase::GetEntity), &GameObjectBase::GetEntity>(false, "entity");
 			Script::BindFunction<decltype(&GameObjectBase::GetName), &GameObjectBase::GetName>(false, "name");
 			Script::BindFunction<decltype(&GameObjectBase::SetName), &GameObjectBase::SetName>(false, "name=(_)");
@@ -1109,6 +1939,9 @@ static void BindApi()
 		Script::BeginClass("GameObject");
 		{
 			Script::BindCFunction(true, "register(_)", RegisterGameObject);
+			Script::BindCFunction(true, "registerJobSafe(_)", RegisterJobSafeGameObject);
+			Script::BindCFunction(true, "defer(_)", DeferGameObjectCommand);
+			Script::BindCFunction(true, "newOnWorker(_)", NewGameObjectOnWorker);
 		}
 		Script::EndClass();
 
@@ -1117,6 +1950,12 @@ static void BindApi()
 		}
 		Script::EndClass();
 
+		Script::BeginClass("SceneStreamer");
+		{
+			Script::BindCFunction(true, "addAnchor(_)", ScriptDeferredInvoke<decltype(&SceneStreamer::AddAnchor), &SceneStreamer::AddAnchor>::Call);
+		}
+		Script::EndClass();
+
 		Script::BeginComponentClass<Animator>("Animator");
 		{
 			Script::BindFunction<decltype(&Animator::GetCurrent), &Animator::GetCurrent>(false, "current");
@@ -1278,20 +2117,17 @@ void Script::SetClass(WrenVM* vm, i32 slot, TypeId typeId)
 
 void Script::RegisterConstructor(SizeType arity, const char* signature, WrenForeignMethodFn func)
 {
-	const SizeType hash = GetClassHash(s_moduleName, s_className);
-	s_foreignConstructors.insert(std::make_pair(hash, func));
+	s_foreignConstructors.Add(s_moduleName, s_className, false, "", func);
 }
 
 void Script::RegisterDestructor(WrenFinalizerFn func)
 {
-	const SizeType hash = GetClassHash(s_moduleName, s_className);
-	s_foreignDestructors.insert(std::make_pair(hash, func));
+	s_foreignDestructors.Add(s_moduleName, s_className, false, "", func);
 }
 
 void Script::RegisterFunction(bool isStatic, const char* signature, WrenForeignMethodFn func)
 {
-	const SizeType hash = GetMethodHash(s_moduleName, s_className, isStatic, signature);
-	s_foreignMethods.insert(std::make_pair(hash, func));
+	s_foreignMethods.Add(s_moduleName, s_className, isStatic, signature, func);
 }
 
 void Script::EnsureSlots(WrenVM* vm, i32 numSlots)
@@ -1364,6 +2200,9 @@ bool Script::Initialize()
 
 	Configure();
 
+	const i32 workerCount = Data::GetInt("Script Workers", 0, DataTarget::SYSTEM);
+	CreateWorkers(static_cast<u32>(Math::Max(workerCount, 0)));
+
 	return true;
 }
 
@@ -1382,6 +2221,21 @@ void Script::Update()
 {
 	PROFILE_FUNCTION();
 
+	static const f64 s_toMilliseconds = 1.0 / 1000000.0;
+	if (s_profiling)
+	{
+		Profiler::SetCounter("Script Calls (ms)", s_profileTime.count() * s_toMilliseconds);
+		if (!s_workers.empty())
+			Profiler::SetCounter("Script Workers Calls (ms)", s_workersProfileTime.count() * s_toMilliseconds);
+	}
+	s_profileTime = TimeSpan{};
+	s_workersProfileTime = TimeSpan{};
+
+	// Decides whether the next frame is profiled
+	s_profileFrame++;
+	s_profiling = s_profileMode == ScriptProfileMode::FULL
+		|| (s_profileMode == ScriptProfileMode::SAMPLED && s_profileFrame % s_profileInterval == 0);
+
 	//if (s_initialized && !s_error)
 	//{
 	//	wrenEnsureSlots(s_vm, 1);
@@ -1402,8 +2256,58 @@ void Script::Render()
 	//}
 }
 
-void Script::CollectGarbage()
+// Returns the milliseconds spent, collectedInFrame tells whether Wren collected by itself since the last call
+static f32 CollectVm(WrenVM* vm, ScriptGcState& gc, f32 budget, bool& collectedInFrame)
+{
+	// The threshold only moves when the heap is collected, so a change means Wren collected during the frame
+	collectedInFrame = vm->nextGC != gc.next;
+
+	const f64 pressure = static_cast<f64>(vm->bytesAllocated) / static_cast<f64>(vm->nextGC);
+	const bool isCollecting = pressure >= SCRIPT_GC_FORCE_RATIO
+		|| (pressure >= SCRIPT_GC_EARLY_RATIO && gc.time <= budget);
+
+	if (isCollecting)
+	{
+		Timer timer;
+		timer.Start();
+		wrenCollectGarbage(vm);
+		gc.time = timer.Elapsed() * 1000.0f;
+	}
+	gc.next = vm->nextGC;
+
+	return isCollecting ? gc.time : 0.0f;
+}
+
+void Script::CollectGarbage(f32 budget)
 {
 	PROFILE_FUNCTION();
-	wrenCollectGarbage(s_vm);
+
+	static const f64 s_toMegabytes = 1.0 / (1024.0 * 1024.0);
+
+	bool collectedInFrame = false;
+	const f32 time = CollectVm(s_vm, s_gc, budget, collectedInFrame);
+
+	Profiler::SetCounter("Script GC (ms)", time);
+	Profiler::SetCounter("Script GC In Frame", collectedInFrame ? 1.0 : 0.0);
+	Profiler::SetCounter("Script Heap (MB)", s_vm->bytesAllocated * s_toMegabytes);
+	Profiler::SetCounter("Script Heap Next GC (MB)", s_vm->nextGC * s_toMegabytes);
+
+	if (s_workers.empty())
+		return;
+
+	// The worker VMs share what is left of the budget, otherwise they collect in the middle of their update
+	f32 workersTime = 0.0f;
+	u32 workersCollectedInFrame = 0;
+	size_t workersHeap = 0;
+	for (auto& pWorker : s_workers)
+	{
+		bool workerCollectedInFrame = false;
+		workersTime += CollectVm(pWorker->vm, pWorker->gc, Math::Max(budget - time - workersTime, 0.0f), workerCollectedInFrame);
+		workersCollectedInFrame += workerCollectedInFrame ? 1 : 0;
+		workersHeap += pWorker->vm->bytesAllocated;
+	}
+
+	Profiler::SetCounter("Script Workers GC (ms)", workersTime);
+	Profiler::SetCounter("Script Workers GC In Frame", workersCollectedInFrame);
+	Profiler::SetCounter("Script Workers Heap (MB)", workersHeap * s_toMegabytes);
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include <bx/engine/core/macros.hpp>
 #include <bx/engine/core/file.hpp>
+#include <bx/engine/core/compression.hpp>
 #include <bx/engine/core/application.hpp>
 #include <bx/engine/containers/hash_map.hpp>
+#include <bx/engine/modules/script.hpp>
 
 #include <cereal/archives/json.hpp>
 #include <cereal/archives/portable_binary.hpp>
@@ -12,9 +14,12 @@
 #include "bx/framework/systems/acoustics.hpp"
 #include "bx/framework/systems/dynamics.hpp"
 #include "bx/framework/systems/renderer.hpp"
+#include "bx/framework/components/transform.hpp"
 
 #include "bx/framework/gameobject.serial.hpp"
+#include "bx/framework/scene_streamer.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <sstream>
@@ -26,36 +31,37 @@ static HashMap<String, GameObjectMetaData> g_gameObjectMetaDataMap;
 
 static Scene g_currentScene;
 
+static HashMap<String, std::shared_ptr<Prefab>> g_prefabCache;
+
 class GameObjectReceiver : public Receiver
 {
 public:
 	void Receive(const EntityDestroyed& ev)
 	{
-		auto& gameObjects = g_currentScene.m_gameObjects;
-		auto it = std::find_if(gameObjects.begin(), gameObjects.end(),
-			[ev](const GameObjectBase* obj)
-			{
-				return obj->GetEntity() == ev.entity;
-			});
-
-		if (it != gameObjects.end())
-			gameObjects.erase(it);
+		g_currentScene.Erase(ev.entity.GetId());
 	}
 };
 
 static GameObjectReceiver g_receiver;
 
-GameObjectData GameObjectData::Load(const String& filepath)
+static GameObjectData ReadGameObjectData(const String& filepath)
 {
 	GameObjectData gameObjData;
 
-	std::ifstream stream(File::GetPath(filepath));
+	MappedFile file(filepath);
+	MemoryStream stream(file.GetData(), file.GetSize());
 	cereal::JSONInputArchive ar(stream);
 	ar(cereal::make_nvp("gameobject", gameObjData));
 
 	return gameObjData;
 }
 
+GameObjectData GameObjectData::Load(const String& filepath)
+{
+	// The components are shared with the cached prefab, they are only ever copied from
+	return Prefab::Load(filepath)->GetData();
+}
+
 void GameObjectData::Save(const String& filepath, const GameObjectData& data)
 {
 	std::ofstream stream(File::GetPath(filepath));
@@ -87,9 +93,10 @@ GameObjectBase::~GameObjectBase()
 
 void GameObjectBase::Initialize(const GameObjectData& data)
 {
+	const auto cmpPtrs = m_entity.GetComponents();
 	for (const auto& cmp : data.components)
 	{
-		for (auto cmpPtr : m_entity.GetComponents())
+		for (auto cmpPtr : cmpPtrs)
 		{
 			if (cmpPtr->GetTypeId() == cmp->GetTypeId())
 			{
@@ -126,9 +133,12 @@ void GameObject::Reload()
 
 void GameObject::Shutdown()
 {
+	SceneStreamer::Close();
+
 	g_gameObjectMetaDataMap.clear();
 	g_gameObjectClasses.clear();
-	g_currentScene.m_gameObjects.clear();
+	g_currentScene.Clear();
+	Prefab::ClearCache();
 	
 	SystemManager::Shutdown();
 	EntityManager::Shutdown();
@@ -174,18 +184,87 @@ GameObjectBase& GameObject::NewFromData(Scene& scene, const GameObjectData& data
 
 GameObjectBase& GameObject::Load(Scene& scene, const String& filepath)
 {
-	GameObjectData gameObjData = GameObjectData::Load(filepath);
+	auto prefab = Prefab::Load(filepath);
+	return *Instantiate(scene, *prefab, 1)[0];
+}
+
+List<GameObjectBase*> GameObject::Instantiate(Scene& scene, const Prefab& prefab, SizeType count, const Mat4* pTransforms)
+{
+	PROFILE_FUNCTION();
+
+	List<GameObjectBase*> gameObjs;
+	if (count == 0)
+		return gameObjs;
+
+	// Growing a pool later on would move components that scripts already point at
+	EntityManager::ReserveEntities(count);
+	for (auto pSerializer : prefab.m_serializers)
+	{
+		if (pSerializer != nullptr && !pSerializer->Reserve(count))
+			BX_LOGW("Instancing prefab {} into a world that already has {} components, they may not fit.", prefab.m_data.name, pSerializer->GetName());
+	}
+
+	// The instances only need the class, the components are copied from the templates below
+	const GameObjectData& data = prefab.m_data;
+	const GameObjectData instanceData{ data.name, data.className, Entity::Invalid() };
+
+	gameObjs.reserve(count);
+	for (SizeType i = 0; i < count; ++i)
+		gameObjs.emplace_back(&NewFromData(scene, instanceData));
+
+	// Every instance of a class has its components in the same order, so the position of each template is
+	// found on the first instance and only checked on the others
+	const SizeType cmpCount = data.components.size();
+	List<SizeType> slots(cmpCount, 0);
+	List<List<ComponentBase*>> dsts(cmpCount);
+	for (auto& dst : dsts)
+		dst.reserve(count);
+
+	for (auto pGameObj : gameObjs)
+	{
+		const auto cmpPtrs = pGameObj->GetEntity().GetComponents();
+		for (SizeType i = 0; i < cmpCount; ++i)
+		{
+			SizeType& slot = slots[i];
+			if (slot >= cmpPtrs.size() || cmpPtrs[slot]->GetTypeId() != prefab.m_typeIds[i])
+			{
+				slot = 0;
+				while (slot < cmpPtrs.size() && cmpPtrs[slot]->GetTypeId() != prefab.m_typeIds[i])
+					++slot;
+			}
+
+			if (slot < cmpPtrs.size())
+				dsts[i].emplace_back(cmpPtrs[slot]);
+		}
+	}
 
-	auto& obj = GameObject::NewFromData(Scene::GetCurrent(), gameObjData);
-	obj.SetName(gameObjData.name);
+	// Copy one component type at a time
+	for (SizeType i = 0; i < cmpCount; ++i)
+	{
+		const ComponentBase& src = *data.components[i];
+		const auto& dst = dsts[i];
+		if (prefab.m_serializers[i] != nullptr)
+		{
+			prefab.m_serializers[i]->Copy(src, dst.data(), dst.size());
+		}
+		else
+		{
+			for (auto cmpPtr : dst)
+				cmpPtr->Copy(src);
+		}
+	}
 
-	SizeType i = 0;
-	for (auto cmpPtr : obj.GetEntity().GetComponents())
+	if (pTransforms != nullptr)
 	{
-		cmpPtr->Copy(*gameObjData.components[i++]);
+		for (SizeType i = 0; i < count; ++i)
+		{
+			const Entity entity = gameObjs[i]->GetEntity();
+			if (entity.HasComponent<Transform>())
+				entity.GetComponent<Transform>().SetMatrix(pTransforms[i]);
+		}
 	}
 
-	return obj;
+	return gameObjs;
 }
 
 void GameObject::Save(const GameObjectBase& gameObj, const String& filepath)
@@ -207,10 +286,20 @@ void GameObject::Save(const GameObjectBase& gameObj, const String& filepath)
 
 GameObjectBase& GameObject::Find(Scene& scene, EntityId entityId)
 {
-	for (auto& gameObj : scene.m_gameObjects)
-		if (gameObj->GetEntity().GetId() == entityId)
-			return *gameObj;
-	BX_FAIL("No game object found for entity ID!");
+	auto it = scene.m_indices.find(entityId);
+	if (it == scene.m_indices.end())
+		BX_FAIL("No game object found for entity ID!");
+
+	return *scene.m_gameObjects[it->second];
+}
+
+GameObjectBase* GameObject::TryFind(Scene& scene, EntityId entityId)
+{
+	auto it = scene.m_indices.find(entityId);
+	if (it == scene.m_indices.end())
+		return nullptr;
+
+	return scene.m_gameObjects[it->second];
 }
 
 GameObjectBase& GameObject::Duplicate(const GameObjectBase& gameObj)
@@ -230,6 +319,574 @@ GameObjectBase& GameObject::Duplicate(const GameObjectBase& gameObj)
 	return copy;
 }
 
+std::shared_ptr<Prefab> Prefab::Load(const String& filename)
+{
+	const u64 lastWrite = File::LastWrite(filename);
+
+	auto it = g_prefabCache.find(filename);
+	if (it != g_prefabCache.end() && it->second->m_lastWrite == lastWrite)
+		return it->second;
+
+	auto prefab = std::make_shared<Prefab>();
+	prefab->m_data = ReadGameObjectData(filename);
+	prefab->m_lastWrite = lastWrite;
+
+	const auto& cmps = prefab->m_data.components;
+	prefab->m_typeIds.reserve(cmps.size());
+	prefab->m_serializers.reserve(cmps.size());
+	for (const auto& cmp : cmps)
+	{
+		prefab->m_typeIds.emplace_back(cmp->GetTypeId());
+		prefab->m_serializers.emplace_back(ComponentSerializerRegistry::Find(cmp->GetTypeId()));
+	}
+
+	g_prefabCache[filename] = prefab;
+	return prefab;
+}
+
+void Prefab::ClearCache()
+{
+	g_prefabCache.clear();
+}
+
+// [SceneBlobHeader][archive]
+// The archive is portable binary: the object table, the block table, then one block per component type with
+// the object index and data of each component of that type. Grouping by type lets loading size every pool
+// once up front and fill it in order, without allocating components on the side to copy from.
+// The archive is compressed as one block when that saves at least SCENE_BLOB_MIN_SAVING.
+constexpr u32 SCENE_BLOB_MAGIC = 0x4E435342; // "BSCN"
+constexpr u32 SCENE_BLOB_VERSION = 1;
+constexpr f32 SCENE_BLOB_MIN_SAVING = 0.1f;
+
+namespace SceneBlobCompression
+{
+	enum : u32
+	{
+		NONE = 0,
+		LZ4
+	};
+}
+
+struct SceneBlobHeader
+{
+	u32 magic = SCENE_BLOB_MAGIC;
+	u32 version = SCENE_BLOB_VERSION;
+	u32 compression = SceneBlobCompression::NONE;
+	u32 padding = 0;
+	u64 dataSize = 0;
+	u64 archiveSize = 0;
+};
+
+// The JSON layout of a scene, without live game objects to back it
+struct SceneData
+{
+	List<GameObjectData> gameObjects;
+};
+
+template<class Archive>
+void serialize(Archive& ar, SceneData& data)
+{
+	ar(cereal::make_nvp("gameObjects", data.gameObjects));
+}
+
+static bool IsSceneBlob(const MappedFile& file)
+{
+	return file.GetSize() >= sizeof(u32)
+		&& memcmp(file.GetData(), &SCENE_BLOB_MAGIC, sizeof(u32)) == 0;
+}
+
+static void WriteSceneArchive(const String& filename, const List<GameObjectData>& gameObjs, std::ostream& stream)
+{
+	// Group components by type in order of appearance
+	List<SceneBlock> blocks;
+	List<List<u32>> blockObjects;
+	List<List<const ComponentBase*>> blockComponents;
+	HashMap<TypeId, SizeType> blockIndices;
+	for (SizeType i = 0; i < gameObjs.size(); ++i)
+	{
+		for (const auto& cmp : gameObjs[i].components)
+		{
+			const TypeId typeId = cmp->GetTypeId();
+			auto it = blockIndices.find(typeId);
+			if (it == blockIndices.end())
+			{
+				const IComponentSerializer* pSerializer = ComponentSerializerRegistry::Find(typeId);
+				if (pSerializer == nullptr)
+				{
+					BX_LOGW("Skipped a component of {} in scene {}, its type isn't registered for serialization.", gameObjs[i].name, filename);
+					continue;
+				}
+
+				it = blockIndices.insert(std::make_pair(typeId, blocks.size())).first;
+				blocks.emplace_back();
+				blocks.back().pSerializer = pSerializer;
+				blockObjects.emplace_back();
+				blockComponents.emplace_back();
+			}
+
+			blocks[it->second].count++;
+			blockObjects[it->second].emplace_back(static_cast<u32>(i));
+			blockComponents[it->second].emplace_back(cmp.get());
+		}
+	}
+
+	cereal::PortableBinaryOutputArchive ar(stream);
+
+	ar(static_cast<u32>(gameObjs.size()));
+	for (const auto& gameObj : gameObjs)
+		ar(gameObj.name, gameObj.className, gameObj.entity);
+
+	ar(static_cast<u32>(blocks.size()));
+	for (const auto& block : blocks)
+		ar(block.pSerializer->GetName(), block.count);
+
+	for (SizeType i = 0; i < blocks.size(); ++i)
+	{
+		ar(cereal::binary_data(blockObjects[i].data(), blockObjects[i].size() * sizeof(u32)));
+		for (const auto pCmp : blockComponents[i])
+			blocks[i].pSerializer->Save(ar, *pCmp);
+	}
+}
+
+static bool SaveSceneBlob(const String& filename, const List<GameObjectData>& gameObjs)
+{
+	std::ostringstream archiveStream(std::ios::binary);
+	WriteSceneArchive(filename, gameObjs, archiveStream);
+	const String archive = archiveStream.str();
+
+	List<u8> compressed(Compression::GetMaxCompressedSize(archive.size()));
+	const SizeType compressedSize = Compression::Compress(reinterpret_cast<const u8*>(archive.data()), archive.size(), compressed.data(), compressed.size());
+	const bool isCompressed = compressedSize > 0 && compressedSize < archive.size() * (1.0f - SCENE_BLOB_MIN_SAVING);
+
+	SceneBlobHeader header;
+	header.compression = isCompressed ? SceneBlobCompression::LZ4 : SceneBlobCompression::NONE;
+	header.dataSize = isCompressed ? compressedSize : archive.size();
+	header.archiveSize = archive.size();
+
+	std::ofstream stream(File::GetPath(filename), std::ios::binary);
+	if (stream.fail())
+		return false;
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(SceneBlobHeader));
+	stream.write(isCompressed ? reinterpret_cast<const char*>(compressed.data()) : archive.data(), static_cast<std::streamsize>(header.dataSize));
+
+	return !stream.fail();
+}
+
+// Returns the archive, either straight from the mapping or decompressed into the buffer
+static const u8* ReadSceneBlob(const String& filename, const MappedFile& file, List<u8>& buffer, SizeType& archiveSize)
+{
+	SceneBlobHeader header;
+	if (file.GetSize() < sizeof(SceneBlobHeader))
+	{
+		BX_LOGE("Scene {} is truncated!", filename);
+		return nullptr;
+	}
+
+	memcpy(&header, file.GetData(), sizeof(SceneBlobHeader));
+	if (header.version != SCENE_BLOB_VERSION || header.compression > SceneBlobCompression::LZ4)
+	{
+		BX_LOGE("Scene {} was written with an incompatible format (version {}), convert it again.", filename, header.version);
+		return nullptr;
+	}
+
+	if (header.dataSize > file.GetSize() - sizeof(SceneBlobHeader))
+	{
+		BX_LOGE("Scene {} is truncated!", filename);
+		return nullptr;
+	}
+
+	const u8* pData = file.GetData() + sizeof(SceneBlobHeader);
+	archiveSize = static_cast<SizeType>(header.archiveSize);
+	if (header.compression == SceneBlobCompression::NONE)
+	{
+		if (header.archiveSize != header.dataSize)
+		{
+			BX_LOGE("Scene {} is corrupt!", filename);
+			return nullptr;
+		}
+		return pData;
+	}
+
+	buffer.resize(archiveSize);
+	if (!Compression::Decompress(pData, static_cast<SizeType>(header.dataSize), buffer.data(), archiveSize))
+	{
+		BX_LOGE("Scene {} is corrupt!", filename);
+		buffer.clear();
+		return nullptr;
+	}
+
+	return buffer.data();
+}
+
+static bool ReadSceneTables(const String& filename, cereal::PortableBinaryInputArchive& ar, SizeType archiveSize, List<GameObjectData>& gameObjs, List<SceneBlock>& blocks)
+{
+	// Every entry takes up at least a byte, which bounds the counts of a corrupt archive
+	u32 objectCount = 0;
+	ar(objectCount);
+	if (objectCount > archiveSize)
+	{
+		BX_LOGE("Scene {} is corrupt!", filename);
+		return false;
+	}
+
+	gameObjs.resize(objectCount);
+	for (auto& gameObj : gameObjs)
+		ar(gameObj.name, gameObj.className, gameObj.entity);
+
+	u32 blockCount = 0;
+	ar(blockCount);
+	if (blockCount > archiveSize)
+	{
+		BX_LOGE("Scene {} is corrupt!", filename);
+		return false;
+	}
+
+	blocks.resize(blockCount);
+	for (auto& block : blocks)
+	{
+		String name;
+		ar(name, block.count);
+		if (block.count > archiveSize / sizeof(u32))
+		{
+			BX_LOGE("Scene {} is corrupt!", filename);
+			return false;
+		}
+
+		// Without a serializer the size of the data is unknown, so there's no skipping it
+		block.pSerializer = ComponentSerializerRegistry::Find(name);
+		if (block.pSerializer == nullptr)
+		{
+			BX_LOGE("Scene {} has components of unknown type {}!", filename, name);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool ReadSceneBlockObjects(const String& filename, cereal::PortableBinaryInputArchive& ar, const SceneBlock& block, SizeType objectCount, List<u32>& objects)
+{
+	objects.resize(block.count);
+	ar(cereal::binary_data(objects.data(), objects.size() * sizeof(u32)));
+
+	for (u32 object : objects)
+	{
+		if (object >= objectCount)
+		{
+			BX_LOGE("Scene {} is corrupt!", filename);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+SceneReader::SceneReader()
+{}
+
+SceneReader::~SceneReader()
+{}
+
+bool SceneReader::Read(const String& filename)
+{
+	m_filename = filename;
+
+	MappedFile file(filename);
+	if (!file.IsOpen() || !IsSceneBlob(file))
+	{
+		BX_LOGE("Scene {} is not a binary scene!", filename);
+		return false;
+	}
+
+	SizeType archiveSize = 0;
+	const u8* pArchive = ReadSceneBlob(filename, file, m_buffer, archiveSize);
+	if (pArchive == nullptr)
+		return false;
+
+	// Outlive the mapping
+	if (pArchive != m_buffer.data())
+		m_buffer.assign(pArchive, pArchive + archiveSize);
+
+	return ReadTables();
+}
+
+bool SceneReader::Read(const String& name, const u8* pArchive, SizeType archiveSize)
+{
+	m_filename = name;
+	m_buffer.assign(pArchive, pArchive + archiveSize);
+
+	return ReadTables();
+}
+
+bool SceneReader::ReadTables()
+{
+	try
+	{
+		m_stream.reset(new MemoryStream(m_buffer.data(), m_buffer.size()));
+		m_archive.reset(new cereal::PortableBinaryInputArchive(*m_stream));
+		return ReadSceneTables(m_filename, *m_archive, m_buffer.size(), m_gameObjs, m_blocks);
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGE("Failed to read scene ({}): {}", m_filename, e.what());
+		return false;
+	}
+}
+
+void SceneReader::Reserve() const
+{
+	// Growing a pool later on would move components that scripts already point at
+	EntityManager::ReserveEntities(m_gameObjs.size());
+	for (const auto& block : m_blocks)
+	{
+		if (!block.pSerializer->Reserve(block.count))
+			BX_LOGW("Loading scene {} into a world that already has {} components, they may not fit.", m_filename, block.pSerializer->GetName());
+	}
+}
+
+SizeType SceneReader::Instantiate(Scene& scene, SizeType count)
+{
+	if (m_isFinished)
+		return 0;
+
+	const SizeType begin = m_objects.size();
+	const SizeType end = std::min(begin + count, m_gameObjs.size());
+
+	// The game objects of this batch start and get drawn before the next one is created
+	if (end < m_gameObjs.size() && !m_isDecoded)
+		DecodeBlocks();
+
+	for (SizeType i = begin; i < end; ++i)
+	{
+		GameObjectBase* pObj = nullptr;
+		try
+		{
+			pObj = &GameObject::NewFromData(scene, m_gameObjs[i]);
+			if (m_isDecoded)
+				pObj->Initialize(m_gameObjs[i]);
+			m_entities.emplace_back(pObj->GetEntity());
+		}
+		catch (std::exception& e)
+		{
+			BX_LOGW("Failed to load gameobject: {}. {}", m_gameObjs[i].className, e.what());
+		}
+		m_objects.emplace_back(pObj);
+
+		// Copied into the entity by now
+		m_gameObjs[i].components.clear();
+	}
+
+	if (m_objects.size() == m_gameObjs.size())
+	{
+		if (!m_isDecoded)
+			LoadBlocks();
+		m_isFinished = true;
+	}
+
+	return end - begin;
+}
+
+// Loads each block into the game object data, to be copied into the entities as they are created
+void SceneReader::DecodeBlocks()
+{
+	try
+	{
+		List<u32> blockObjects;
+		for (const auto& block : m_blocks)
+		{
+			if (!ReadSceneBlockObjects(m_filename, *m_archive, block, m_gameObjs.size(), blockObjects))
+				break;
+
+			for (u32 object : blockObjects)
+				m_gameObjs[object].components.emplace_back(block.pSerializer->Load(*m_archive));
+		}
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to load scene ({}): {}", m_filename, e.what());
+	}
+
+	ReleaseArchive();
+	m_isDecoded = true;
+}
+
+// Loads each block straight into the component pools
+void SceneReader::LoadBlocks()
+{
+	try
+	{
+		List<u32> blockObjects;
+		for (const auto& block : m_blocks)
+		{
+			if (!ReadSceneBlockObjects(m_filename, *m_archive, block, m_objects.size(), blockObjects))
+				break;
+
+			for (u32 object : blockObjects)
+			{
+				if (m_objects[object] != nullptr)
+					block.pSerializer->Load(*m_archive, m_objects[object]->GetEntity());
+				else
+					block.pSerializer->Load(*m_archive);
+			}
+		}
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to load scene ({}): {}", m_filename, e.what());
+	}
+
+	ReleaseArchive();
+}
+
+void SceneReader::ReleaseArchive()
+{
+	m_archive.reset();
+	m_stream.reset();
+	m_buffer = List<u8>();
+}
+
+// Reads a binary scene back into game object data, for converting it to JSON
+static bool ReadSceneBlobData(const String& filename, const MappedFile& file, List<GameObjectData>& gameObjs)
+{
+	List<u8> buffer;
+	SizeType archiveSize = 0;
+	const u8* pArchive = ReadSceneBlob(filename, file, buffer, archiveSize);
+	if (pArchive == nullptr)
+		return false;
+
+	MemoryStream stream(pArchive, archiveSize);
+	cereal::PortableBinaryInputArchive ar(stream);
+
+	List<SceneBlock> blocks;
+	if (!ReadSceneTables(filename, ar, archiveSize, gameObjs, blocks))
+		return false;
+
+	List<u32> blockObjects;
+	for (const auto& block : blocks)
+	{
+		if (!ReadSceneBlockObjects(filename, ar, block, gameObjs.size(), blockObjects))
+			return false;
+
+		for (u32 object : blockObjects)
+			gameObjs[object].components.emplace_back(block.pSerializer->Load(ar));
+	}
+
+	return true;
+}
+
+// Shows up in the log in place of a filename
+static const String SCENE_SNAPSHOT_NAME = "snapshot";
+
+void SceneSnapshot::Capture(const Scene& scene)
+{
+	PROFILE_FUNCTION();
+
+	// Wraps the live components without copying them
+	List<GameObjectData> gameObjs;
+	gameObjs.reserve(scene.m_gameObjects.size());
+	for (const auto pGameObj : scene.m_gameObjects)
+	{
+		if (pGameObj == nullptr)
+			continue;
+
+		gameObjs.emplace_back();
+		GameObjectData& gameObj = gameObjs.back();
+		gameObj.name = pGameObj->GetName();
+		gameObj.className = pGameObj->GetClassName();
+		gameObj.entity = pGameObj->GetEntity();
+
+		const auto cmpPtrs = gameObj.entity.GetComponents();
+		gameObj.components.reserve(cmpPtrs.size());
+		for (const auto cmpPtr : cmpPtrs)
+			gameObj.components.emplace_back(cmpPtr, [](ComponentBase*) {});
+	}
+
+	std::ostringstream stream(std::ios::binary);
+	WriteSceneArchive(SCENE_SNAPSHOT_NAME, gameObjs, stream);
+
+	const String archive = stream.str();
+	m_archive.assign(archive.begin(), archive.end());
+}
+
+bool SceneSnapshot::Restore(Scene& scene) const
+{
+	PROFILE_FUNCTION();
+
+	if (m_archive.empty())
+		return false;
+
+	// The snapshot brings back the same entity IDs, so the current ones go first. Their script objects
+	// live on until the script VM lets go of them, detached so they can't reach the recreated entities.
+	List<Entity> entities;
+	entities.reserve(scene.m_gameObjects.size());
+	for (const auto pGameObj : scene.m_gameObjects)
+	{
+		if (pGameObj == nullptr)
+			continue;
+
+		entities.emplace_back(pGameObj->m_entity);
+		pGameObj->m_entity = Entity::Invalid();
+	}
+
+	for (auto& entity : entities)
+	{
+		if (entity.IsValid())
+			entity.Destroy();
+	}
+	scene.Clear();
+
+	SceneReader reader;
+	if (!reader.Read(SCENE_SNAPSHOT_NAME, m_archive.data(), m_archive.size()))
+		return false;
+
+	reader.Reserve();
+	reader.Instantiate(scene, reader.GetObjectCount());
+	return true;
+}
+
+bool SceneSnapshot::Rollback() const
+{
+	PROFILE_FUNCTION();
+
+	if (m_archive.empty())
+		return false;
+
+	try
+	{
+		MemoryStream stream(m_archive.data(), m_archive.size());
+		cereal::PortableBinaryInputArchive ar(stream);
+
+		List<GameObjectData> gameObjs;
+		List<SceneBlock> blocks;
+		if (!ReadSceneTables(SCENE_SNAPSHOT_NAME, ar, m_archive.size(), gameObjs, blocks))
+			return false;
+
+		List<u32> blockObjects;
+		for (const auto& block : blocks)
+		{
+			if (!ReadSceneBlockObjects(SCENE_SNAPSHOT_NAME, ar, block, gameObjs.size(), blockObjects))
+				return false;
+
+			for (u32 object : blockObjects)
+			{
+				const Entity& entity = gameObjs[object].entity;
+				if (entity.IsValid())
+					block.pSerializer->Load(ar, entity);
+				else
+					block.pSerializer->Load(ar);
+			}
+		}
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to roll back scene: {}", e.what());
+		return false;
+	}
+
+	return true;
+}
+
 void Scene::Create(const String& filename)
 {
 	Scene scene;
@@ -254,13 +911,23 @@ void Scene::Load(Scene& scene, const String& filename)
 		return;
 	}
 
-	scene.m_gameObjects.clear();
-	scene.m_pendingAdded.clear();
-	scene.m_pendingRemoved.clear();
+	scene.Clear();
 
 	try
 	{
-		std::ifstream stream(File::GetPath(filename));
+		MappedFile file(filename);
+		if (IsSceneBlob(file))
+		{
+			SceneReader reader;
+			if (reader.Read(filename))
+			{
+				reader.Reserve();
+				reader.Instantiate(scene, reader.GetObjectCount());
+			}
+			return;
+		}
+
+		MemoryStream stream(file.GetData(), file.GetSize());
 		cereal::JSONInputArchive ar(stream);
 		ar(cereal::make_nvp("scene", scene));
 	}
@@ -284,6 +951,83 @@ void Scene::Save(const Scene& scene, const String& filename)
 	}
 }
 
+bool Scene::Convert(const String& srcFilename, const String& dstFilename)
+{
+	MappedFile file(srcFilename);
+	if (!file.IsOpen())
+	{
+		BX_LOGW("Failed to convert non-existent scene: {}", srcFilename);
+		return false;
+	}
+
+	SceneData data;
+	if (!Read(srcFilename, data.gameObjects))
+		return false;
+
+	if (!IsSceneBlob(file))
+		return WriteBinary(dstFilename, data.gameObjects);
+
+	try
+	{
+		std::ofstream stream(File::GetPath(dstFilename));
+		{
+			cereal::JSONOutputArchive ar(stream);
+			ar(cereal::make_nvp("scene", data));
+		}
+		return !stream.fail();
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to convert scene ({}): {}", srcFilename, e.what());
+		return false;
+	}
+}
+
+bool Scene::Read(const String& filename, List<GameObjectData>& gameObjs)
+{
+	MappedFile file(filename);
+	if (!file.IsOpen())
+	{
+		BX_LOGW("Failed to read non-existent scene: {}", filename);
+		return false;
+	}
+
+	try
+	{
+		if (IsSceneBlob(file))
+			return ReadSceneBlobData(filename, file, gameObjs);
+
+		SceneData data;
+		MemoryStream stream(file.GetData(), file.GetSize());
+		cereal::JSONInputArchive ar(stream);
+		ar(cereal::make_nvp("scene", data));
+		gameObjs = std::move(data.gameObjects);
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to read scene ({}): {}", filename, e.what());
+		return false;
+	}
+
+	return true;
+}
+
+bool Scene::WriteBinary(const String& filename, const List<GameObjectData>& gameObjs)
+{
+	if (!SaveSceneBlob(filename, gameObjs))
+	{
+		BX_LOGW("Failed to write binary scene: {}", filename);
+		return false;
+	}
+
+	return true;
+}
+
+String Scene::GetBinaryFilename(const String& filename)
+{
+	return File::RemoveExt(filename) + ".bscene";
+}
+
 Scene& Scene::GetCurrent()
 {
 	return g_currentScene;
@@ -292,24 +1036,129 @@ Scene& Scene::GetCurrent()
 void Scene::Update()
 {
 	// Ensure all gameobjects are started before update
-	List<GameObjectBase*> added = m_pendingAdded;
+	List<EntityId> added = m_pendingAdded;
 	while (!added.empty())
 	{
 		m_pendingAdded.clear();
 
-		// Start game objects
-		for (auto& go : added)
-			go->Start();
+		// Start game objects, skipping the ones destroyed before they got to start
+		for (auto entityId : added)
+		{
+			auto it = m_indices.find(entityId);
+			if (it != m_indices.end())
+				m_gameObjects[it->second]->Start();
+		}
 
 		added = m_pendingAdded;
 	}
 
-	// Update game objects
-	for (const auto& go : m_gameObjects)
-		go->Update();
+	// Update game objects, the ones added meanwhile wait for the next frame
+	m_isUpdating = true;
+	const u32 workerCount = Script::GetWorkerCount();
+	m_updateGroups.resize(workerCount);
+	for (auto& group : m_updateGroups)
+		group.clear();
+
+	const SizeType count = m_gameObjects.size();
+	for (SizeType i = 0; i < count; ++i)
+	{
+		GameObjectBase* pGameObj = m_gameObjects[i];
+		if (pGameObj == nullptr)
+			continue;
+
+		const u32 group = pGameObj->GetUpdateGroup();
+		if (group == 0 || group > workerCount)
+			pGameObj->Update();
+		else
+			m_updateGroups[group - 1].emplace_back(pGameObj);
+	}
+
+	// Then the groups of job safe game objects, each on the worker that owns their script VM.
+	// What they defer, like destroying game objects, runs once they are all done.
+	Script::RunWorkers(
+		[this](u32 worker)
+		{
+			// Skips the ones destroyed by the main thread update, the scene doesn't change while in here
+			for (GameObjectBase* pGameObj : m_updateGroups[worker])
+			{
+				if (m_indices.find(pGameObj->GetEntity().GetId()) != m_indices.end())
+					pGameObj->Update();
+			}
+		});
+	m_isUpdating = false;
+	FillHoles();
 
 	// Remove pending objects
-	for (const auto& go : m_pendingRemoved)
-		go->GetEntity().Destroy();
+	for (auto& entity : m_pendingRemoved)
+	{
+		if (entity.IsValid())
+			entity.Destroy();
+	}
+	m_pendingRemoved.clear();
+}
+
+void Scene::Add(GameObjectBase* gameObj)
+{
+	const EntityId entityId = gameObj->GetEntity().GetId();
+	m_indices[entityId] = m_gameObjects.size();
+	m_gameObjects.emplace_back(gameObj);
+	m_pendingAdded.emplace_back(entityId);
+}
+
+void Scene::Remove(GameObjectBase* gameObj)
+{
+	// Destroying twice is harmless
+	const Entity entity = gameObj->GetEntity();
+	if (m_indices.find(entity.GetId()) == m_indices.end())
+		return;
+
+	m_pendingRemoved.emplace_back(entity);
+	Erase(entity.GetId());
+}
+
+void Scene::Erase(EntityId entityId)
+{
+	auto it = m_indices.find(entityId);
+	if (it == m_indices.end())
+		return;
+
+	const SizeType index = it->second;
+	m_indices.erase(it);
+
+	if (m_isUpdating)
+	{
+		m_gameObjects[index] = nullptr;
+		m_holes.emplace_back(index);
+		return;
+	}
+
+	GameObjectBase* pLast = m_gameObjects.back();
+	m_gameObjects[index] = pLast;
+	m_gameObjects.pop_back();
+	if (index < m_gameObjects.size())
+		m_indices[pLast->GetEntity().GetId()] = index;
+}
+
+void Scene::FillHoles()
+{
+	// From the back, so the last game object is never a hole itself
+	std::sort(m_holes.begin(), m_holes.end(), std::greater<SizeType>());
+	for (SizeType index : m_holes)
+	{
+		GameObjectBase* pLast = m_gameObjects.back();
+		m_gameObjects[index] = pLast;
+		m_gameObjects.pop_back();
+		if (index < m_gameObjects.size())
+			m_indices[pLast->GetEntity().GetId()] = index;
+	}
+	m_holes.clear();
+}
+
+void Scene::Clear()
+{
+	m_gameObjects.clear();
+	m_pendingAdded.clear();
 	m_pendingRemoved.clear();
+	m_indices.clear();
+	m_holes.clear();
 }
\ No newline at end of file
@@ -26,20 +26,42 @@ bool Resource<Animation>::Save(const String& filename, const Animation& data)
 }
 
 template<>
-bool Resource<Animation>::Load(const String& filename, Animation& data)
+bool Resource<Animation>::Decode(const String& filename, Animation& data)
 {
     // Deserialize data
-    std::ifstream stream(File::GetPath(filename), std::ios::binary);
-    if (stream.fail())
+    MappedFile file(filename);
+    if (!file.IsOpen())
         return false;
 
+    MemoryStream stream(file.GetData(), file.GetSize());
     cereal::PortableBinaryInputArchive archive(stream);
     archive(cereal::make_nvp("animation", data));
 
     return true;
 }
 
+template<>
+bool Resource<Animation>::Finalize(const String& filename, Animation& data)
+{
+    return true;
+}
+
 template<>
 void Resource<Animation>::Unload(const Animation& data)
 {
+}
+
+template<>
+ResourceMemory Resource<Animation>::Measure(const Animation& data)
+{
+    ResourceMemory memory;
+    memory.cpu = sizeof(Animation);
+    for (const auto& channel : data.m_channels)
+    {
+        memory.cpu += sizeof(String) + sizeof(Animation::Keyframes)
+            + channel.second.positionKeys.capacity() * sizeof(Animation::PositionKey)
+            + channel.second.rotationKeys.capacity() * sizeof(Animation::RotationKey)
+            + channel.second.scaleKeys.capacity() * sizeof(Animation::ScaleKey);
+    }
+    return memory;
 }
\ No newline at end of file
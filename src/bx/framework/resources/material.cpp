@@ -10,23 +10,49 @@
 #include <fstream>
 #include <sstream>
 
-void Material::BuildPipeline()
+void Material::DestroyPipelines() const
 {
-    if (m_pipeline != INVALID_GRAPHICS_HANDLE)
+    for (auto& pipeline : m_pipelines)
     {
-        m_pipeline = INVALID_GRAPHICS_HANDLE;
-        Graphics::DestroyPipeline(m_pipeline);
+        if (pipeline != INVALID_GRAPHICS_HANDLE)
+        {
+            Graphics::DestroyPipeline(pipeline);
+            pipeline = INVALID_GRAPHICS_HANDLE;
+        }
     }
+}
+
+void Material::BuildPipeline()
+{
+    DestroyPipelines();
 
     if (m_resources != INVALID_GRAPHICS_HANDLE)
     {
-        m_resources = INVALID_GRAPHICS_HANDLE;
         Graphics::DestroyResourceBinding(m_resources);
+        m_resources = INVALID_GRAPHICS_HANDLE;
     }
 
     if (!m_shader)
         return;
 
+    ResourceBindingElement resourceElems[] =
+    {
+        ResourceBindingElement { ShaderType::PIXEL, "Albedo", 1, ResourceBindingType::TEXTURE, ResourceBindingAccess::DYNAMIC }
+    };
+
+    ResourceBindingInfo resourceBindingInfo;
+    resourceBindingInfo.resources = resourceElems;
+    resourceBindingInfo.numResources = 1;
+
+    m_resources = Graphics::CreateResourceBinding(resourceBindingInfo);
+}
+
+GraphicsHandle Material::GetPipeline(MeshVertexLayout layout) const
+{
+    auto& pipeline = m_pipelines[layout];
+    if (pipeline != INVALID_GRAPHICS_HANDLE || !m_shader)
+        return pipeline;
+
     const auto& shaderData = m_shader.GetData();
 
     // Build graphic components
@@ -40,35 +66,15 @@ void Material::BuildPipeline()
     pipelineInfo.faceCull = PipelineFaceCull::CCW;
     pipelineInfo.depthEnable = true;
 
-    LayoutElement layoutElems[] =
-    {
-        LayoutElement { 0, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
-        LayoutElement { 1, 0, 4, GraphicsValueType::FLOAT32, false, 0, 0 },
-        LayoutElement { 2, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
-        LayoutElement { 3, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
-        LayoutElement { 4, 0, 2, GraphicsValueType::FLOAT32, false, 0, 0 },
-        LayoutElement { 5, 0, 4, GraphicsValueType::INT32, false, 0, 0 },
-        LayoutElement { 6, 0, 4, GraphicsValueType::FLOAT32, false, 0, 0 }
-    };
-
-    pipelineInfo.layoutElements = layoutElems;
-    pipelineInfo.numElements = 7;
+    const auto& layoutElems = Mesh::GetLayoutElements(layout);
+    pipelineInfo.layoutElements = layoutElems.data();
+    pipelineInfo.numElements = static_cast<u32>(layoutElems.size());
 
     pipelineInfo.vertShader = shaderData.GetVertex();
     pipelineInfo.pixelShader = shaderData.GetPixel();
 
-    m_pipeline = Graphics::CreatePipeline(pipelineInfo);
-
-    ResourceBindingElement resourceElems[] =
-    {
-        ResourceBindingElement { ShaderType::PIXEL, "Albedo", 1, ResourceBindingType::TEXTURE, ResourceBindingAccess::DYNAMIC }
-    };
-
-    ResourceBindingInfo resourceBindingInfo;
-    resourceBindingInfo.resources = resourceElems;
-    resourceBindingInfo.numResources = 1;
-
-    m_resources = Graphics::CreateResourceBinding(resourceBindingInfo);
+    pipeline = Graphics::CreatePipeline(pipelineInfo);
+    return pipeline;
 }
 
 template<>
@@ -86,13 +92,22 @@ bool Resource<Material>::Save(const String& filename, const Material& data)
 }
 
 template<>
-bool Resource<Material>::Load(const String& filename, Material& data)
+bool Resource<Material>::Decode(const String& filename, Material& data)
+{
+    // Materials pull in their shader and textures while deserializing,
+    // which touches other databases so all of it happens in Finalize
+    return File::Exists(filename);
+}
+
+template<>
+bool Resource<Material>::Finalize(const String& filename, Material& data)
 {
     // Deserialize data
-    std::ifstream stream(File::GetPath(filename));
-    if (stream.fail())
+    MappedFile file(filename);
+    if (!file.IsOpen())
         return false;
 
+    MemoryStream stream(file.GetData(), file.GetSize());
     cereal::JSONInputArchive archive(stream);
     archive(cereal::make_nvp("material", data));
 
@@ -103,5 +118,14 @@ bool Resource<Material>::Load(const String& filename, Material& data)
 template<>
 void Resource<Material>::Unload(const Material& data)
 {
-    Graphics::DestroyPipeline(data.m_pipeline);
+    data.DestroyPipelines();
+}
+
+template<>
+ResourceMemory Resource<Material>::Measure(const Material& data)
+{
+    // The shader and textures are accounted for by their own types
+    ResourceMemory memory;
+    memory.cpu = sizeof(Material) + data.m_textures.size() * (sizeof(String) + sizeof(Resource<Texture>));
+    return memory;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "bx/framework/resources/mesh.serial.hpp"
 
 #include <bx/engine/core/file.hpp>
+#include <bx/engine/core/compression.hpp>
 #include <bx/engine/modules/graphics.hpp>
 
 #include <cereal/archives/json.hpp>
@@ -10,60 +11,126 @@
 #include <fstream>
 #include <sstream>
 
-template<>
-bool Resource<Mesh>::Save(const String& filename, const Mesh& data)
+// Mesh blob layout, every section starts on a MESH_BLOB_ALIGNMENT boundary:
+// [MeshBlobHeader][Submesh * submeshCount][vertex * vertexCount][u32 * indexCount]
+// The vertex section is already interleaved in the mesh vertex layout and goes to the GPU untouched.
+// Data is stored in native (little endian) byte order.
+// Compressed blobs store everything after the header as one block, the offsets refer to the decompressed blob.
+constexpr u32 MESH_BLOB_MAGIC = 0x48534D42; // "BMSH"
+constexpr u32 MESH_BLOB_VERSION = 3;
+// Version 2 only differs in always being uncompressed
+constexpr u32 MESH_BLOB_MIN_VERSION = 2;
+constexpr u64 MESH_BLOB_ALIGNMENT = 16;
+// Compression has to save at least this fraction of the size, otherwise loading straight from the mapping wins
+constexpr f32 MESH_BLOB_MIN_SAVING = 0.1f;
+
+namespace MeshBlobCompression
 {
-    // TODO: Use some sort of compression (research needs to be done)
+    enum : u32
+    {
+        NONE = 0,
+        LZ4
+    };
+}
 
-    // Serialize data
-    std::ofstream stream(File::GetPath(filename), std::ios::binary);
-    if (stream.fail())
+struct MeshBlobHeader
+{
+    u32 magic = MESH_BLOB_MAGIC;
+    u32 version = MESH_BLOB_VERSION;
+    u32 layout = MeshVertexLayout::STANDARD;
+    u32 vertexStride = 0;
+    u32 vertexCount = 0;
+    u32 indexCount = 0;
+    u32 submeshCount = 0;
+    u32 compression = MeshBlobCompression::NONE;
+    u64 submeshOffset = 0;
+    u64 vertexOffset = 0;
+    u64 indexOffset = 0;
+    Box3 bounds;
+    Mat4 transform;
+};
+
+static u64 AlignBlobOffset(u64 offset)
+{
+    return (offset + MESH_BLOB_ALIGNMENT - 1) & ~(MESH_BLOB_ALIGNMENT - 1);
+}
+
+static bool IsMeshBlob(const MappedFile& file)
+{
+    return file.GetSize() >= sizeof(u32)
+        && memcmp(file.GetData(), &MESH_BLOB_MAGIC, sizeof(u32)) == 0;
+}
+
+static bool ReadBlobHeader(const String& filename, const MappedFile& file, MeshBlobHeader& header)
+{
+    if (!IsMeshBlob(file) || file.GetSize() < sizeof(MeshBlobHeader))
+    {
+        BX_LOGE("Mesh {} is not a mesh blob!", filename);
         return false;
+    }
 
-    cereal::PortableBinaryOutputArchive archive(stream);
-    archive(cereal::make_nvp("mesh", data));
+    memcpy(&header, file.GetData(), sizeof(MeshBlobHeader));
+    if (header.version < MESH_BLOB_MIN_VERSION || header.version > MESH_BLOB_VERSION
+        || header.compression > MeshBlobCompression::LZ4
+        || header.layout >= MESH_VERTEX_LAYOUT_COUNT
+        || header.vertexStride != Mesh::GetVertexStride(header.layout))
+    {
+        BX_LOGE("Mesh {} was written with an incompatible format (version {}), re-import it.", filename, header.version);
+        return false;
+    }
+
+    // Decompression checks the size of compressed blobs
+    const u64 submeshEnd = header.submeshOffset + u64(header.submeshCount) * sizeof(Mesh::Submesh);
+    const u64 vertexEnd = header.vertexOffset + u64(header.vertexCount) * header.vertexStride;
+    const u64 indexEnd = header.indexOffset + u64(header.indexCount) * sizeof(u32);
+    const u64 blobSize = header.compression == MeshBlobCompression::NONE ? file.GetSize() : indexEnd;
+    if (submeshEnd > blobSize || vertexEnd > blobSize || indexEnd > blobSize
+        || header.submeshOffset < sizeof(MeshBlobHeader) || header.submeshOffset > file.GetSize())
+    {
+        BX_LOGE("Mesh {} is truncated!", filename);
+        return false;
+    }
 
     return true;
 }
 
-template<>
-bool Resource<Mesh>::Load(const String& filename, Mesh& data)
+// Returns the whole blob with every section at its offset, either the mapping itself or decompressed into the buffer
+static const u8* ReadBlob(const String& filename, const MappedFile& file, MeshBlobHeader& header, List<u8>& buffer)
 {
-    // Deserialize data
-    std::ifstream stream(File::GetPath(filename), std::ios::binary);
-    if (stream.fail())
-        return false;
+    if (!ReadBlobHeader(filename, file, header))
+        return nullptr;
 
-    cereal::PortableBinaryInputArchive archive(stream);
-    archive(cereal::make_nvp("mesh", data));
+    if (header.compression == MeshBlobCompression::NONE)
+        return file.GetData();
 
-    // Build graphic components
-    List<Mesh::Vertex> vertices;
-    vertices.resize(data.m_vertices.size());
+    const SizeType blobSize = static_cast<SizeType>(header.indexOffset + u64(header.indexCount) * sizeof(u32));
+    const SizeType payloadOffset = static_cast<SizeType>(header.submeshOffset);
 
-    for (SizeType i = 0; i < vertices.size(); i++)
+    buffer.resize(blobSize);
+    memcpy(buffer.data(), file.GetData(), sizeof(MeshBlobHeader));
+    if (!Compression::Decompress(file.GetData() + payloadOffset, file.GetSize() - payloadOffset, buffer.data() + payloadOffset, blobSize - payloadOffset))
     {
-        auto& v = vertices[i];
-        v.position = data.m_vertices[i];
-        v.color = data.m_colors[i];
-        v.normal = data.m_normals[i];
-        v.tangent = data.m_tangents[i];
-        v.uv = data.m_uvs[i];
-        v.bones = data.m_bones[i];
-        v.weights = data.m_weights[i];
+        BX_LOGE("Mesh {} is corrupt!", filename);
+        buffer.clear();
+        return nullptr;
     }
 
+    return buffer.data();
+}
+
+static void CreateMeshBuffers(u32 stride, u32 vertexCount, u32 indexCount, const void* pVertices, const void* pIndices, GraphicsHandle& vbuffers, GraphicsHandle& ibuffer)
+{
     BufferInfo vbInfo;
-    vbInfo.strideBytes = sizeof(Mesh::Vertex);
+    vbInfo.strideBytes = stride;
     vbInfo.type = BufferType::VERTEX_BUFFER;
     vbInfo.usage = BufferUsage::IMMUTABLE;
     vbInfo.access = BufferAccess::READ;
 
     BufferData vbData;
-    vbData.pData = vertices.data();
-    vbData.dataSize = static_cast<u32>(vertices.size() * sizeof(Mesh::Vertex));
+    vbData.pData = pVertices;
+    vbData.dataSize = vertexCount * stride;
 
-    data.m_vbuffers = Graphics::CreateBuffer(vbInfo, vbData);
+    vbuffers = Graphics::CreateBuffer(vbInfo, vbData);
 
     BufferInfo ibInfo;
     ibInfo.type = BufferType::INDEX_BUFFER;
@@ -71,10 +138,553 @@ bool Resource<Mesh>::Load(const String& filename, Mesh& data)
     ibInfo.access = BufferAccess::READ;
 
     BufferData ibData;
-    ibData.pData = data.m_triangles.data();
-    ibData.dataSize = static_cast<u32>(data.m_triangles.size() * sizeof(i32));
+    ibData.pData = pIndices;
+    ibData.dataSize = static_cast<u32>(indexCount * sizeof(u32));
+
+    ibuffer = Graphics::CreateBuffer(ibInfo, ibData);
+}
+
+// Quantization helpers ---------------------------------------------------------
+
+static u32 PackUnorm8x4(const Vec4& v)
+{
+    u32 packed = 0;
+    for (i32 i = 0; i < 4; i++)
+    {
+        const u32 c = static_cast<u32>(Math::Clamp(v[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        packed |= c << (i * 8);
+    }
+    return packed;
+}
 
-    data.m_ibuffer = Graphics::CreateBuffer(ibInfo, ibData);
+static Vec4 UnpackUnorm8x4(u32 packed)
+{
+    Vec4 v;
+    for (i32 i = 0; i < 4; i++)
+        v[i] = static_cast<f32>((packed >> (i * 8)) & 0xFF) / 255.0f;
+    return v;
+}
+
+// Component order matches GL_INT_2_10_10_10_REV, x lives in the low bits
+static u32 PackSnorm10x3(const Vec3& v)
+{
+    u32 packed = 0;
+    for (i32 i = 0; i < 3; i++)
+    {
+        const f32 c = Math::Clamp(v[i], -1.0f, 1.0f) * 511.0f;
+        const i32 q = static_cast<i32>(c < 0.0f ? c - 0.5f : c + 0.5f);
+        packed |= (static_cast<u32>(q) & 0x3FF) << (i * 10);
+    }
+    return packed;
+}
+
+static Vec3 UnpackSnorm10x3(u32 packed)
+{
+    Vec3 v;
+    for (i32 i = 0; i < 3; i++)
+    {
+        // Shift the 10 bit value to the top to sign extend it
+        const i32 q = static_cast<i32>(((packed >> (i * 10)) & 0x3FF) << 22) >> 22;
+        v[i] = Math::Max(static_cast<f32>(q) / 511.0f, -1.0f);
+    }
+    return v;
+}
+
+static u16 FloatToHalf(f32 value)
+{
+    u32 bits;
+    memcpy(&bits, &value, sizeof(u32));
+
+    const u32 sign = (bits >> 16) & 0x8000;
+    const u32 rawExponent = (bits >> 23) & 0xFF;
+    const i32 exponent = static_cast<i32>(rawExponent) - 127 + 15;
+    u32 mantissa = bits & 0x7FFFFF;
+
+    // Inf and NaN
+    if (rawExponent == 0xFF)
+        return static_cast<u16>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+    // Overflow
+    if (exponent >= 31)
+        return static_cast<u16>(sign | 0x7C00);
+
+    // Denormals and underflow
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return static_cast<u16>(sign);
+
+        mantissa |= 0x800000;
+        const u32 shift = static_cast<u32>(14 - exponent);
+        u32 half = mantissa >> shift;
+        const u32 rem = mantissa & ((1u << shift) - 1);
+        const u32 halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1)))
+            half++;
+        return static_cast<u16>(sign | half);
+    }
+
+    // Round to nearest even, a carry into the exponent is intended
+    u32 half = sign | (static_cast<u32>(exponent) << 10) | (mantissa >> 13);
+    const u32 rem = mantissa & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+        half++;
+    return static_cast<u16>(half);
+}
+
+static f32 HalfToFloat(u16 half)
+{
+    const u32 sign = static_cast<u32>(half & 0x8000) << 16;
+    u32 exponent = (half >> 10) & 0x1F;
+    u32 mantissa = half & 0x3FF;
+
+    u32 bits;
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Normalize the denormal
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            mantissa &= 0x3FF;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    }
+    else if (exponent == 31)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    f32 value;
+    memcpy(&value, &bits, sizeof(f32));
+    return value;
+}
+
+// Weights are renormalized so the quantized values still sum up to one
+static void PackWeights(const Vec4& weights, u8* pOut)
+{
+    f32 sum = 0.0f;
+    for (i32 i = 0; i < 4; i++)
+        sum += Math::Max(weights[i], 0.0f);
+
+    if (sum <= 0.0f)
+    {
+        memset(pOut, 0, 4);
+        return;
+    }
+
+    i32 total = 0;
+    i32 largest = 0;
+    for (i32 i = 0; i < 4; i++)
+    {
+        const f32 w = Math::Max(weights[i], 0.0f) / sum;
+        pOut[i] = static_cast<u8>(w * 255.0f + 0.5f);
+        total += pOut[i];
+        if (pOut[i] > pOut[largest])
+            largest = i;
+    }
+    pOut[largest] = static_cast<u8>(pOut[largest] + (255 - total));
+}
+
+static i8 PackBoneIndex(i32 bone)
+{
+    BX_ASSERT(bone >= -1 && bone <= 127, "Bone index out of range for the compact skinned vertex layout!");
+    return static_cast<i8>(Math::Clamp(bone, -1, 127));
+}
+
+// Layouts ---------------------------------------------------------------------
+
+u32 Mesh::GetVertexStride(MeshVertexLayout layout)
+{
+    switch (layout)
+    {
+    case MeshVertexLayout::STANDARD: return sizeof(Vertex);
+    case MeshVertexLayout::COMPACT: return sizeof(CompactVertex);
+    case MeshVertexLayout::COMPACT_SKINNED: return sizeof(CompactSkinnedVertex);
+    default:
+        BX_FAIL("Unknown mesh vertex layout!");
+        return 0;
+    }
+}
+
+const List<LayoutElement>& Mesh::GetLayoutElements(MeshVertexLayout layout)
+{
+    static const List<LayoutElement> s_standard =
+    {
+        LayoutElement { 0, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 1, 0, 4, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 2, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 3, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 4, 0, 2, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 5, 0, 4, GraphicsValueType::INT32, false, 0, 0 },
+        LayoutElement { 6, 0, 4, GraphicsValueType::FLOAT32, false, 0, 0 }
+    };
+
+    static const List<LayoutElement> s_compact =
+    {
+        LayoutElement { 0, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 1, 0, 4, GraphicsValueType::UINT8, true, 0, 0 },
+        LayoutElement { 2, 0, 4, GraphicsValueType::INT10_10_10_2, true, 0, 0 },
+        LayoutElement { 3, 0, 4, GraphicsValueType::INT10_10_10_2, true, 0, 0 },
+        LayoutElement { 4, 0, 2, GraphicsValueType::FLOAT16, false, 0, 0 }
+    };
+
+    static const List<LayoutElement> s_compactSkinned =
+    {
+        LayoutElement { 0, 0, 3, GraphicsValueType::FLOAT32, false, 0, 0 },
+        LayoutElement { 1, 0, 4, GraphicsValueType::UINT8, true, 0, 0 },
+        LayoutElement { 2, 0, 4, GraphicsValueType::INT10_10_10_2, true, 0, 0 },
+        LayoutElement { 3, 0, 4, GraphicsValueType::INT10_10_10_2, true, 0, 0 },
+        LayoutElement { 4, 0, 2, GraphicsValueType::FLOAT16, false, 0, 0 },
+        LayoutElement { 5, 0, 4, GraphicsValueType::INT8, false, 0, 0 },
+        LayoutElement { 6, 0, 4, GraphicsValueType::UINT8, true, 0, 0 }
+    };
+
+    switch (layout)
+    {
+    case MeshVertexLayout::COMPACT: return s_compact;
+    case MeshVertexLayout::COMPACT_SKINNED: return s_compactSkinned;
+    default: return s_standard;
+    }
+}
+
+static List<u8> EncodeVertices(const Mesh& data)
+{
+    const auto& positions = data.GetVertices();
+    const auto& colors = data.GetColors();
+    const auto& normals = data.GetNormals();
+    const auto& tangents = data.GetTangents();
+    const auto& uvs = data.GetUvs();
+    const auto& bones = data.GetBones();
+    const auto& weights = data.GetWeights();
+
+    const SizeType count = positions.size();
+    const MeshVertexLayout layout = data.GetLayout();
+
+    List<u8> stream;
+    stream.resize(count * Mesh::GetVertexStride(layout));
+
+    switch (layout)
+    {
+    case MeshVertexLayout::STANDARD:
+    {
+        auto pVertices = reinterpret_cast<Mesh::Vertex*>(stream.data());
+        for (SizeType i = 0; i < count; i++)
+        {
+            auto& v = pVertices[i];
+            v.position = positions[i];
+            v.color = colors[i];
+            v.normal = normals[i];
+            v.tangent = tangents[i];
+            v.uv = uvs[i];
+            v.bones = bones[i];
+            v.weights = weights[i];
+        }
+        break;
+    }
+    case MeshVertexLayout::COMPACT:
+    {
+        auto pVertices = reinterpret_cast<Mesh::CompactVertex*>(stream.data());
+        for (SizeType i = 0; i < count; i++)
+        {
+            auto& v = pVertices[i];
+            v.position = positions[i];
+            v.color = PackUnorm8x4(colors[i]);
+            v.normal = PackSnorm10x3(normals[i]);
+            v.tangent = PackSnorm10x3(tangents[i]);
+            v.uv[0] = FloatToHalf(uvs[i].x);
+            v.uv[1] = FloatToHalf(uvs[i].y);
+        }
+        break;
+    }
+    case MeshVertexLayout::COMPACT_SKINNED:
+    {
+        auto pVertices = reinterpret_cast<Mesh::CompactSkinnedVertex*>(stream.data());
+        for (SizeType i = 0; i < count; i++)
+        {
+            auto& v = pVertices[i];
+            v.position = positions[i];
+            v.color = PackUnorm8x4(colors[i]);
+            v.normal = PackSnorm10x3(normals[i]);
+            v.tangent = PackSnorm10x3(tangents[i]);
+            v.uv[0] = FloatToHalf(uvs[i].x);
+            v.uv[1] = FloatToHalf(uvs[i].y);
+            for (i32 b = 0; b < 4; b++)
+                v.bones[b] = PackBoneIndex(bones[i][b]);
+            PackWeights(weights[i], v.weights);
+        }
+        break;
+    }
+    }
+
+    return stream;
+}
+
+void Mesh::RecalculateBounds()
+{
+    const auto& vertices = GetVertices();
+    if (vertices.empty())
+    {
+        m_bounds = Box3();
+        return;
+    }
+
+    Vec3 min = vertices[0];
+    Vec3 max = vertices[0];
+    for (const auto& v : vertices)
+    {
+        min = Vec3(Math::Min(min.x, v.x), Math::Min(min.y, v.y), Math::Min(min.z, v.z));
+        max = Vec3(Math::Max(max.x, v.x), Math::Max(max.y, v.y), Math::Max(max.z, v.z));
+    }
+    m_bounds = Box3(min, max);
+}
+
+void Mesh::LoadAttributes() const
+{
+    // Only attempt once, a failed read leaves the lists empty
+    m_isMaterialized = true;
+
+    MappedFile file(m_filename);
+    MeshBlobHeader header;
+    List<u8> buffer;
+    const u8* pBlob = file.IsOpen() ? ReadBlob(m_filename, file, header, buffer) : nullptr;
+    if (pBlob == nullptr)
+    {
+        BX_LOGE("Failed to read vertex attributes of mesh {}", m_filename);
+        return;
+    }
+
+    m_vertices.resize(header.vertexCount);
+    m_colors.resize(header.vertexCount);
+    m_normals.resize(header.vertexCount);
+    m_tangents.resize(header.vertexCount);
+    m_uvs.resize(header.vertexCount);
+    m_bones.resize(header.vertexCount);
+    m_weights.resize(header.vertexCount);
+
+    const u8* pStream = pBlob + header.vertexOffset;
+    switch (header.layout)
+    {
+    case MeshVertexLayout::STANDARD:
+    {
+        const auto pVertices = reinterpret_cast<const Vertex*>(pStream);
+        for (SizeType i = 0; i < header.vertexCount; i++)
+        {
+            const auto& v = pVertices[i];
+            m_vertices[i] = v.position;
+            m_colors[i] = v.color;
+            m_normals[i] = v.normal;
+            m_tangents[i] = v.tangent;
+            m_uvs[i] = v.uv;
+            m_bones[i] = v.bones;
+            m_weights[i] = v.weights;
+        }
+        break;
+    }
+    case MeshVertexLayout::COMPACT:
+    {
+        const auto pVertices = reinterpret_cast<const CompactVertex*>(pStream);
+        for (SizeType i = 0; i < header.vertexCount; i++)
+        {
+            const auto& v = pVertices[i];
+            m_vertices[i] = v.position;
+            m_colors[i] = UnpackUnorm8x4(v.color);
+            m_normals[i] = UnpackSnorm10x3(v.normal);
+            m_tangents[i] = UnpackSnorm10x3(v.tangent);
+            m_uvs[i] = Vec2(HalfToFloat(v.uv[0]), HalfToFloat(v.uv[1]));
+            m_bones[i] = Vec4i(-1, -1, -1, -1);
+            m_weights[i] = Vec4(0, 0, 0, 0);
+        }
+        break;
+    }
+    case MeshVertexLayout::COMPACT_SKINNED:
+    {
+        const auto pVertices = reinterpret_cast<const CompactSkinnedVertex*>(pStream);
+        for (SizeType i = 0; i < header.vertexCount; i++)
+        {
+            const auto& v = pVertices[i];
+            m_vertices[i] = v.position;
+            m_colors[i] = UnpackUnorm8x4(v.color);
+            m_normals[i] = UnpackSnorm10x3(v.normal);
+            m_tangents[i] = UnpackSnorm10x3(v.tangent);
+            m_uvs[i] = Vec2(HalfToFloat(v.uv[0]), HalfToFloat(v.uv[1]));
+            m_bones[i] = Vec4i(v.bones[0], v.bones[1], v.bones[2], v.bones[3]);
+            m_weights[i] = Vec4(v.weights[0] / 255.0f, v.weights[1] / 255.0f, v.weights[2] / 255.0f, v.weights[3] / 255.0f);
+        }
+        break;
+    }
+    }
+
+    m_triangles.resize(header.indexCount);
+    memcpy(m_triangles.data(), pBlob + header.indexOffset, header.indexCount * sizeof(u32));
+}
+
+template<>
+bool Resource<Mesh>::Save(const String& filename, const Mesh& data)
+{
+    const auto vertices = EncodeVertices(data);
+    const u32 stride = Mesh::GetVertexStride(data.GetLayout());
+    const auto& triangles = data.GetTriangles();
+
+    List<Mesh::Submesh> submeshes = data.GetSubmeshes();
+    if (submeshes.empty())
+    {
+        Mesh::Submesh submesh;
+        submesh.indexOffset = 0;
+        submesh.indexCount = static_cast<u32>(triangles.size());
+        submeshes.emplace_back(submesh);
+    }
+
+    MeshBlobHeader header;
+    header.layout = data.GetLayout();
+    header.vertexStride = stride;
+    header.vertexCount = static_cast<u32>(data.GetVertices().size());
+    header.indexCount = static_cast<u32>(triangles.size());
+    header.submeshCount = static_cast<u32>(submeshes.size());
+    header.submeshOffset = AlignBlobOffset(sizeof(MeshBlobHeader));
+    header.vertexOffset = AlignBlobOffset(header.submeshOffset + submeshes.size() * sizeof(Mesh::Submesh));
+    header.indexOffset = AlignBlobOffset(header.vertexOffset + vertices.size());
+    header.bounds = data.GetBounds();
+    header.transform = data.GetMatrix();
+
+    // Sections are laid out in memory first, padding is zeroed
+    List<u8> blob(static_cast<SizeType>(header.indexOffset + triangles.size() * sizeof(u32)), 0);
+    memcpy(blob.data() + header.submeshOffset, submeshes.data(), submeshes.size() * sizeof(Mesh::Submesh));
+    memcpy(blob.data() + header.vertexOffset, vertices.data(), vertices.size());
+    memcpy(blob.data() + header.indexOffset, triangles.data(), triangles.size() * sizeof(u32));
+
+    const SizeType payloadOffset = static_cast<SizeType>(header.submeshOffset);
+    const SizeType payloadSize = blob.size() - payloadOffset;
+
+    List<u8> compressed(Compression::GetMaxCompressedSize(payloadSize));
+    const SizeType compressedSize = Compression::Compress(blob.data() + payloadOffset, payloadSize, compressed.data(), compressed.size());
+    const bool isCompressed = compressedSize > 0 && compressedSize < payloadSize * (1.0f - MESH_BLOB_MIN_SAVING);
+
+    header.compression = isCompressed ? MeshBlobCompression::LZ4 : MeshBlobCompression::NONE;
+    memcpy(blob.data(), &header, sizeof(MeshBlobHeader));
+
+    std::ofstream stream(File::GetPath(filename), std::ios::binary);
+    if (stream.fail())
+        return false;
+
+    if (isCompressed)
+    {
+        stream.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(payloadOffset));
+        stream.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressedSize));
+    }
+    else
+    {
+        stream.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+    }
+
+    return !stream.fail();
+}
+
+template<>
+bool Resource<Mesh>::Decode(const String& filename, Mesh& data)
+{
+    MappedFile file(filename);
+    if (!file.IsOpen())
+        return false;
+
+    if (!IsMeshBlob(file))
+    {
+        // Meshes imported before the blob format are plain cereal archives
+        MemoryStream stream(file.GetData(), file.GetSize());
+        cereal::PortableBinaryInputArchive archive(stream);
+        archive(cereal::make_nvp("mesh", data));
+
+        BX_LOGW("Mesh {} uses the legacy format, re-import it for faster loading.", filename);
+
+        data.m_layout = MeshVertexLayout::STANDARD;
+        return true;
+    }
+
+    MeshBlobHeader header;
+    List<u8> buffer;
+    const u8* pBlob = ReadBlob(filename, file, header, buffer);
+    if (pBlob == nullptr)
+        return false;
+
+    data.m_layout = header.layout;
+    data.m_transform = header.transform;
+    data.m_bounds = header.bounds;
+    data.m_vertexCount = header.vertexCount;
+    data.m_indexCount = header.indexCount;
+    data.m_submeshes.resize(header.submeshCount);
+    memcpy(data.m_submeshes.data(), pBlob + header.submeshOffset, header.submeshCount * sizeof(Mesh::Submesh));
+
+    data.m_filename = filename;
+    data.m_isMaterialized = false;
+
+    // Decompressed blobs are kept for Finalize to upload from
+    if (!buffer.empty())
+    {
+        data.m_blob = std::move(buffer);
+        return true;
+    }
+
+    // Fault the pages in while still off the main thread, the mapping in Finalize then hits the page cache
+    static const SizeType s_pageSize = 4096;
+    volatile u8 touch = 0;
+    for (SizeType offset = 0; offset < file.GetSize(); offset += s_pageSize)
+        touch ^= file.GetData()[offset];
+
+    return true;
+}
+
+template<>
+bool Resource<Mesh>::Finalize(const String& filename, Mesh& data)
+{
+    if (data.m_isMaterialized)
+    {
+        const auto vertices = EncodeVertices(data);
+        CreateMeshBuffers(Mesh::GetVertexStride(data.m_layout), data.m_vertexCount, data.m_indexCount, vertices.data(), data.m_triangles.data(), data.m_vbuffers, data.m_ibuffer);
+        return true;
+    }
+
+    if (!data.m_blob.empty())
+    {
+        MeshBlobHeader header;
+        memcpy(&header, data.m_blob.data(), sizeof(MeshBlobHeader));
+
+        CreateMeshBuffers(header.vertexStride, header.vertexCount, header.indexCount,
+            data.m_blob.data() + header.vertexOffset,
+            data.m_blob.data() + header.indexOffset,
+            data.m_vbuffers, data.m_ibuffer);
+
+        data.m_blob.clear();
+        data.m_blob.shrink_to_fit();
+        return true;
+    }
+
+    MappedFile file(filename);
+    if (!file.IsOpen())
+        return false;
+
+    MeshBlobHeader header;
+    List<u8> buffer;
+    const u8* pBlob = ReadBlob(filename, file, header, buffer);
+    if (pBlob == nullptr)
+        return false;
+
+    // Upload straight from the mapping, no intermediate copies unless compressed
+    CreateMeshBuffers(header.vertexStride, header.vertexCount, header.indexCount,
+        pBlob + header.vertexOffset,
+        pBlob + header.indexOffset,
+        data.m_vbuffers, data.m_ibuffer);
 
     return true;
 }
@@ -84,4 +694,23 @@ void Resource<Mesh>::Unload(const Mesh& data)
 {
     Graphics::DestroyBuffer(data.m_vbuffers);
     Graphics::DestroyBuffer(data.m_ibuffer);
-}
\ No newline at end of file
+}
+
+template<>
+ResourceMemory Resource<Mesh>::Measure(const Mesh& data)
+{
+    ResourceMemory memory;
+    memory.cpu = sizeof(Mesh)
+        + data.m_vertices.capacity() * sizeof(Vec3)
+        + data.m_colors.capacity() * sizeof(Vec4)
+        + data.m_normals.capacity() * sizeof(Vec3)
+        + data.m_tangents.capacity() * sizeof(Vec3)
+        + data.m_uvs.capacity() * sizeof(Vec2)
+        + data.m_bones.capacity() * sizeof(Vec4i)
+        + data.m_weights.capacity() * sizeof(Vec4)
+        + data.m_triangles.capacity() * sizeof(u32)
+        + data.m_submeshes.capacity() * sizeof(Mesh::Submesh);
+    memory.gpu = static_cast<SizeType>(data.m_vertexCount) * Mesh::GetVertexStride(data.m_layout)
+        + static_cast<SizeType>(data.m_indexCount) * sizeof(u32);
+    return memory;
+}
@@ -24,27 +24,35 @@ bool Resource<Shader>::Save(const String& filename, const Shader& data)
 }
 
 template<>
-bool Resource<Shader>::Load(const String& filename, Shader& data)
+bool Resource<Shader>::Decode(const String& filename, Shader& data)
 {
-    std::ifstream stream(File::GetPath(filename));
-    if (stream.fail())
+    auto file = std::make_shared<MappedFile>(filename, true);
+    if (!file->IsOpen())
         return false;
 
-    std::stringstream ss;
-    ss << stream.rdbuf();
+    data.m_file = file;
+
+    return true;
+}
 
-    data.SetSource(ss.str());
+template<>
+bool Resource<Shader>::Finalize(const String& filename, Shader& data)
+{
+    const char* source = data.m_file ? data.m_file->GetText() : data.m_source.c_str();
 
     ShaderInfo shaderInfo;
 
     shaderInfo.shaderType = ShaderType::VERTEX;
-    shaderInfo.source = data.m_source.c_str();
+    shaderInfo.source = source;
     data.m_vertex = Graphics::CreateShader(shaderInfo);
 
     shaderInfo.shaderType = ShaderType::PIXEL;
-    shaderInfo.source = data.m_source.c_str();
+    shaderInfo.source = source;
     data.m_pixel = Graphics::CreateShader(shaderInfo);
 
+    // The compiled shaders are all that is needed from here on
+    data.m_file.reset();
+
     return true;
 }
 
@@ -53,4 +61,12 @@ void Resource<Shader>::Unload(const Shader& data)
 {
     Graphics::DestroyShader(data.m_vertex);
     Graphics::DestroyShader(data.m_pixel);
+}
+
+template<>
+ResourceMemory Resource<Shader>::Measure(const Shader& data)
+{
+    ResourceMemory memory;
+    memory.cpu = sizeof(Shader) + data.m_source.capacity();
+    return memory;
 }
\ No newline at end of file
@@ -25,20 +25,37 @@ bool Resource<Skeleton>::Save(const String& filename, const Skeleton& data)
 }
 
 template<>
-bool Resource<Skeleton>::Load(const String& filename, Skeleton& data)
+bool Resource<Skeleton>::Decode(const String& filename, Skeleton& data)
 {
     // Deserialize data
-    std::ifstream stream(File::GetPath(filename), std::ios::binary);
-    if (stream.fail())
+    MappedFile file(filename);
+    if (!file.IsOpen())
         return false;
 
+    MemoryStream stream(file.GetData(), file.GetSize());
     cereal::PortableBinaryInputArchive archive(stream);
     archive(cereal::make_nvp("skeleton", data));
 
     return true;
 }
 
+template<>
+bool Resource<Skeleton>::Finalize(const String& filename, Skeleton& data)
+{
+    return true;
+}
+
 template<>
 void Resource<Skeleton>::Unload(const Skeleton& data)
 {
+}
+
+template<>
+ResourceMemory Resource<Skeleton>::Measure(const Skeleton& data)
+{
+    ResourceMemory memory;
+    memory.cpu = sizeof(Skeleton)
+        + data.m_bones.capacity() * sizeof(Skeleton::Bone)
+        + data.m_boneMap.size() * (sizeof(String) + sizeof(SizeType));
+    return memory;
 }
\ No newline at end of file
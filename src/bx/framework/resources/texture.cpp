@@ -2,53 +2,291 @@
 #include "bx/framework/resources/texture.serial.hpp"
 
 #include <bx/engine/core/file.hpp>
+#include <bx/engine/core/compression.hpp>
+#include <bx/engine/core/profiler.hpp>
 #include <bx/engine/modules/graphics.hpp>
 
 #include <cereal/archives/json.hpp>
 #include <cereal/archives/portable_binary.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
 #include <fstream>
 #include <sstream>
 
+// Texture blob layout: [TextureBlobHeader][pixels at dataOffset], the pixels (all mip levels) are either stored
+// as they go to the GPU or compressed as one block. Data is stored in native (little endian) byte order.
+// Files without the magic are cereal archives written before the blob format.
+// Version 2 added the format and mip count, version 1 blobs are single level RGBA8.
+constexpr u32 TEXTURE_BLOB_MAGIC = 0x58455442; // "BTEX"
+constexpr u32 TEXTURE_BLOB_VERSION = 2;
+constexpr u32 TEXTURE_BLOB_MIN_VERSION = 1;
+constexpr u64 TEXTURE_BLOB_ALIGNMENT = 16;
+// Compression has to save at least this fraction of the size, otherwise uploading from the mapping wins
+constexpr f32 TEXTURE_BLOB_MIN_SAVING = 0.1f;
+
+namespace TextureBlobCompression
+{
+    enum : u32
+    {
+        NONE = 0,
+        LZ4
+    };
+}
+
+struct TextureBlobHeader
+{
+    u32 magic = TEXTURE_BLOB_MAGIC;
+    u32 version = TEXTURE_BLOB_VERSION;
+    i32 channels = 0;
+    i32 width = 0;
+    i32 height = 0;
+    i32 depth = 0;
+    u32 compression = TextureBlobCompression::NONE;
+    u32 format = TextureFormat::UNKNOWN;
+    u64 dataOffset = 0;
+    u64 dataSize = 0;
+    u64 pixelSize = 0;
+    // Since version 2
+    u32 mipCount = 1;
+    u32 padding = 0;
+};
+
+constexpr SizeType TEXTURE_BLOB_V1_HEADER_SIZE = offsetof(TextureBlobHeader, mipCount);
+
 template<>
 bool Resource<Texture>::Save(const String& filename, const Texture& data)
 {
-    // TODO: Use astc compression: https://developer.nvidia.com/astc-texture-compression-for-game-assets
-    // Possibly using this lib: https://github.com/ARM-software/astc-encoder
+    // Loaded textures only keep their levels on the GPU, Finalize released the pixels
+    if (data.pixels.size() != GetTextureSize(data.format, data.width, data.height, data.mipCount))
+    {
+        BX_LOGE("Texture {} has no pixels to save, only imported textures can be saved.", filename);
+        return false;
+    }
+
+    TextureBlobHeader header;
+    header.channels = data.channels;
+    header.width = data.width;
+    header.height = data.height;
+    header.depth = data.depth;
+    header.format = data.format;
+    header.mipCount = static_cast<u32>(data.mipCount);
+    header.dataOffset = (sizeof(TextureBlobHeader) + TEXTURE_BLOB_ALIGNMENT - 1) & ~(TEXTURE_BLOB_ALIGNMENT - 1);
+    header.pixelSize = data.pixels.size();
+
+    List<u8> compressed(Compression::GetMaxCompressedSize(data.pixels.size()));
+    const SizeType compressedSize = Compression::Compress(data.pixels.data(), data.pixels.size(), compressed.data(), compressed.size());
+    const bool isCompressed = compressedSize > 0 && compressedSize < data.pixels.size() * (1.0f - TEXTURE_BLOB_MIN_SAVING);
+
+    header.compression = isCompressed ? TextureBlobCompression::LZ4 : TextureBlobCompression::NONE;
+    header.dataSize = isCompressed ? compressedSize : data.pixels.size();
 
     std::ofstream stream(File::GetPath(filename), std::ios::binary);
     if (stream.fail())
         return false;
 
-    cereal::PortableBinaryOutputArchive archive(stream);
-    archive(cereal::make_nvp("texture", data));
+    static const char s_padding[TEXTURE_BLOB_ALIGNMENT] = {};
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(TextureBlobHeader));
+    stream.write(s_padding, static_cast<std::streamsize>(header.dataOffset - sizeof(TextureBlobHeader)));
+    stream.write(reinterpret_cast<const char*>(isCompressed ? compressed.data() : data.pixels.data()), static_cast<std::streamsize>(header.dataSize));
+
+    return !stream.fail();
+}
+
+static bool IsTextureBlob(const MappedFile& file)
+{
+    return file.GetSize() >= sizeof(u32)
+        && memcmp(file.GetData(), &TEXTURE_BLOB_MAGIC, sizeof(u32)) == 0;
+}
+
+// Points the view at stored pixels, or decompresses them into the staging buffer
+static bool ReadBlob(const String& filename, const MappedFile& file, Texture& data, FileView& view, List<u8>& staging)
+{
+    TextureBlobHeader header;
+    if (file.GetSize() < TEXTURE_BLOB_V1_HEADER_SIZE)
+    {
+        BX_LOGE("Texture {} is truncated!", filename);
+        return false;
+    }
+
+    memcpy(&header, file.GetData(), TEXTURE_BLOB_V1_HEADER_SIZE);
+    if (header.version == 1)
+    {
+        header.format = TextureFormat::RGBA8_UNORM;
+    }
+    else
+    {
+        if (file.GetSize() < sizeof(TextureBlobHeader))
+        {
+            BX_LOGE("Texture {} is truncated!", filename);
+            return false;
+        }
+        memcpy(&header, file.GetData(), sizeof(TextureBlobHeader));
+    }
+
+    if (header.version < TEXTURE_BLOB_MIN_VERSION || header.version > TEXTURE_BLOB_VERSION
+        || header.compression > TextureBlobCompression::LZ4 || header.mipCount == 0)
+    {
+        BX_LOGE("Texture {} was written with an incompatible format (version {}), re-import it.", filename, header.version);
+        return false;
+    }
+
+    if (header.dataOffset > file.GetSize() || header.dataSize > file.GetSize() - header.dataOffset)
+    {
+        BX_LOGE("Texture {} is truncated!", filename);
+        return false;
+    }
+
+    data.channels = header.channels;
+    data.width = header.width;
+    data.height = header.height;
+    data.depth = header.depth;
+    data.format = TextureFormat(static_cast<i32>(header.format));
+    data.mipCount = static_cast<i32>(header.mipCount);
+
+    const SizeType pixelSize = GetTextureSize(data.format, data.width, data.height, header.mipCount);
+    if (header.pixelSize != pixelSize || (header.compression == TextureBlobCompression::NONE && header.dataSize != pixelSize))
+    {
+        BX_LOGE("Texture {} does not match its size!", filename);
+        return false;
+    }
+
+    const u8* pData = file.GetData() + header.dataOffset;
+    if (header.compression == TextureBlobCompression::NONE)
+    {
+        view = FileView(pData, static_cast<SizeType>(header.dataSize));
+    }
+    else
+    {
+        staging.resize(static_cast<SizeType>(header.pixelSize));
+        if (!Compression::Decompress(pData, static_cast<SizeType>(header.dataSize), staging.data(), staging.size()))
+        {
+            BX_LOGE("Texture {} is corrupt!", filename);
+            staging.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Coarsest level above TEXTURE_STREAMING_MIN_SIZE is the finest one a streamed texture starts with
+static u32 GetStreamingBaseMip(const Texture& data)
+{
+    const u32 mipCount = static_cast<u32>(data.mipCount);
 
+    u32 mip = 0;
+    while (mip + 1 < mipCount && std::max(GetTextureLevelExtent(data.width, mip), GetTextureLevelExtent(data.height, mip)) > TEXTURE_STREAMING_MIN_SIZE)
+        mip++;
+    return mip;
+}
+
+// GPU size of the levels from mip on
+static SizeType GetLevelsSize(const Texture& data, u32 mip)
+{
+    return GetTextureSize(data.format, data.width, data.height, data.mipCount)
+        - GetTextureSize(data.format, data.width, data.height, mip);
+}
+
+// Creates the GPU texture from the levels starting at mip, pLevels points at the first level of the full chain
+static GraphicsHandle CreateLevels(const Texture& data, u32 mip, const u8* pLevels)
+{
+    TextureInfo textureInfo;
+    textureInfo.width = GetTextureLevelExtent(data.width, mip);
+    textureInfo.height = GetTextureLevelExtent(data.height, mip);
+    textureInfo.format = data.format;
+    textureInfo.mipCount = data.mipCount - mip;
+    textureInfo.flags = TextureFlags::SHADER_RESOURCE;
+
+    const SizeType offset = GetTextureSize(data.format, data.width, data.height, mip);
+
+    BufferData bufferData;
+    bufferData.dataSize = static_cast<u32>(GetLevelsSize(data, mip));
+    bufferData.pData = pLevels + offset;
+
+    return Graphics::CreateTexture(textureInfo, bufferData);
+}
+
+// The portable binary archive stores an endianness flag, the four i32 fields and the u64 pixel count
+// in front of the raw pixels. When no byte swapping is needed the pixels can be used in place.
+static bool ReadPixelView(const MappedFile& file, Texture& data, FileView& view)
+{
+    constexpr SizeType headerSize = 1 + 4 * sizeof(i32) + sizeof(u64);
+
+    const u16 probe = 1;
+    const u8 hostLittleEndian = *reinterpret_cast<const u8*>(&probe);
+
+    const u8* pData = file.GetData();
+    if (file.GetSize() < headerSize || pData[0] != hostLittleEndian)
+        return false;
+
+    u64 pixelCount = 0;
+    std::memcpy(&pixelCount, pData + 1 + 4 * sizeof(i32), sizeof(u64));
+    if (pixelCount != file.GetSize() - headerSize)
+        return false;
+
+    std::memcpy(&data.channels, pData + 1, sizeof(i32));
+    std::memcpy(&data.width, pData + 1 + sizeof(i32), sizeof(i32));
+    std::memcpy(&data.height, pData + 1 + 2 * sizeof(i32), sizeof(i32));
+    std::memcpy(&data.depth, pData + 1 + 3 * sizeof(i32), sizeof(i32));
+
+    view = FileView(pData + headerSize, static_cast<SizeType>(pixelCount));
     return true;
 }
 
 template<>
-bool Resource<Texture>::Load(const String& filename, Texture& data)
+bool Resource<Texture>::Decode(const String& filename, Texture& data)
 {
-    // Deserialize data
-    std::ifstream stream(File::GetPath(filename), std::ios::binary);
-    if (stream.fail())
+    auto file = std::make_shared<MappedFile>(filename);
+    if (!file->IsOpen())
         return false;
 
+    if (IsTextureBlob(*file))
+    {
+        if (!ReadBlob(filename, *file, data, data.m_fileView, data.m_staging))
+            return false;
+
+        if (TextureStreamer::IsEnabled())
+            data.m_baseMip = data.m_residentMip = GetStreamingBaseMip(data);
+
+        // Decompressed pixels no longer need the file
+        if (data.m_staging.empty())
+            data.m_file = file;
+        return true;
+    }
+
+    if (ReadPixelView(*file, data, data.m_fileView))
+    {
+        data.m_file = file;
+        return true;
+    }
+
+    // Deserialize data
+    MemoryStream stream(file->GetData(), file->GetSize());
     cereal::PortableBinaryInputArchive archive(stream);
     archive(cereal::make_nvp("texture", data));
 
-    // Build graphic components
-    TextureInfo textureInfo;
-    textureInfo.width = data.width;
-    textureInfo.height = data.height;
-    textureInfo.format = TextureFormat::RGBA8_UNORM;
-    textureInfo.flags = TextureFlags::SHADER_RESOURCE;
+    return true;
+}
 
-    BufferData bufferData;
-    bufferData.dataSize = static_cast<u32>(data.pixels.size());
-    bufferData.pData = data.pixels.data();
+template<>
+bool Resource<Texture>::Finalize(const String& filename, Texture& data)
+{
+    if (!data.m_staging.empty())
+        data.m_texture = CreateLevels(data, data.m_residentMip, data.m_staging.data());
+    else if (data.m_file)
+        data.m_texture = CreateLevels(data, data.m_residentMip, data.m_fileView.GetData());
+    else
+        data.m_texture = CreateLevels(data, data.m_residentMip, data.pixels.data());
 
-    data.m_texture = Graphics::CreateTexture(textureInfo, bufferData);
+    // Only the GPU copy is kept, streamed levels are read from the file again when needed
+    data.m_fileView = FileView();
+    data.m_file.reset();
+    data.m_staging.clear();
+    data.m_staging.shrink_to_fit();
+    data.pixels.clear();
+    data.pixels.shrink_to_fit();
 
     return true;
 }
@@ -56,5 +294,235 @@ bool Resource<Texture>::Load(const String& filename, Texture& data)
 template<>
 void Resource<Texture>::Unload(const Texture& data)
 {
-    // TODO
+    Graphics::DestroyTexture(data.m_texture);
+}
+
+template<>
+ResourceMemory Resource<Texture>::Measure(const Texture& data)
+{
+    ResourceMemory memory;
+    memory.cpu = sizeof(Texture) + data.pixels.capacity();
+    memory.gpu = GetLevelsSize(data, data.m_residentMip);
+    return memory;
+}
+
+struct TextureStreamEntry
+{
+    Resource<Texture> texture;
+    u32 requestedMip = 0;
+    u64 requestFrame = 0;
+    bool isLoading = false;
+};
+
+static std::atomic<bool> s_streamingEnabled(false);
+static SizeType s_streamingBudget = 0;
+static SizeType s_streamingResident = 0;
+static u64 s_streamingFrame = 1;
+static u32 s_streamingJobs = 0;
+static HashMap<ResourceHandle, TextureStreamEntry> s_streamEntries;
+
+// Reads the blob again on a worker and uploads the levels from mip on, replacing the GPU texture
+class TextureStreamJob : public IResourceJob
+{
+public:
+    TextureStreamJob(const Resource<Texture>& texture, u32 mip)
+        : m_texture(texture)
+        , m_filename(texture.GetResourceData().filename)
+        , m_previous(texture->GetTexture())
+        , m_mip(mip)
+        , m_width(texture->width)
+        , m_height(texture->height)
+        , m_mipCount(texture->mipCount)
+    {}
+
+    void Decode() override
+    {
+        m_file = std::make_shared<MappedFile>(m_filename);
+        if (!m_file->IsOpen() || !IsTextureBlob(*m_file))
+            return;
+
+        Texture header;
+        if (!ReadBlob(m_filename, *m_file, header, m_view, m_staging))
+            return;
+
+        // The file changed since the texture was loaded, a reload takes care of it
+        m_isDecoded = header.width == m_width && header.height == m_height && header.mipCount == m_mipCount;
+    }
+
+    void Finalize() override
+    {
+        const u8* pLevels = m_isDecoded ? (m_staging.empty() ? m_view.GetData() : m_staging.data()) : nullptr;
+        TextureStreamer::FinishLoad(m_texture, m_previous, m_mip, pLevels, m_staging.empty() ? m_view.GetSize() : m_staging.size());
+    }
+
+    const String& GetFilename() const override { return m_filename; }
+
+private:
+    Resource<Texture> m_texture;
+    String m_filename;
+    GraphicsHandle m_previous = INVALID_GRAPHICS_HANDLE;
+    u32 m_mip = 0;
+    i32 m_width = 0;
+    i32 m_height = 0;
+    i32 m_mipCount = 0;
+
+    std::shared_ptr<MappedFile> m_file;
+    FileView m_view;
+    List<u8> m_staging;
+    bool m_isDecoded = false;
+};
+
+void TextureStreamer::Shutdown()
+{
+    s_streamEntries.clear();
+    s_streamingResident = 0;
+    s_streamingJobs = 0;
+}
+
+void TextureStreamer::SetEnabled(bool enabled)
+{
+    s_streamingEnabled = enabled;
+}
+
+bool TextureStreamer::IsEnabled()
+{
+    return s_streamingEnabled;
+}
+
+void TextureStreamer::SetBudget(SizeType budget)
+{
+    s_streamingBudget = budget;
+}
+
+SizeType TextureStreamer::GetBudget()
+{
+    return s_streamingBudget;
+}
+
+SizeType TextureStreamer::GetResidentSize()
+{
+    return s_streamingResident;
+}
+
+void TextureStreamer::Request(const Resource<Texture>& texture, f32 mip)
+{
+    if (!texture || !texture->IsStreamed())
+        return;
+
+    const auto& data = texture.GetData();
+    const u32 level = mip <= 0.0f ? 0 : std::min(static_cast<u32>(mip), data.m_baseMip);
+
+    auto& entry = s_streamEntries[texture.GetHandle()];
+    if (!entry.texture.IsValid())
+        entry.texture = texture;
+
+    if (entry.requestFrame != s_streamingFrame || level < entry.requestedMip)
+        entry.requestedMip = level;
+    entry.requestFrame = s_streamingFrame;
+}
+
+void TextureStreamer::Update()
+{
+    PROFILE_FUNCTION();
+
+    struct Target
+    {
+        ResourceHandle handle;
+        u32 mip;
+    };
+
+    List<Target> targets;
+    targets.reserve(s_streamEntries.size());
+
+    s_streamingResident = 0;
+    for (auto it = s_streamEntries.begin(); it != s_streamEntries.end();)
+    {
+        auto& entry = it->second;
+        if (!entry.texture.IsLoaded())
+        {
+            it = s_streamEntries.erase(it);
+            continue;
+        }
+
+        const bool isReleased = entry.texture.GetResourceData().refCount == 1;
+        const bool isStale = s_streamingFrame - entry.requestFrame > TEXTURE_STREAMING_GRACE_FRAMES;
+
+        // Nothing else uses the texture, or it dropped back to its base level
+        if (!entry.isLoading && (isReleased || (isStale && entry.texture->m_residentMip == entry.texture->m_baseMip)))
+        {
+            it = s_streamEntries.erase(it);
+            continue;
+        }
+
+        const auto& data = entry.texture.GetData();
+        s_streamingResident += GetLevelsSize(data, data.m_residentMip);
+        targets.push_back(Target{ it->first, isStale ? data.m_baseMip : entry.requestedMip });
+        ++it;
+    }
+
+    // Coarsen every texture by the same number of levels until the requests fit
+    u32 bias = 0;
+    for (; bias < 16; ++bias)
+    {
+        SizeType total = 0;
+        for (const auto& target : targets)
+        {
+            const auto& data = s_streamEntries[target.handle].texture.GetData();
+            total += GetLevelsSize(data, std::min(target.mip + bias, data.m_baseMip));
+        }
+
+        if (total <= s_streamingBudget)
+            break;
+    }
+
+    // Free memory before spending it
+    for (u32 pass = 0; pass < 2; ++pass)
+    {
+        for (const auto& target : targets)
+        {
+            if (s_streamingJobs >= TEXTURE_STREAMING_MAX_JOBS)
+                break;
+
+            auto& entry = s_streamEntries[target.handle];
+            const auto& data = entry.texture.GetData();
+            const u32 mip = std::min(target.mip + bias, data.m_baseMip);
+
+            const bool isShrink = mip > data.m_residentMip;
+            if (entry.isLoading || mip == data.m_residentMip || isShrink != (pass == 0))
+                continue;
+
+            entry.isLoading = true;
+            s_streamingJobs++;
+            ResourceManager::QueueJob(std::make_shared<TextureStreamJob>(entry.texture, mip));
+        }
+    }
+
+    s_streamingFrame++;
+
+    Profiler::SetCounter("Texture Streaming (MB)", s_streamingResident / (1024.0 * 1024.0));
+}
+
+void TextureStreamer::FinishLoad(const Resource<Texture>& texture, GraphicsHandle previous, u32 mip, const u8* pLevels, SizeType size)
+{
+    if (s_streamingJobs > 0)
+        s_streamingJobs--;
+
+    auto it = s_streamEntries.find(texture.GetHandle());
+    if (it != s_streamEntries.end())
+        it->second.isLoading = false;
+
+    // Reloaded or unloaded while streaming
+    if (pLevels == nullptr || !texture.IsLoaded() || texture->GetTexture() != previous)
+        return;
+
+    auto& data = texture.GetData();
+    if (size < GetTextureSize(data.format, data.width, data.height, data.mipCount))
+        return;
+
+    data.m_texture = CreateLevels(data, mip, pLevels);
+    data.m_residentMip = mip;
+    Graphics::DestroyTexture(previous);
+
+    // The resource budget sees the levels that are resident now
+    texture.Remeasure();
 }
\ No newline at end of file
@@ -0,0 +1,533 @@
+#include "bx/framework/scene_streamer.hpp"
+
+#include "bx/framework/gameobject.hpp"
+#include "bx/framework/gameobject.serial.hpp"
+#include "bx/framework/components/transform.hpp"
+#include "bx/framework/components/camera.hpp"
+
+#include <bx/engine/core/file.hpp>
+#include <bx/engine/core/profiler.hpp>
+#include <bx/engine/core/resource.hpp>
+#include <bx/engine/containers/grid_map.hpp>
+#include <bx/engine/containers/hash_map.hpp>
+
+#include <cereal/archives/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <fstream>
+
+struct SceneCellInfo
+{
+	i32 x = 0;
+	i32 y = 0;
+	i32 z = 0;
+};
+
+struct SceneComponentCount
+{
+	String type;
+	u32 count = 0;
+};
+
+// Lists the cells of a partitioned scene. The totals size the pools when the scene is opened,
+// components are referenced by pointer so the pools can't grow once cells are streaming in.
+struct SceneCellIndex
+{
+	f32 cellSize = SCENE_STREAMING_CELL_SIZE;
+	u32 objectCount = 0;
+	List<SceneCellInfo> cells;
+	List<SceneComponentCount> components;
+};
+
+template<class Archive>
+void serialize(Archive& ar, SceneCellInfo& data)
+{
+	ar(cereal::make_nvp("x", data.x));
+	ar(cereal::make_nvp("y", data.y));
+	ar(cereal::make_nvp("z", data.z));
+}
+
+template<class Archive>
+void serialize(Archive& ar, SceneComponentCount& data)
+{
+	ar(cereal::make_nvp("type", data.type));
+	ar(cereal::make_nvp("count", data.count));
+}
+
+template<class Archive>
+void serialize(Archive& ar, SceneCellIndex& data)
+{
+	ar(cereal::make_nvp("cellSize", data.cellSize));
+	ar(cereal::make_nvp("objectCount", data.objectCount));
+	ar(cereal::make_nvp("cells", data.cells));
+	ar(cereal::make_nvp("components", data.components));
+}
+
+namespace SceneCellState
+{
+	enum : u32
+	{
+		UNLOADED = 0,
+		LOADING,
+		INSTANTIATING,
+		LOADED
+	};
+}
+
+struct SceneCell
+{
+	String filename;
+	Box3 bounds;
+	u32 state = SceneCellState::UNLOADED;
+	// Identifies the load in flight, a cell unloaded in the meantime ignores it
+	u32 generation = 0;
+	f32 distance = 0.0f;
+	std::shared_ptr<SceneReader> reader;
+	List<Entity> entities;
+};
+
+static bool s_isOpen = false;
+static f32 s_radius = SCENE_STREAMING_RADIUS;
+static u32 s_budget = SCENE_STREAMING_BUDGET;
+static u32 s_jobs = 0;
+static u32 s_generation = 0;
+// Bumped on close, the jobs of an earlier session finish without touching the current one
+static u32 s_session = 0;
+static SizeType s_loadedCount = 0;
+
+static List<SceneCell> s_cells;
+static GridMap<u32> s_cellGrid;
+static List<Vec3> s_anchors;
+
+class SceneCellLoadJob : public IResourceJob
+{
+public:
+	SceneCellLoadJob(u32 session, u32 cell, u32 generation, const String& filename)
+		: m_session(session)
+		, m_cell(cell)
+		, m_generation(generation)
+		, m_filename(filename)
+	{}
+
+	void Decode() override
+	{
+		m_reader = std::make_shared<SceneReader>();
+		if (!m_reader->Read(m_filename))
+			m_reader.reset();
+	}
+
+	void Finalize() override
+	{
+		SceneStreamer::FinishLoad(m_session, m_cell, m_generation, m_reader);
+	}
+
+	const String& GetFilename() const override { return m_filename; }
+
+private:
+	u32 m_session = 0;
+	u32 m_cell = 0;
+	u32 m_generation = 0;
+	String m_filename;
+	std::shared_ptr<SceneReader> m_reader;
+};
+
+static String GetGlobalFilename(const String& filename)
+{
+	return File::RemoveExt(filename) + "_global.bscene";
+}
+
+static String GetCellFilename(const String& filename, const SceneCellInfo& cell)
+{
+	return File::RemoveExt(filename) + "_" + std::to_string(cell.x) + "_" + std::to_string(cell.y) + "_" + std::to_string(cell.z) + ".bscene";
+}
+
+static i32 ToCellCoord(f32 v, f32 cellSize)
+{
+	const f32 c = std::floor(v / cellSize);
+	return static_cast<i32>(Math::Clamp(c, f32(-GRIDMAP_COORD_BIAS), f32(GRIDMAP_COORD_BIAS - 1)));
+}
+
+static u64 MakeCellKey(i32 x, i32 y, i32 z)
+{
+	return (u64(x + GRIDMAP_COORD_BIAS) & GRIDMAP_COORD_MASK)
+		| ((u64(y + GRIDMAP_COORD_BIAS) & GRIDMAP_COORD_MASK) << GRIDMAP_COORD_BITS)
+		| ((u64(z + GRIDMAP_COORD_BIAS) & GRIDMAP_COORD_MASK) << (GRIDMAP_COORD_BITS * 2));
+}
+
+static f32 GetDistance(const Vec3& point, const Box3& box)
+{
+	const f32 dx = std::max(std::max(box.min.x - point.x, 0.0f), point.x - box.max.x);
+	const f32 dy = std::max(std::max(box.min.y - point.y, 0.0f), point.y - box.max.y);
+	const f32 dz = std::max(std::max(box.min.z - point.z, 0.0f), point.z - box.max.z);
+	return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+static f32 GetAnchorDistance(const Box3& box)
+{
+	f32 distance = std::numeric_limits<f32>::max();
+	for (const auto& anchor : s_anchors)
+		distance = std::min(distance, GetDistance(anchor, box));
+	return distance;
+}
+
+static const Transform* FindTransform(const GameObjectData& gameObj)
+{
+	for (const auto& cmp : gameObj.components)
+	{
+		if (cmp->GetTypeId() == Type<Transform>::Id())
+			return static_cast<const Transform*>(cmp.get());
+	}
+	return nullptr;
+}
+
+static void UnloadCell(SceneCell& cell)
+{
+	if (cell.state == SceneCellState::LOADED)
+		s_loadedCount--;
+
+	// Objects a script already destroyed are gone by now, or still valid but no longer in the scene
+	const List<Entity>& entities = cell.reader ? cell.reader->GetEntities() : cell.entities;
+	for (const auto& entity : entities)
+	{
+		if (!entity.IsValid())
+			continue;
+
+		GameObjectBase* pGameObj = GameObject::TryFind(Scene::GetCurrent(), entity.GetId());
+		if (pGameObj != nullptr)
+			pGameObj->Destroy();
+	}
+
+	cell.state = SceneCellState::UNLOADED;
+	cell.reader.reset();
+	cell.entities.clear();
+}
+
+bool SceneStreamer::Partition(const String& filename, f32 cellSize)
+{
+	BX_ASSERT(cellSize > 0.0f, "Scene cell size must be positive!");
+
+	List<GameObjectData> gameObjs;
+	if (!Scene::Read(filename, gameObjs))
+		return false;
+
+	SceneCellIndex index;
+	index.cellSize = cellSize;
+	index.objectCount = static_cast<u32>(gameObjs.size());
+
+	List<GameObjectData> globalObjs;
+	List<List<GameObjectData>> cellObjs;
+	HashMap<u64, SizeType> cellIndices;
+	HashMap<String, SizeType> componentIndices;
+	for (auto& gameObj : gameObjs)
+	{
+		for (const auto& cmp : gameObj.components)
+		{
+			const IComponentSerializer* pSerializer = ComponentSerializerRegistry::Find(cmp->GetTypeId());
+			if (pSerializer == nullptr)
+				continue;
+
+			auto it = componentIndices.find(pSerializer->GetName());
+			if (it == componentIndices.end())
+			{
+				it = componentIndices.insert(std::make_pair(pSerializer->GetName(), index.components.size())).first;
+				index.components.emplace_back();
+				index.components.back().type = pSerializer->GetName();
+			}
+			index.components[it->second].count++;
+		}
+
+		const Transform* pTransform = FindTransform(gameObj);
+		if (pTransform == nullptr)
+		{
+			globalObjs.emplace_back(std::move(gameObj));
+			continue;
+		}
+
+		SceneCellInfo cell;
+		cell.x = ToCellCoord(pTransform->GetPosition().x, cellSize);
+		cell.y = ToCellCoord(pTransform->GetPosition().y, cellSize);
+		cell.z = ToCellCoord(pTransform->GetPosition().z, cellSize);
+
+		const u64 key = MakeCellKey(cell.x, cell.y, cell.z);
+		auto it = cellIndices.find(key);
+		if (it == cellIndices.end())
+		{
+			it = cellIndices.insert(std::make_pair(key, index.cells.size())).first;
+			index.cells.emplace_back(cell);
+			cellObjs.emplace_back();
+		}
+		cellObjs[it->second].emplace_back(std::move(gameObj));
+	}
+
+	if (!Scene::WriteBinary(GetGlobalFilename(filename), globalObjs))
+		return false;
+
+	for (SizeType i = 0; i < index.cells.size(); ++i)
+	{
+		if (!Scene::WriteBinary(GetCellFilename(filename, index.cells[i]), cellObjs[i]))
+			return false;
+	}
+
+	try
+	{
+		std::ofstream stream(File::GetPath(GetIndexFilename(filename)));
+		{
+			cereal::JSONOutputArchive ar(stream);
+			ar(cereal::make_nvp("cells", index));
+		}
+		if (stream.fail())
+			return false;
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to save scene cells ({}): {}", filename, e.what());
+		return false;
+	}
+
+	BX_LOGI("Partitioned scene {} into {} cells of {} ({} objects, {} global)",
+		filename, index.cells.size(), cellSize, gameObjs.size(), globalObjs.size());
+
+	return true;
+}
+
+String SceneStreamer::GetIndexFilename(const String& filename)
+{
+	return File::RemoveExt(filename) + ".cells";
+}
+
+bool SceneStreamer::Open(const String& filename)
+{
+	Close();
+
+	const String indexFilename = GetIndexFilename(filename);
+	if (!File::Exists(indexFilename))
+	{
+		BX_LOGW("Failed to open non-existent scene cells: {}", indexFilename);
+		return false;
+	}
+
+	SceneCellIndex index;
+	try
+	{
+		MappedFile file(indexFilename);
+		MemoryStream stream(file.GetData(), file.GetSize());
+		cereal::JSONInputArchive ar(stream);
+		ar(cereal::make_nvp("cells", index));
+	}
+	catch (cereal::Exception& e)
+	{
+		BX_LOGW("Failed to load scene cells ({}): {}", indexFilename, e.what());
+		return false;
+	}
+
+	if (index.cellSize <= 0.0f)
+	{
+		BX_LOGW("Scene cells {} have an invalid cell size!", indexFilename);
+		return false;
+	}
+
+	// Room for the whole world while the pools are still empty, the global objects are counted too.
+	// Loading them first would size the pools for them alone, and growing a pool in use isn't possible.
+	EntityManager::ReserveEntities(index.objectCount);
+	for (const auto& cmp : index.components)
+	{
+		const IComponentSerializer* pSerializer = ComponentSerializerRegistry::Find(cmp.type);
+		if (pSerializer != nullptr && !pSerializer->Reserve(cmp.count))
+			BX_LOGW("Opening scene {} in a world that already has {} components, they may not fit.", filename, cmp.type);
+	}
+
+	// Global objects are created right away and replace the current scene, they fit in the room made above
+	Scene::Load(GetGlobalFilename(filename));
+
+	s_cellGrid.Clear();
+	s_cellGrid.SetCellSize(index.cellSize);
+
+	s_cells.resize(index.cells.size());
+	for (SizeType i = 0; i < index.cells.size(); ++i)
+	{
+		const auto& info = index.cells[i];
+		auto& cell = s_cells[i];
+		cell.filename = GetCellFilename(filename, info);
+
+		const Vec3 min = Vec3(static_cast<f32>(info.x), static_cast<f32>(info.y), static_cast<f32>(info.z)) * index.cellSize;
+		cell.bounds = Box3(min, min + Vec3(index.cellSize, index.cellSize, index.cellSize));
+
+		s_cellGrid.Insert(static_cast<u32>(i), cell.bounds);
+	}
+
+	s_isOpen = true;
+	return true;
+}
+
+void SceneStreamer::Close()
+{
+	s_isOpen = false;
+	s_jobs = 0;
+	s_session++;
+	s_loadedCount = 0;
+	s_cells.clear();
+	s_cellGrid.Clear();
+	s_anchors.clear();
+}
+
+bool SceneStreamer::IsOpen()
+{
+	return s_isOpen;
+}
+
+void SceneStreamer::SetRadius(f32 radius)
+{
+	s_radius = std::max(radius, 0.0f);
+}
+
+f32 SceneStreamer::GetRadius()
+{
+	return s_radius;
+}
+
+void SceneStreamer::SetBudget(u32 budget)
+{
+	// A budget of zero would never finish a cell
+	s_budget = std::max(budget, 1u);
+}
+
+u32 SceneStreamer::GetBudget()
+{
+	return s_budget;
+}
+
+void SceneStreamer::AddAnchor(const Vec3& position)
+{
+	s_anchors.emplace_back(position);
+}
+
+SizeType SceneStreamer::GetCellCount()
+{
+	return s_cells.size();
+}
+
+SizeType SceneStreamer::GetLoadedCount()
+{
+	return s_loadedCount;
+}
+
+void SceneStreamer::Update()
+{
+	if (!s_isOpen)
+		return;
+
+	PROFILE_FUNCTION();
+
+	if (s_anchors.empty())
+	{
+		EntityManager::ForEach<Transform, Camera>(
+			[&](const Entity& entity, Transform& trx, Camera& camera)
+			{
+				s_anchors.emplace_back(trx.GetPosition());
+			});
+	}
+
+	// Unload the cells every anchor left behind
+	const f32 unloadRadius = s_radius * (1.0f + SCENE_STREAMING_UNLOAD_MARGIN);
+	for (auto& cell : s_cells)
+	{
+		if (cell.state == SceneCellState::UNLOADED)
+			continue;
+
+		cell.distance = GetAnchorDistance(cell.bounds);
+		if (cell.distance > unloadRadius)
+			UnloadCell(cell);
+	}
+
+	// Load the nearest cells in range first
+	List<u32> candidates;
+	for (const auto& anchor : s_anchors)
+	{
+		const Vec3 extent(s_radius, s_radius, s_radius);
+		s_cellGrid.ForEach(Box3(anchor - extent, anchor + extent),
+			[&](GridMapHandle handle, u32 index)
+			{
+				auto& cell = s_cells[index];
+				if (cell.state != SceneCellState::UNLOADED)
+					return;
+
+				cell.distance = GetAnchorDistance(cell.bounds);
+				if (cell.distance <= s_radius && std::find(candidates.begin(), candidates.end(), index) == candidates.end())
+					candidates.emplace_back(index);
+			});
+	}
+
+	std::sort(candidates.begin(), candidates.end(),
+		[](u32 a, u32 b) { return s_cells[a].distance < s_cells[b].distance; });
+
+	for (u32 index : candidates)
+	{
+		if (s_jobs >= SCENE_STREAMING_MAX_JOBS)
+			break;
+
+		auto& cell = s_cells[index];
+		cell.state = SceneCellState::LOADING;
+		cell.generation = ++s_generation;
+
+		s_jobs++;
+		ResourceManager::QueueJob(std::make_shared<SceneCellLoadJob>(s_session, index, cell.generation, cell.filename));
+	}
+
+	// Spend the budget on the nearest cells that are read
+	List<u32> instantiating;
+	for (u32 i = 0; i < s_cells.size(); ++i)
+	{
+		if (s_cells[i].state == SceneCellState::INSTANTIATING)
+			instantiating.emplace_back(i);
+	}
+
+	std::sort(instantiating.begin(), instantiating.end(),
+		[](u32 a, u32 b) { return s_cells[a].distance < s_cells[b].distance; });
+
+	SizeType budget = s_budget;
+	for (u32 index : instantiating)
+	{
+		if (budget == 0)
+			break;
+
+		auto& cell = s_cells[index];
+		budget -= cell.reader->Instantiate(Scene::GetCurrent(), budget);
+		if (cell.reader->IsFinished())
+		{
+			cell.entities = cell.reader->GetEntities();
+			cell.reader.reset();
+			cell.state = SceneCellState::LOADED;
+			s_loadedCount++;
+		}
+	}
+
+	s_anchors.clear();
+
+	Profiler::SetCounter("Scene Cells", static_cast<f64>(s_loadedCount));
+}
+
+void SceneStreamer::FinishLoad(u32 session, u32 cell, u32 generation, const std::shared_ptr<SceneReader>& reader)
+{
+	// Closed while reading, the job was already dropped from the count
+	if (session != s_session)
+		return;
+
+	BX_ASSERT(s_jobs > 0, "Scene cell job finished that was never counted!");
+	s_jobs--;
+
+	// Unloaded while reading
+	if (cell >= s_cells.size() || s_cells[cell].state != SceneCellState::LOADING || s_cells[cell].generation != generation)
+		return;
+
+	if (reader == nullptr)
+	{
+		// Stays loading so a broken cell isn't read again every frame
+		BX_LOGE("Failed to stream scene cell: {}", s_cells[cell].filename);
+		return;
+	}
+
+	s_cells[cell].reader = reader;
+	s_cells[cell].state = SceneCellState::INSTANTIATING;
+}
\ No newline at end of file
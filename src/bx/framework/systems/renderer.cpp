@@ -7,6 +7,8 @@
 #include "bx/framework/components/animator.hpp"
 #include "bx/framework/components/light.hpp"
 
+#include "bx/framework/resources/texture.hpp"
+
 #include <bx/engine/core/file.hpp>
 #include <bx/engine/core/data.hpp>
 #include <bx/engine/core/profiler.hpp>
@@ -15,6 +17,8 @@
 #include <bx/engine/modules/graphics.hpp>
 #include <bx/engine/modules/window.hpp>
 
+#include <cmath>
+
 struct ViewData
 {
     Mat4 viewMtx = Mat4::Identity();
@@ -66,6 +70,13 @@ struct DrawCommandData
     GraphicsHandle animResources = INVALID_GRAPHICS_HANDLE;
 };
 
+// Camera data for texture streaming, pixelScale is the height in pixels of one unit at unit distance
+struct StreamingView
+{
+    Vec3 position = Vec3(0, 0, 0);
+    f32 pixelScale = 0.0f;
+};
+
 class Renderer::Impl
 {
 public:
@@ -78,6 +89,7 @@ public:
     GraphicsHandle resources = INVALID_GRAPHICS_HANDLE;
 
     List<ViewData> views;
+    List<StreamingView> streamingViews;
     List<LightData> lights;
     List<DrawCommandData> drawCmds;
 };
@@ -86,6 +98,15 @@ void Renderer::Initialize()
 {
     m_impl = new Renderer::Impl();
 
+#ifdef BX_EDITOR_BUILD
+    const bool streamTextures = false;
+#else
+    const bool streamTextures = true;
+#endif
+    TextureStreamer::SetEnabled(Data::GetBool("Texture Streaming", streamTextures, DataTarget::SYSTEM));
+    const i32 streamingBudget = Data::GetInt("Texture Streaming Budget (MB)", 512, DataTarget::SYSTEM);
+    TextureStreamer::SetBudget(static_cast<SizeType>(Math::Max(streamingBudget, 0)) * 1024 * 1024);
+
     BufferInfo info;
 
     info.type = BufferType::UNIFORM_BUFFER;
@@ -124,6 +145,8 @@ void Renderer::Initialize()
 
 void Renderer::Shutdown()
 {
+    TextureStreamer::Shutdown();
+
     Graphics::DestroyBuffer(m_impl->constantBuffer);
     Graphics::DestroyBuffer(m_impl->modelBuffer);
     Graphics::DestroyBuffer(m_impl->lightBuffer);
@@ -162,6 +185,7 @@ void Renderer::UpdateAnimators()
 void Renderer::UpdateCameras()
 {
     m_impl->views.clear();
+    m_impl->streamingViews.clear();
 
     EntityManager::ForEach<Transform, Camera>(
         [&](Entity entity, const Transform& trx, Camera& cam)
@@ -179,6 +203,11 @@ void Renderer::UpdateCameras()
             view.projMtx = cam.GetProjection();
             view.viewProjMtx = cam.GetViewProjection();
             m_impl->views.emplace_back(view);
+
+            StreamingView streamingView;
+            streamingView.position = trx.GetPosition();
+            streamingView.pixelScale = 0.5f * static_cast<f32>(height) * view.projMtx[1][1];
+            m_impl->streamingViews.emplace_back(streamingView);
         });
 }
 
@@ -216,6 +245,34 @@ void Renderer::CollectDrawCommands()
 {
     m_impl->drawCmds.clear();
 
+    const bool isStreaming = TextureStreamer::IsEnabled() && !m_impl->streamingViews.empty();
+
+    // Largest on screen diameter in pixels of the meshes over all views
+    auto getProjectedSize = [&](const Transform& trx, const MeshFilter& mf)
+    {
+        const Mat4& world = trx.GetMatrix();
+        const Vec3 position = Vec3(world[3].x, world[3].y, world[3].z);
+        const f32 scale = Math::Max(Vec3(world[0].x, world[0].y, world[0].z).Magnitude(),
+            Math::Max(Vec3(world[1].x, world[1].y, world[1].z).Magnitude(), Vec3(world[2].x, world[2].y, world[2].z).Magnitude()));
+
+        f32 radius = 0.0f;
+        for (const auto& mesh : mf.GetMeshes())
+        {
+            if (mesh)
+                radius = Math::Max(radius, 0.5f * (mesh->GetBounds().max - mesh->GetBounds().min).Magnitude());
+        }
+        radius *= scale;
+
+        f32 pixels = 0.0f;
+        for (const auto& view : m_impl->streamingViews)
+        {
+            const f32 distance = Math::Max((position - view.position).Magnitude(), radius);
+            if (distance > 0.0f)
+                pixels = Math::Max(pixels, 2.0f * radius * view.pixelScale / distance);
+        }
+        return pixels;
+    };
+
     EntityManager::ForEach<Transform, MeshFilter, MeshRenderer>(
         [&](Entity entity, const Transform& trx, const MeshFilter& mf, const MeshRenderer& mr)
         {
@@ -229,6 +286,8 @@ void Renderer::CollectDrawCommands()
             if (mr.GetMaterialCount() == 0)
                 return;
 
+            const f32 pixels = isStreaming ? getProjectedSize(trx, mf) : 0.0f;
+
             for (const auto& material : mr.GetMaterials())
             {
                 if (!material)
@@ -240,9 +299,19 @@ void Renderer::CollectDrawCommands()
                 for (const auto& entry : materialData.GetTextures())
                 {
                     if (!entry.second)
+                    {
                         Graphics::BindResource(resources, entry.first.c_str(), INVALID_GRAPHICS_HANDLE);
-                    else
-                        Graphics::BindResource(resources, entry.first.c_str(), entry.second->GetTexture());
+                        continue;
+                    }
+
+                    Graphics::BindResource(resources, entry.first.c_str(), entry.second->GetTexture());
+
+                    // Assumes the texture is mapped once across the object
+                    if (isStreaming && pixels > 0.0f)
+                    {
+                        const f32 texels = static_cast<f32>(Math::Max(entry.second->width, entry.second->height));
+                        TextureStreamer::Request(entry.second, std::log2(texels / pixels));
+                    }
                 }
             }
 
@@ -265,14 +334,18 @@ void Renderer::CollectDrawCommands()
 
                 cmd.vbuffers = meshData.GetVertexBuffers();
                 cmd.ibuffer = meshData.GetIndexBuffer();
-                cmd.numIndices = static_cast<u32>(meshData.GetTriangles().size());
-                cmd.pipeline = materialData.GetPipeline();
+                cmd.numIndices = meshData.GetIndexCount();
+                cmd.pipeline = materialData.GetPipeline(meshData.GetLayout());
                 cmd.matResources = materialData.GetResources();
                 cmd.animResources = animResources;
 
                 m_impl->drawCmds.emplace_back(cmd);
             }
         });
+
+    // Runs without a streaming view too, textures nothing requested this frame then go stale and get trimmed
+    if (TextureStreamer::IsEnabled())
+        TextureStreamer::Update();
 }
 
 void Renderer::DrawCommand(const GraphicsHandle pipeline, u32 numResourceBindings, const GraphicsHandle* pResourcesBindings, u32 numBuffers, const GraphicsHandle* pBuffers, const u64* offset, const GraphicsHandle indexBuffer, u32 count)
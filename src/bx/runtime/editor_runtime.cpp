@@ -81,6 +81,7 @@ int Runtime::Launch(int argc, char** argv)
 		Time::Update();
 		Window::PollEvents();
 		Input::Poll();
+		ResourceManager::Update();
 
 		if (Toolbar::IsPlaying() && (Toolbar::ConsumeNextFrame() || !Toolbar::IsPaused()))
 		{
@@ -19,6 +19,7 @@
 #include <bx/engine/modules/imgui.hpp>
 
 #include <bx/framework/gameobject.hpp>
+#include <bx/framework/scene_streamer.hpp>
 
 static bool s_running = true;
 
@@ -42,6 +43,20 @@ void Runtime::Reload()
 	Module::Reload();
 }
 
+// An export older than the scene it was made from is ignored, it would hide the latest edits
+static bool IsExportCurrent(const String& exportFilename, const String& sceneFilename)
+{
+	if (!File::Exists(exportFilename))
+		return false;
+
+	if (File::LastWrite(exportFilename) < File::LastWrite(sceneFilename))
+	{
+		BX_LOGW("Scene export is older than the scene, loading the scene instead: {}", exportFilename);
+		return false;
+	}
+	return true;
+}
+
 int Runtime::Launch(int argc, char** argv)
 {
 	if (!Initialize())
@@ -49,8 +64,19 @@ int Runtime::Launch(int argc, char** argv)
 
 	Window::SetCursorMode(CursorMode::DISABLED);
 
+	// Prefer streaming the cells of the main scene, then its binary export, when they are up to date
 	const String& mainScene = Data::GetString("Main Scene", "[assets]/main.scene", DataTarget::GAME);
-	Scene::Load(mainScene);
+	const String binaryScene = Scene::GetBinaryFilename(mainScene);
+	if (IsExportCurrent(SceneStreamer::GetIndexFilename(mainScene), mainScene))
+	{
+		SceneStreamer::SetRadius(Data::GetFloat("Scene Streaming Radius", SCENE_STREAMING_RADIUS, DataTarget::GAME));
+		SceneStreamer::SetBudget(Data::GetUInt("Scene Streaming Budget", SCENE_STREAMING_BUDGET, DataTarget::GAME));
+		SceneStreamer::Open(mainScene);
+	}
+	else
+	{
+		Scene::Load(IsExportCurrent(binaryScene, mainScene) ? binaryScene : mainScene);
+	}
 
 	while (IsRunning())
 	{
@@ -61,8 +87,10 @@ int Runtime::Launch(int argc, char** argv)
 		Time::Update();
 		Window::PollEvents();
 		Input::Poll();
+		ResourceManager::Update();
 
 		SystemManager::Update();
+		SceneStreamer::Update();
 		Scene::GetCurrent().Update();
 		Script::Update();
 		
@@ -0,0 +1,147 @@
+// Checks GridMap against a brute force scan and reports how much faster it answers neighbor queries.
+// Agents wander a square world, every step they move and query the ones within the radius.
+// Usage: bx_gridmap [agents] [steps]
+
+#include <bx/engine/core/math.hpp>
+#include <bx/engine/containers/grid_map.hpp>
+#include <bx/engine/containers/list.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+static const f32 WORLD_SIZE = 512.0f;
+static const f32 AGENT_SIZE = 0.5f;
+static const f32 AGENT_SPEED = 2.0f;
+static const f32 NEIGHBOR_RADIUS = 4.0f;
+
+static Box3 GetAgentBounds(const Vec3& position)
+{
+	const Vec3 extent(AGENT_SIZE, AGENT_SIZE, AGENT_SIZE);
+	return Box3(position - extent, position + extent);
+}
+
+// Same rule as GridMap::QueryNeighbors, the bounds grown by the radius overlap the other bounds
+static void BruteForceNeighbors(const List<Box3>& bounds, f32 radius, List<u32>& offsets, List<GridMapHandle>& results)
+{
+	offsets.resize(bounds.size() + 1);
+	results.clear();
+
+	const Vec3 extent(radius, radius, radius);
+	for (SizeType i = 0; i < bounds.size(); ++i)
+	{
+		offsets[i] = static_cast<u32>(results.size());
+
+		const Box3 box(bounds[i].min - extent, bounds[i].max + extent);
+		for (SizeType j = 0; j < bounds.size(); ++j)
+		{
+			if (j != i && bounds[j].Overlaps(box))
+				results.emplace_back(static_cast<GridMapHandle>(j));
+		}
+	}
+	offsets[bounds.size()] = static_cast<u32>(results.size());
+}
+
+// The grid reports neighbors in cell order, the scan in index order
+static bool Matches(const List<u32>& offsetsA, List<GridMapHandle>& resultsA, const List<u32>& offsetsB, List<GridMapHandle>& resultsB)
+{
+	if (offsetsA != offsetsB)
+		return false;
+
+	for (SizeType i = 0; i + 1 < offsetsA.size(); ++i)
+	{
+		std::sort(resultsA.begin() + offsetsA[i], resultsA.begin() + offsetsA[i + 1]);
+		std::sort(resultsB.begin() + offsetsB[i], resultsB.begin() + offsetsB[i + 1]);
+	}
+	return resultsA == resultsB;
+}
+
+int main(int argc, char** argv)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	const SizeType agentCount = argc > 1 ? static_cast<SizeType>(std::atoi(argv[1])) : 4000;
+	const u32 steps = argc > 2 ? static_cast<u32>(std::atoi(argv[2])) : 10;
+
+	// Fixed seed, so a failure can be reproduced
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<f32> position(0.0f, WORLD_SIZE);
+	std::uniform_real_distribution<f32> velocity(-AGENT_SPEED, AGENT_SPEED);
+
+	List<Vec3> positions(agentCount);
+	List<Box3> bounds(agentCount);
+	for (SizeType i = 0; i < agentCount; ++i)
+	{
+		positions[i] = Vec3(position(rng), 0.0f, position(rng));
+		bounds[i] = GetAgentBounds(positions[i]);
+	}
+
+	GridMap<u32> grid(NEIGHBOR_RADIUS * 2.0f);
+	List<GridMapHandle> handles(agentCount);
+
+	const auto insertStart = Clock::now();
+	for (SizeType i = 0; i < agentCount; ++i)
+		handles[i] = grid.Insert(static_cast<u32>(i), bounds[i]);
+	const f64 insertSeconds = std::chrono::duration<f64>(Clock::now() - insertStart).count();
+
+	// Handles are handed out in insertion order on an empty map, so they equal the agent index
+	for (SizeType i = 0; i < agentCount; ++i)
+	{
+		if (handles[i] != static_cast<GridMapHandle>(i))
+		{
+			std::printf("Unexpected handle %u for agent %zu\n", handles[i], i);
+			return 1;
+		}
+	}
+
+	f64 moveSeconds = 0.0;
+	f64 gridSeconds = 0.0;
+	f64 bruteSeconds = 0.0;
+	SizeType neighborCount = 0;
+
+	List<u32> gridOffsets;
+	List<GridMapHandle> gridResults;
+	List<u32> bruteOffsets;
+	List<GridMapHandle> bruteResults;
+	for (u32 step = 0; step < steps; ++step)
+	{
+		for (SizeType i = 0; i < agentCount; ++i)
+		{
+			positions[i].x = Math::Clamp(positions[i].x + velocity(rng), 0.0f, WORLD_SIZE);
+			positions[i].z = Math::Clamp(positions[i].z + velocity(rng), 0.0f, WORLD_SIZE);
+			bounds[i] = GetAgentBounds(positions[i]);
+		}
+
+		const auto moveStart = Clock::now();
+		for (SizeType i = 0; i < agentCount; ++i)
+			grid.Move(handles[i], bounds[i]);
+		moveSeconds += std::chrono::duration<f64>(Clock::now() - moveStart).count();
+
+		const auto gridStart = Clock::now();
+		grid.QueryNeighbors(handles, NEIGHBOR_RADIUS, gridOffsets, gridResults);
+		gridSeconds += std::chrono::duration<f64>(Clock::now() - gridStart).count();
+
+		const auto bruteStart = Clock::now();
+		BruteForceNeighbors(bounds, NEIGHBOR_RADIUS, bruteOffsets, bruteResults);
+		bruteSeconds += std::chrono::duration<f64>(Clock::now() - bruteStart).count();
+
+		if (!Matches(gridOffsets, gridResults, bruteOffsets, bruteResults))
+		{
+			std::printf("Neighbors differ from the brute force scan at step %u\n", step);
+			return 1;
+		}
+		neighborCount += gridResults.size();
+	}
+
+	const f64 toMilliseconds = 1000.0 / Math::Max(steps, 1u);
+	std::printf("%zu agents, %u steps, %.1f neighbors per agent\n", agentCount, steps,
+		agentCount > 0 && steps > 0 ? static_cast<f64>(neighborCount) / agentCount / steps : 0.0);
+	std::printf("%-16s %10.3f ms\n", "Insert", insertSeconds * 1000.0);
+	std::printf("%-16s %10.3f ms per step\n", "Move", moveSeconds * toMilliseconds);
+	std::printf("%-16s %10.3f ms per step\n", "QueryNeighbors", gridSeconds * toMilliseconds);
+	std::printf("%-16s %10.3f ms per step\n", "Brute force", bruteSeconds * toMilliseconds);
+	std::printf("%-16s %10.1fx\n", "Speedup", gridSeconds > 0.0 ? bruteSeconds / gridSeconds : 0.0);
+	return 0;
+}
\ No newline at end of file
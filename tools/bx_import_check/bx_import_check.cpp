@@ -0,0 +1,491 @@
+// Checks the editor import stages that run on the CPU against fixed inputs, exits with 1 when one fails.
+// Usage: bx_import_check
+
+#include <bx/editor/core/mesh_optimizer.hpp>
+#include <bx/editor/core/texture_compressor.hpp>
+#include <bx/framework/resources/texture.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+static bool s_failed = false;
+
+static void Check(bool condition, const char* what)
+{
+	std::printf("  %-56s %s\n", what, condition ? "ok" : "FAILED");
+	if (!condition)
+		s_failed = true;
+}
+
+// A triangle rotated so its smallest index comes first, the winding is kept
+struct Triangle
+{
+	u32 v[3];
+
+	inline bool operator<(const Triangle& other) const
+	{
+		return std::lexicographical_compare(v, v + 3, other.v, other.v + 3);
+	}
+
+	inline bool operator==(const Triangle& other) const
+	{
+		return v[0] == other.v[0] && v[1] == other.v[1] && v[2] == other.v[2];
+	}
+};
+
+static List<Triangle> GetSortedTriangles(const List<u32>& indices)
+{
+	List<Triangle> triangles(indices.size() / 3);
+	for (SizeType t = 0; t < triangles.size(); ++t)
+	{
+		const u32* pTri = &indices[t * 3];
+		const u32 first = pTri[0] <= pTri[1] && pTri[0] <= pTri[2] ? 0 : (pTri[1] <= pTri[2] ? 1 : 2);
+		for (u32 k = 0; k < 3; ++k)
+			triangles[t].v[k] = pTri[(first + k) % 3];
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// Two triangles per quad of a size x size grid in the XZ plane, in shuffled order like an unoptimized import
+static void MakeGridMesh(u32 size, List<u32>& indices, List<Vec3>& positions)
+{
+	const u32 side = size + 1;
+	positions.clear();
+	for (u32 z = 0; z < side; ++z)
+		for (u32 x = 0; x < side; ++x)
+			positions.emplace_back(static_cast<f32>(x), 0.0f, static_cast<f32>(z));
+
+	List<u32> quads;
+	for (u32 z = 0; z < size; ++z)
+		for (u32 x = 0; x < size; ++x)
+			quads.emplace_back(z * side + x);
+
+	std::mt19937 rng(1234);
+	std::shuffle(quads.begin(), quads.end(), rng);
+
+	indices.clear();
+	for (u32 v : quads)
+	{
+		const u32 quad[6] = { v, v + side, v + 1, v + 1, v + side, v + side + 1 };
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+}
+
+static void CheckMeshOptimizer()
+{
+	const u32 gridSize = 64;
+	std::printf("Mesh optimizer (%ux%u grid, cache of %u)\n", gridSize, gridSize, MESH_OPTIMIZER_CACHE_SIZE);
+
+	List<u32> indices;
+	List<Vec3> positions;
+	MakeGridMesh(gridSize, indices, positions);
+	const u32 vertexCount = static_cast<u32>(positions.size());
+	const List<Triangle> original = GetSortedTriangles(indices);
+
+	const MeshCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+	List<u32> clusters;
+	MeshOptimizer::OptimizeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE, clusters);
+	const MeshCacheStats cached = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+	MeshOptimizer::OptimizeOverdraw(indices, positions, clusters, MESH_OPTIMIZER_CACHE_SIZE, 1.05f);
+	const MeshCacheStats overdraw = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+	const bool isSameAfterCache = GetSortedTriangles(indices) == original;
+
+	List<u32> remap;
+	const u32 newCount = MeshOptimizer::OptimizeVertexFetch(indices, vertexCount, remap);
+	const MeshCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, newCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+	std::printf("  ACMR %.3f -> %.3f (%.3f after overdraw, %zu clusters)\n", before.acmr, after.acmr, overdraw.acmr, clusters.size());
+	std::printf("  ATVR %.3f -> %.3f\n", before.atvr, after.atvr);
+
+	Check(isSameAfterCache, "reordering keeps every triangle and its winding");
+	Check(cached.acmr < before.acmr * 0.5f, "vertex cache order halves ACMR at least");
+	Check(after.acmr <= 0.75f, "ACMR within 0.75 (0.5 is the ideal)");
+	Check(after.atvr <= 1.5f, "ATVR within 1.5 (1.0 is the ideal)");
+	Check(overdraw.acmr <= cached.acmr * 1.05f + 1e-4f, "overdraw order keeps ACMR within its threshold");
+	Check(after.acmr == overdraw.acmr, "vertex fetch order leaves ACMR as is");
+
+	// Fetch order numbers vertices by first use, so each new index is one past the highest so far
+	bool isFirstUseOrder = true;
+	u32 next = 0;
+	for (u32 v : indices)
+	{
+		if (v == next)
+			next++;
+		else if (v > next)
+			isFirstUseOrder = false;
+	}
+	Check(newCount == vertexCount && next == newCount, "vertex fetch order keeps every used vertex");
+	Check(isFirstUseOrder, "vertices are numbered in order of first use");
+
+	List<u32> inverse(newCount);
+	for (u32 v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] != MESH_OPTIMIZER_UNUSED)
+			inverse[remap[v]] = v;
+	}
+	for (auto& v : indices)
+		v = inverse[v];
+	Check(GetSortedTriangles(indices) == original, "remapped triangles match the original mesh");
+}
+
+// Reference decoders, written from the format specifications rather than the encoder, rows of RGBA8 texels out
+
+static void DecodeRgb565(u16 packed, i32 color[3])
+{
+	const i32 r = (packed >> 11) & 31;
+	const i32 g = (packed >> 5) & 63;
+	const i32 b = packed & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+static void DecodeColorBlock(const u8* pSrc, u8* pBlock, bool hasPunchThrough)
+{
+	const u16 c0 = static_cast<u16>(pSrc[0] | (pSrc[1] << 8));
+	const u16 c1 = static_cast<u16>(pSrc[2] | (pSrc[3] << 8));
+
+	i32 palette[4][4];
+	DecodeRgb565(c0, palette[0]);
+	DecodeRgb565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+	const bool isFourColor = c0 > c1 || !hasPunchThrough;
+	for (u32 c = 0; c < 3; ++c)
+	{
+		if (isFourColor)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	if (!isFourColor)
+		palette[3][3] = 0;
+
+	const u32 bits = pSrc[4] | (pSrc[5] << 8) | (pSrc[6] << 16) | (static_cast<u32>(pSrc[7]) << 24);
+	for (u32 i = 0; i < 16; ++i)
+	{
+		const u32 index = (bits >> (2 * i)) & 3;
+		for (u32 c = 0; c < 4; ++c)
+			pBlock[i * 4 + c] = static_cast<u8>(palette[index][c]);
+	}
+}
+
+static void DecodeChannelBlock(const u8* pSrc, u8* pBlock, u32 channel)
+{
+	const i32 v0 = pSrc[0];
+	const i32 v1 = pSrc[1];
+
+	i32 palette[8] = { v0, v1 };
+	if (v0 > v1)
+	{
+		for (i32 k = 2; k < 8; ++k)
+			palette[k] = ((8 - k) * v0 + (k - 1) * v1) / 7;
+	}
+	else
+	{
+		for (i32 k = 2; k < 6; ++k)
+			palette[k] = ((6 - k) * v0 + (k - 1) * v1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	u64 bits = 0;
+	for (u32 b = 0; b < 6; ++b)
+		bits |= static_cast<u64>(pSrc[2 + b]) << (8 * b);
+	for (u32 i = 0; i < 16; ++i)
+		pBlock[i * 4 + channel] = static_cast<u8>(palette[(bits >> (3 * i)) & 7]);
+}
+
+static u32 ReadBits(const u8* pSrc, u32& bit, u32 count)
+{
+	u32 value = 0;
+	for (u32 b = 0; b < count; ++b, ++bit)
+		value |= ((pSrc[bit >> 3] >> (bit & 7)) & 1u) << b;
+	return value;
+}
+
+// Only mode 6 (the one the encoder writes), other modes fail the check
+static bool DecodeBC7Block(const u8* pSrc, u8* pBlock)
+{
+	static const i32 s_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	u32 bit = 0;
+	if (ReadBits(pSrc, bit, 7) != (1u << 6))
+		return false;
+
+	u32 endpoints[2][4];
+	for (u32 c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = ReadBits(pSrc, bit, 7);
+		endpoints[1][c] = ReadBits(pSrc, bit, 7);
+	}
+	const u32 p0 = ReadBits(pSrc, bit, 1);
+	const u32 p1 = ReadBits(pSrc, bit, 1);
+
+	for (u32 i = 0; i < 16; ++i)
+	{
+		const i32 w = s_weights[ReadBits(pSrc, bit, i == 0 ? 3 : 4)];
+		for (u32 c = 0; c < 4; ++c)
+		{
+			const i32 a = static_cast<i32>((endpoints[0][c] << 1) | p0);
+			const i32 b = static_cast<i32>((endpoints[1][c] << 1) | p1);
+			pBlock[i * 4 + c] = static_cast<u8>(((64 - w) * a + w * b + 32) >> 6);
+		}
+	}
+	return true;
+}
+
+static bool DecodeBlock(TextureFormat format, const u8* pSrc, u8* pBlock)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1_UNORM:
+		DecodeColorBlock(pSrc, pBlock, true);
+		return true;
+	case TextureFormat::BC3_UNORM:
+		DecodeColorBlock(pSrc + 8, pBlock, false);
+		DecodeChannelBlock(pSrc, pBlock, 3);
+		return true;
+	case TextureFormat::BC5_UNORM:
+		DecodeChannelBlock(pSrc, pBlock, 0);
+		DecodeChannelBlock(pSrc + 8, pBlock, 1);
+		return true;
+	case TextureFormat::BC7_UNORM:
+		return DecodeBC7Block(pSrc, pBlock);
+	default:
+		return false;
+	}
+}
+
+// Channels that a format stores, BC1 is opaque and BC5 only has red and green
+static u32 GetChannelMask(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1_UNORM: return 0x7;
+	case TextureFormat::BC5_UNORM: return 0x3;
+	default: return 0xF;
+	}
+}
+
+struct CodecError
+{
+	f64 rmse = 0.0;
+	i32 maxError = 0;
+	bool isDecoded = true;
+};
+
+// Decodes every level of an encoded copy and compares it with the RGBA8 source levels
+static CodecError MeasureError(const Texture& source, const Texture& encoded)
+{
+	CodecError error;
+	const u32 width = static_cast<u32>(source.width);
+	const u32 height = static_cast<u32>(source.height);
+	const u32 mask = GetChannelMask(encoded.format);
+	const u32 blockBytes = GetTextureFormatSize(encoded.format);
+
+	f64 sum = 0.0;
+	SizeType count = 0;
+	const u8* pLevel = source.pixels.data();
+	const u8* pBlocks = encoded.pixels.data();
+
+	u8 block[16 * 4];
+	for (u32 level = 0; level < static_cast<u32>(source.mipCount); ++level)
+	{
+		const u32 levelWidth = GetTextureLevelExtent(width, level);
+		const u32 levelHeight = GetTextureLevelExtent(height, level);
+		for (u32 by = 0; by < levelHeight; by += 4)
+		{
+			for (u32 bx = 0; bx < levelWidth; bx += 4)
+			{
+				if (!DecodeBlock(encoded.format, pBlocks, block))
+					error.isDecoded = false;
+				pBlocks += blockBytes;
+
+				// Texels of partial blocks past the edge are padding
+				for (u32 y = 0; y < 4 && by + y < levelHeight; ++y)
+				{
+					for (u32 x = 0; x < 4 && bx + x < levelWidth; ++x)
+					{
+						const u8* pSrc = pLevel + ((by + y) * levelWidth + bx + x) * 4;
+						const u8* pDec = block + (y * 4 + x) * 4;
+						for (u32 c = 0; c < 4; ++c)
+						{
+							if ((mask & (1u << c)) == 0)
+								continue;
+
+							const i32 d = std::abs(static_cast<i32>(pSrc[c]) - static_cast<i32>(pDec[c]));
+							error.maxError = std::max(error.maxError, d);
+							sum += static_cast<f64>(d) * d;
+							count++;
+						}
+					}
+				}
+			}
+		}
+		pLevel += GetTextureLevelSize(TextureFormat::RGBA8_UNORM, width, height, level);
+	}
+
+	error.rmse = count > 0 ? std::sqrt(sum / count) : 0.0;
+	return error;
+}
+
+static Texture MakeTexture(u32 width, u32 height)
+{
+	Texture texture;
+	texture.channels = 4;
+	texture.width = static_cast<i32>(width);
+	texture.height = static_cast<i32>(height);
+	texture.depth = 1;
+	texture.pixels.resize(static_cast<SizeType>(width) * height * 4);
+	return texture;
+}
+
+// Smooth color and alpha with mild noise, close to what photographs and painted textures look like
+static Texture MakeGradientTexture(u32 size)
+{
+	Texture texture = MakeTexture(size, size);
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<i32> noise(-2, 2);
+	for (u32 y = 0; y < size; ++y)
+	{
+		for (u32 x = 0; x < size; ++x)
+		{
+			u8* pTexel = &texture.pixels[(y * size + x) * 4];
+			const f32 u = static_cast<f32>(x) / (size - 1);
+			const f32 v = static_cast<f32>(y) / (size - 1);
+			const f32 channels[4] = { u, v, 0.5f + 0.5f * std::sin(6.0f * (u + v)), 1.0f - 0.5f * u * v };
+			for (u32 c = 0; c < 4; ++c)
+				pTexel[c] = static_cast<u8>(std::min(std::max(static_cast<i32>(channels[c] * 255.0f) + noise(rng), 0), 255));
+		}
+	}
+	return texture;
+}
+
+static void CheckTextureCompressor()
+{
+	std::printf("Texture compressor\n");
+
+	// Full chains down to 1x1, non power of two and non square sizes included
+	struct MipCase
+	{
+		u32 width;
+		u32 height;
+		u32 levels;
+	};
+	const MipCase mipCases[] = { { 64, 64, 7 }, { 40, 24, 6 }, { 256, 4, 9 }, { 1, 1, 1 } };
+	for (const auto& mipCase : mipCases)
+	{
+		Texture texture = MakeTexture(mipCase.width, mipCase.height);
+		for (SizeType i = 0; i < texture.pixels.size(); i += 4)
+		{
+			texture.pixels[i + 0] = 200;
+			texture.pixels[i + 1] = 100;
+			texture.pixels[i + 2] = 50;
+			texture.pixels[i + 3] = 255;
+		}
+
+		const u32 levels = TextureCompressor::GenerateMips(texture, false);
+
+		SizeType expectedSize = 0;
+		for (u32 level = 0; level < mipCase.levels; ++level)
+			expectedSize += static_cast<SizeType>(std::max(mipCase.width >> level, 1u)) * std::max(mipCase.height >> level, 1u) * 4;
+
+		// A flat color filters to itself on every level
+		bool isFlat = true;
+		for (SizeType i = 0; i < texture.pixels.size(); i += 4)
+		{
+			isFlat &= std::abs(texture.pixels[i + 0] - 200) <= 1 && std::abs(texture.pixels[i + 1] - 100) <= 1
+				&& std::abs(texture.pixels[i + 2] - 50) <= 1 && texture.pixels[i + 3] == 255;
+		}
+
+		char what[64];
+		std::snprintf(what, sizeof(what), "%ux%u mips: %u levels, %zu bytes", mipCase.width, mipCase.height, levels, texture.pixels.size());
+		Check(levels == mipCase.levels && texture.mipCount == static_cast<i32>(levels) && texture.pixels.size() == expectedSize && isFlat, what);
+	}
+
+	// Encode to reference decode, RMSE and the largest error over the channels each format keeps
+	struct CodecCase
+	{
+		TextureFormat format;
+		const char* name;
+		f64 maxRmse;
+	};
+	const CodecCase codecCases[] =
+	{
+		{ TextureFormat::BC1_UNORM, "BC1", 5.0 },
+		{ TextureFormat::BC3_UNORM, "BC3", 4.5 },
+		{ TextureFormat::BC5_UNORM, "BC5", 1.5 },
+		{ TextureFormat::BC7_UNORM, "BC7", 3.5 },
+	};
+
+	const Texture source = MakeGradientTexture(64);
+	for (const auto& codecCase : codecCases)
+	{
+		Texture encoded = source;
+		const bool isEncoded = TextureCompressor::Encode(encoded, codecCase.format);
+		const CodecError error = MeasureError(source, encoded);
+
+		char what[64];
+		std::snprintf(what, sizeof(what), "%s: RMSE %.2f (max %.2f), largest error %d", codecCase.name, error.rmse, codecCase.maxRmse, error.maxError);
+		Check(isEncoded && error.isDecoded && error.rmse <= codecCase.maxRmse, what);
+	}
+
+	// Whole chains, the small levels are a few texels of steep gradient so only their layout is checked
+	Texture chain = source;
+	TextureCompressor::GenerateMips(chain, false);
+	for (const auto& codecCase : codecCases)
+	{
+		Texture encoded = chain;
+		const bool isEncoded = TextureCompressor::Encode(encoded, codecCase.format);
+		const bool isSized = encoded.pixels.size() == GetTextureSize(codecCase.format, 64, 64, static_cast<u32>(chain.mipCount));
+		const CodecError error = MeasureError(chain, encoded);
+
+		char what[64];
+		std::snprintf(what, sizeof(what), "%s: %d levels encode to %zu bytes", codecCase.name, encoded.mipCount, encoded.pixels.size());
+		Check(isEncoded && isSized && error.isDecoded, what);
+	}
+
+	// A single color only loses what the endpoint precision can't hold
+	Texture flat = MakeTexture(4, 4);
+	for (SizeType i = 0; i < flat.pixels.size(); i += 4)
+	{
+		flat.pixels[i + 0] = 37;
+		flat.pixels[i + 1] = 180;
+		flat.pixels[i + 2] = 99;
+		flat.pixels[i + 3] = 128;
+	}
+	const i32 flatBounds[] = { 4, 4, 0, 1 };
+	for (SizeType i = 0; i < 4; ++i)
+	{
+		Texture encoded = flat;
+		TextureCompressor::Encode(encoded, codecCases[i].format);
+		const CodecError error = MeasureError(flat, encoded);
+
+		char what[64];
+		std::snprintf(what, sizeof(what), "%s: flat block within %d", codecCases[i].name, flatBounds[i]);
+		Check(error.isDecoded && error.maxError <= flatBounds[i], what);
+	}
+}
+
+int main()
+{
+	CheckMeshOptimizer();
+	CheckTextureCompressor();
+
+	std::printf(s_failed ? "Import checks failed\n" : "Import checks passed\n");
+	return s_failed ? 1 : 0;
+}
\ No newline at end of file
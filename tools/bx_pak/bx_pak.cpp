@@ -0,0 +1,160 @@
+// Packs a directory into a pak archive that shipped builds mount at [assets].
+// Usage: bx_pak <input directory> <output pak> [--compress]
+//        bx_pak --benchmark <input directory>
+
+#include <bx/engine/core/file.hpp>
+#include <bx/engine/core/pak.hpp>
+#include <bx/engine/core/compression.hpp>
+#include <bx/engine/containers/hash_map.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static void CollectFiles(const String& root, const String& prefix, List<String>& names)
+{
+	List<FileHandle> files;
+	if (!File::ListFiles(root, files))
+		return;
+
+	for (const auto& file : files)
+	{
+		const String name = prefix.empty() ? file.filename : prefix + "/" + file.filename;
+		if (file.isDirectory)
+			CollectFiles(file.filepath, name, names);
+		else
+			names.emplace_back(name);
+	}
+}
+
+struct BenchmarkStats
+{
+	SizeType files = 0;
+	SizeType size = 0;
+	SizeType compressedSize = 0;
+	f64 compressSeconds = 0.0;
+	f64 decompressSeconds = 0.0;
+};
+
+static void PrintStats(const String& name, const BenchmarkStats& stats)
+{
+	std::printf("%-12s %6zu %10.2f %7.3f %12.1f %12.2f\n", name.c_str(), stats.files,
+		stats.size / (1024.0 * 1024.0),
+		stats.size > 0 ? static_cast<f64>(stats.compressedSize) / stats.size : 1.0,
+		stats.compressSeconds > 0.0 ? stats.size / stats.compressSeconds / 1e6 : 0.0,
+		stats.decompressSeconds > 0.0 ? stats.size / stats.decompressSeconds / 1e9 : 0.0);
+}
+
+// Reports the compression ratio and throughput of the codec per file extension
+static int Benchmark(const String& root)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	List<String> names;
+	CollectFiles(root, "", names);
+
+	HashMap<String, BenchmarkStats> extensions;
+	BenchmarkStats total;
+
+	List<u8> compressed;
+	List<u8> decompressed;
+	for (const auto& name : names)
+	{
+		MappedFile file(root + "/" + name);
+		if (!file.IsOpen())
+			continue;
+
+		compressed.resize(Compression::GetMaxCompressedSize(file.GetSize()));
+		decompressed.resize(file.GetSize());
+
+		const auto compressStart = Clock::now();
+		const SizeType compressedSize = Compression::Compress(file.GetData(), file.GetSize(), compressed.data(), compressed.size());
+		const f64 compressSeconds = std::chrono::duration<f64>(Clock::now() - compressStart).count();
+
+		// Small files decode too fast to time once
+		u32 runs = 0;
+		const auto decompressStart = Clock::now();
+		do
+		{
+			if (!Compression::Decompress(compressed.data(), compressedSize, decompressed.data(), decompressed.size()))
+			{
+				std::printf("Round trip failed for %s\n", name.c_str());
+				return 1;
+			}
+			runs++;
+		} while (runs < 1000 && std::chrono::duration<f64>(Clock::now() - decompressStart).count() < 0.01);
+		const f64 decompressSeconds = std::chrono::duration<f64>(Clock::now() - decompressStart).count() / runs;
+
+		if (std::memcmp(decompressed.data(), file.GetData(), file.GetSize()) != 0)
+		{
+			std::printf("Round trip failed for %s\n", name.c_str());
+			return 1;
+		}
+
+		const SizeType split = name.find_last_of("./");
+		const String ext = split != String::npos && name[split] == '.' ? name.substr(split) : "(none)";
+		for (auto* pStats : { &extensions[ext], &total })
+		{
+			pStats->files++;
+			pStats->size += file.GetSize();
+			pStats->compressedSize += compressedSize;
+			pStats->compressSeconds += compressSeconds;
+			pStats->decompressSeconds += decompressSeconds;
+		}
+	}
+
+	std::printf("%-12s %6s %10s %7s %12s %12s\n", "Extension", "Files", "MB", "Ratio", "Comp MB/s", "Decomp GB/s");
+
+	List<String> sorted;
+	for (const auto& it : extensions)
+		sorted.emplace_back(it.first);
+	std::sort(sorted.begin(), sorted.end());
+
+	for (const auto& ext : sorted)
+		PrintStats(ext, extensions[ext]);
+	PrintStats("Total", total);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 3 && std::strcmp(argv[1], "--benchmark") == 0)
+		return Benchmark(argv[2]);
+
+	if (argc < 3)
+	{
+		std::printf("Usage: bx_pak <input directory> <output pak> [--compress]\n");
+		std::printf("       bx_pak --benchmark <input directory>\n");
+		return 1;
+	}
+
+	const String root = argv[1];
+	const String output = argv[2];
+	const bool compress = argc > 3 && std::strcmp(argv[3], "--compress") == 0;
+
+	List<String> names;
+	CollectFiles(root, "", names);
+
+	// Sorted so the same input always produces the same archive
+	std::sort(names.begin(), names.end());
+
+	PakBuilder builder;
+	for (const auto& name : names)
+	{
+		const String filename = root + "/" + name;
+		if (filename == output)
+			continue;
+
+		builder.AddFile(name, filename, compress);
+	}
+
+	if (!builder.Write(output))
+	{
+		std::printf("Failed to write %s\n", output.c_str());
+		return 1;
+	}
+
+	std::printf("Packed %zu files into %s\n", builder.GetFileCount(), output.c_str());
+	return 0;
+}
\ No newline at end of file